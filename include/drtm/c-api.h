@@ -30,6 +30,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -42,6 +44,105 @@ extern "C"
   typedef uint32_t drtm_thread_id_t;
   typedef uint32_t drtm_target_addr_t;
 
+  // --------------------------------------------------------------------------
+  // The handle based API; each session has its own context, and
+  // the functions of a session are called with its user data.
+
+  typedef struct drtm_ops_s
+  {
+    // Passed as the first argument to all functions.
+    void* user_data;
+
+    drtm_target_addr_t
+    (*get_symbol_address) (void* user_data, const char* name);
+
+    int
+    (*read_byte_array) (void* user_data, drtm_target_addr_t addr,
+                        uint8_t* out_array, size_t bytes);
+
+    int
+    (*write_byte_array) (void* user_data, drtm_target_addr_t addr,
+                         const uint8_t* array, size_t bytes);
+
+    int
+    (*voutput) (void* user_data, const char* fmt, va_list args);
+
+    int
+    (*voutput_warning) (void* user_data, const char* fmt, va_list args);
+
+    int
+    (*voutput_error) (void* user_data, const char* fmt, va_list args);
+
+    // Optional, if NULL the target is little endian.
+    bool
+    (*is_target_little_endian) (void* user_data);
+
+    // Optional, if NULL malloc()/free() are used.
+    void*
+    (*malloc) (void* user_data, size_t bytes);
+
+    void
+    (*free) (void* user_data, void* p);
+
+    // Optional, if NULL the inconsistent updates are retried
+    // without delay.
+    void
+    (*delay_us) (void* user_data, uint32_t us);
+  } drtm_ops_t;
+
+  typedef struct drtm_context_s drtm_context_t;
+
+  // The ops structure must be valid until the context is destroyed.
+  drtm_context_t*
+  drtm_create (const drtm_ops_t* ops);
+
+  void
+  drtm_destroy (drtm_context_t* ctx);
+
+  int
+  drtm_ctx_update_thread_list (drtm_context_t* ctx);
+
+  size_t
+  drtm_ctx_get_threads_count (drtm_context_t* ctx);
+
+  drtm_thread_id_t
+  drtm_ctx_get_thread_id (drtm_context_t* ctx, size_t index);
+
+  drtm_thread_id_t
+  drtm_ctx_get_current_thread_id (drtm_context_t* ctx);
+
+  size_t
+  drtm_ctx_get_cores_count (drtm_context_t* ctx);
+
+  drtm_thread_id_t
+  drtm_ctx_get_core_current_thread_id (drtm_context_t* ctx, size_t core);
+
+  size_t
+  drtm_ctx_get_thread_description (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                   char* out_description,
+                                   size_t out_size_bytes);
+
+  int
+  drtm_ctx_get_thread_register (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                size_t reg_index, char* out_hex_value,
+                                size_t out_size_bytes);
+
+  int
+  drtm_ctx_get_thread_registers (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                 char* out_hex_values, size_t out_size_bytes);
+
+  int
+  drtm_ctx_set_thread_register (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                size_t reg_index, const char* hex_value);
+
+  int
+  drtm_ctx_set_thread_registers (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                 const char* hex_values);
+
+  // --------------------------------------------------------------------------
+  // The global API, using a default context, built on the
+  // <your application> functions.
+
   int
   drtm_init (void);
 
@@ -60,6 +161,12 @@ extern "C"
   drtm_thread_id_t
   drtm_get_current_thread_id (void);
 
+  size_t
+  drtm_get_cores_count (void);
+
+  drtm_thread_id_t
+  drtm_get_core_current_thread_id (size_t core);
+
   size_t
   drtm_get_thread_description (drtm_thread_id_t tid, char* out_description,
                                size_t out_size_bytes);
@@ -0,0 +1,395 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_DRIVER_H_
+#define DRTM_DRIVER_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cassert>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief A class template to update many independent sessions
+   * (like the boards of a test rack) in parallel.
+   *
+   * @details
+   * The updates run on a pool of host threads; each worker has
+   * its own queue of sessions, and, when it is empty, steals from
+   * the other workers, so a batch completes in about the time of
+   * the slowest session, not in the sum of all.
+   *
+   * Each session must have its own frontend and backend; a session
+   * is updated by one worker at a time.
+   *
+   * @tparam Fe The frontend type.
+   */
+  template<typename Fe>
+    class driver
+    {
+    public:
+
+      using frontend_type = Fe;
+      using allocator_type = typename frontend_type::allocator_type;
+
+      using duration_type = std::chrono::steady_clock::duration;
+
+      /**
+       * @brief The result of the update of a session.
+       */
+      struct result_s
+      {
+        // The value returned by `update_thread_list()`.
+        int status;
+        // The time spent in `update_thread_list()`.
+        duration_type latency;
+        // The index of the worker that did the update.
+        std::size_t worker;
+      };
+
+      using result_type = struct result_s;
+
+    public:
+
+      /**
+       * @brief Construct the driver and start the workers.
+       *
+       * @param workers The number of host threads; 0 uses the
+       *  number of hardware threads.
+       * @param allocator The allocator for the queues.
+       */
+      driver (std::size_t workers, allocator_type& allocator) :
+          allocator_ (allocator) // Parenthesis used to compile with 4.8
+      {
+        if (workers == 0)
+          {
+            workers = std::thread::hardware_concurrency ();
+            if (workers == 0)
+              {
+                workers = 1;
+              }
+          }
+
+#if defined(DEBUG)
+        printf ("%s(%zu, %p) @%p\n", __func__, workers, &allocator, this);
+#endif /* defined(DEBUG) */
+
+        queues_.reserve (workers);
+        for (std::size_t i = 0; i < workers; ++i)
+          {
+            auto* q = std::allocator_traits<queue_allocator_type>::allocate (
+                reinterpret_cast<queue_allocator_type&> (allocator_), 1);
+
+            // Call the constructor.
+            new (q) queue_type (allocator_);
+            queues_.push_back (q);
+          }
+
+        threads_.reserve (workers);
+        for (std::size_t i = 0; i < workers; ++i)
+          {
+            threads_.emplace_back (&driver::run, this, i);
+          }
+      }
+
+      // The rule of five.
+      driver (const driver&) = delete;
+      driver (driver&&) = delete;
+      driver&
+      operator= (const driver&) = delete;
+      driver&
+      operator= (driver&&) = delete;
+
+      /**
+       * @brief Stop the workers and destruct the driver.
+       */
+      ~driver ()
+      {
+#if defined(DEBUG)
+        printf ("%s() @%p\n", __func__, this);
+#endif /* defined(DEBUG) */
+
+        {
+          std::lock_guard<std::mutex> lock
+            { mutex_ };
+          is_stopping_ = true;
+        }
+        work_cv_.notify_all ();
+
+        for (auto& th : threads_)
+          {
+            th.join ();
+          }
+
+        for (auto* q : queues_)
+          {
+            // Call the destructor.
+            q->~queue_type ();
+
+            std::allocator_traits<queue_allocator_type>::deallocate (
+                reinterpret_cast<queue_allocator_type&> (allocator_), q, 1);
+          }
+      }
+
+    public:
+
+      /**
+       * @brief Update all sessions and wait for all of them
+       * to complete.
+       *
+       * @details
+       * Must be called from one host thread at a time.
+       *
+       * @param [in] sessions Array of pointers to the frontends.
+       * @param [in] count The number of sessions.
+       * @param [out] results Array of results, one for each session;
+       *  may be nullptr.
+       * @return The time of the whole batch.
+       */
+      duration_type
+      update (frontend_type* const sessions[], std::size_t count,
+              result_type results[])
+      {
+        auto begin = std::chrono::steady_clock::now ();
+
+        if (count == 0)
+          {
+            return duration_type
+              { 0 };
+          }
+
+        sessions_ = sessions;
+        results_ = results;
+        remaining_.store (count);
+
+        // Spread the sessions evenly; the workers steal from each
+        // other when the latencies differ.
+        for (std::size_t i = 0; i < count; ++i)
+          {
+            queue_type& q = *queues_[i % queues_.size ()];
+            std::lock_guard<std::mutex> lock
+              { q.mutex };
+            q.tasks.push_back (i);
+          }
+
+        {
+          std::lock_guard<std::mutex> lock
+            { mutex_ };
+          ++generation_;
+        }
+        work_cv_.notify_all ();
+
+        {
+          std::unique_lock<std::mutex> lock
+            { mutex_ };
+          done_cv_.wait (lock, [this]
+            { return remaining_.load () == 0;});
+        }
+
+        return std::chrono::steady_clock::now () - begin;
+      }
+
+      /**
+       * @brief Get the number of workers.
+       */
+      inline std::size_t
+      workers_count (void)
+      {
+        return threads_.size ();
+      }
+
+      /**
+       * @brief Get the number of sessions taken from the queue
+       * of another worker, since construction.
+       */
+      inline std::size_t
+      steals_count (void)
+      {
+        return steals_count_.load (std::memory_order_relaxed);
+      }
+
+    private:
+
+      using index_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<std::size_t>;
+
+      /**
+       * @brief A worker queue of session indices.
+       */
+      struct queue_s
+      {
+        queue_s (allocator_type& allocator) :
+            tasks
+              { reinterpret_cast<index_allocator_type&> (allocator) }
+        {
+        }
+
+        std::mutex mutex;
+        std::deque<std::size_t, index_allocator_type> tasks;
+      };
+
+      using queue_type = struct queue_s;
+
+      using queue_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<queue_type>;
+
+      using queue_pointer_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<queue_type*>;
+
+      using thread_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<std::thread>;
+
+      /**
+       * @brief Take a session; first from the own queue, newest
+       * first, then from the other queues, oldest first.
+       */
+      bool
+      take (std::size_t worker, std::size_t* task)
+      {
+        {
+          queue_type& q = *queues_[worker];
+          std::lock_guard<std::mutex> lock
+            { q.mutex };
+          if (!q.tasks.empty ())
+            {
+              *task = q.tasks.back ();
+              q.tasks.pop_back ();
+              return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < queues_.size (); ++i)
+          {
+            queue_type& q = *queues_[(worker + i) % queues_.size ()];
+            std::lock_guard<std::mutex> lock
+              { q.mutex };
+            if (!q.tasks.empty ())
+              {
+                *task = q.tasks.front ();
+                q.tasks.pop_front ();
+                steals_count_.fetch_add (1, std::memory_order_relaxed);
+                return true;
+              }
+          }
+
+        return false;
+      }
+
+      /**
+       * @brief The worker loop.
+       */
+      void
+      run (std::size_t worker)
+      {
+        uint64_t generation = 0;
+        for (;;)
+          {
+            {
+              std::unique_lock<std::mutex> lock
+                { mutex_ };
+              work_cv_.wait (lock, [this, generation]
+                { return is_stopping_ || generation_ != generation;});
+              if (is_stopping_)
+                {
+                  return;
+                }
+              generation = generation_;
+            }
+
+            std::size_t task;
+            while (take (worker, &task))
+              {
+                auto begin = std::chrono::steady_clock::now ();
+                int status = sessions_[task]->update_thread_list ();
+                auto latency = std::chrono::steady_clock::now () - begin;
+
+                if (results_ != nullptr)
+                  {
+                    results_[task].status = status;
+                    results_[task].latency = latency;
+                    results_[task].worker = worker;
+                  }
+
+                if (remaining_.fetch_sub (1) == 1)
+                  {
+                    // The last session of the batch.
+                    std::lock_guard<std::mutex> lock
+                      { mutex_ };
+                    done_cv_.notify_one ();
+                  }
+              }
+          }
+      }
+
+    private:
+
+      allocator_type& allocator_;
+
+      // Separately allocated, since they include a mutex.
+      std::vector<queue_type*, queue_pointer_allocator_type> queues_
+        { reinterpret_cast<queue_pointer_allocator_type&> (allocator_) };
+      std::vector<std::thread, thread_allocator_type> threads_
+        { reinterpret_cast<thread_allocator_type&> (allocator_) };
+
+      frontend_type* const * sessions_ = nullptr;
+      result_type* results_ = nullptr;
+      std::atomic<std::size_t> remaining_
+        { 0 };
+
+      std::atomic<std::size_t> steals_count_
+        { 0 };
+
+      std::mutex mutex_;
+      std::condition_variable work_cv_;
+      std::condition_variable done_cv_;
+      uint64_t generation_ = 0;
+      bool is_stopping_ = false;
+    };
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_DRIVER_H_ */
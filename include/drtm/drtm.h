@@ -33,9 +33,13 @@
 #include <drtm/version.h>
 
 #include <drtm/types.h>
+#include <drtm/sink.h>
+#include <drtm/frames.h>
 #include <drtm/frontend.h>
 #include <drtm/metadata.h>
+#include <drtm/static-metadata.h>
 #include <drtm/run-time-data.h>
+#include <drtm/snapshot.h>
 #include <drtm/threads.h>
 
 #include <drtm/c-api.h>
@@ -0,0 +1,1129 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef DRTM_DWARF_METADATA_H_
+#define DRTM_DWARF_METADATA_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+#include <drtm/elf-symbols.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief The names used to locate the RTOS structures in the
+   * debug information.
+   *
+   * @details
+   * The member paths are relative to the type, and may go
+   * through nested members (`a.b.c`); members of the base
+   * classes are found too.
+   */
+  typedef struct dwarf_names_s
+  {
+    // The fully qualified name of the thread class.
+    const char* thread_type;
+
+    const char* thread_name;
+    const char* thread_parent;
+    const char* thread_list_node;
+    const char* thread_children_node;
+    const char* thread_state;
+    const char* thread_stack;
+    const char* thread_prio_assigned;
+    const char* thread_prio_inherited;
+
+    // The fully qualified name of the list links class.
+    const char* list_links_type;
+
+    const char* list_links_prev;
+    const char* list_links_next;
+
+    // The (mangled) symbols of the scheduler variables.
+    const char* scheduler_is_started_symbol;
+    const char* scheduler_top_threads_list_symbol;
+    const char* scheduler_current_thread_symbol;
+  } dwarf_names_t;
+
+  /**
+   * @brief Compute the DRTM metadata from the ELF DWARF debug
+   * information, on the host.
+   *
+   * @details
+   * The `.debug_info` section is scanned once (DWARF 2 to 5), and
+   * the members of the structures, with their types and offsets,
+   * are collected; the member paths of the thread and list links
+   * classes are then resolved to offsets. The scheduler variables
+   * are located via the ELF symbols.
+   *
+   * The result can be passed to `frontend::use_offline_metadata()`,
+   * so the target header is not needed.
+   *
+   * @tparam A type of the allocator.
+   */
+  template<typename A = std::allocator<void*>>
+    class dwarf_metadata
+    {
+    public:
+
+      using allocator_type = A;
+      using elf_type = elf_symbols<A>;
+
+      // The names used by µOS++ IIIe.
+      static const dwarf_names_t micro_os_plus_names;
+
+    protected:
+
+      // A type DIE that may be followed to reach a structure
+      // (structures, typedefs, cv-qualifiers).
+      typedef struct type_entry_s
+      {
+        uint64_t offset;
+        uint64_t type_ref;
+        uint16_t tag;
+      } type_entry_t;
+
+      // A data member, or a base class (with nullptr name).
+      typedef struct member_entry_s
+      {
+        uint64_t parent;
+        const char* name;
+        uint64_t type_ref;
+        uint64_t location;
+      } member_entry_t;
+
+      using type_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<type_entry_t>;
+      using types_type = class std::vector<type_entry_t, type_allocator_type>;
+
+      using member_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<member_entry_t>;
+      using members_type = class std::vector<member_entry_t, member_allocator_type>;
+
+      using byte_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<uint64_t>;
+      using abbrevs_type = class std::vector<uint64_t, byte_allocator_type>;
+
+      // DWARF constants.
+      static constexpr uint16_t tag_class_type = 0x02;
+      static constexpr uint16_t tag_member = 0x0d;
+      static constexpr uint16_t tag_structure_type = 0x13;
+      static constexpr uint16_t tag_typedef = 0x16;
+      static constexpr uint16_t tag_union_type = 0x17;
+      static constexpr uint16_t tag_inheritance = 0x1c;
+      static constexpr uint16_t tag_const_type = 0x26;
+      static constexpr uint16_t tag_volatile_type = 0x35;
+      static constexpr uint16_t tag_namespace = 0x39;
+
+      static constexpr uint16_t at_name = 0x03;
+      static constexpr uint16_t at_data_member_location = 0x38;
+      static constexpr uint16_t at_declaration = 0x3c;
+      static constexpr uint16_t at_type = 0x49;
+
+      static constexpr std::size_t max_depth = 64;
+      static constexpr uint64_t no_abbrev = ~static_cast<uint64_t> (0);
+      static constexpr std::size_t max_name_size_bytes = 256;
+
+    public:
+
+      /**
+       * @brief Construct the DWARF metadata reader.
+       */
+      dwarf_metadata (allocator_type& allocator) :
+          allocator_ (allocator) // Parenthesis used to compile with 4.8
+      {
+#if defined(DEBUG)
+        printf ("%s(%p) @%p\n", __func__, &allocator, this);
+#endif /* defined(DEBUG) */
+      }
+
+      // The rule of five.
+      dwarf_metadata (const dwarf_metadata&) = delete;
+      dwarf_metadata (dwarf_metadata&&) = delete;
+      dwarf_metadata&
+      operator= (const dwarf_metadata&) = delete;
+      dwarf_metadata&
+      operator= (dwarf_metadata&&) = delete;
+
+      ~dwarf_metadata () = default;
+
+    public:
+
+      /**
+       * @brief Compute the metadata.
+       *
+       * @param elf The ELF file, already open.
+       * @param names The names of the RTOS types, members and symbols.
+       * @param out_metadata Where to store the result.
+       * @retval true All the metadata was found.
+       * @retval false Something was not found; the result is not usable.
+       */
+      bool
+      compute (const elf_type& elf, const dwarf_names_t& names,
+               offline_metadata_t* out_metadata)
+      {
+        const uint8_t* info;
+        std::size_t info_size;
+        if (!elf.section (".debug_info", &info, &info_size)
+            || !elf.section (".debug_abbrev", &abbrev_, &abbrev_size_))
+          {
+            return false;
+          }
+
+        if (!elf.section (".debug_str", &str_, &str_size_))
+          {
+            str_ = nullptr;
+            str_size_ = 0;
+          }
+        if (!elf.section (".debug_line_str", &line_str_, &line_str_size_))
+          {
+            line_str_ = nullptr;
+            line_str_size_ = 0;
+          }
+
+        is_big_endian_ = elf.is_big_endian ();
+        wanted_[0] = names.thread_type;
+        wanted_[1] = names.list_links_type;
+        found_[0] = 0;
+        found_[1] = 0;
+        types_.clear ();
+        members_.clear ();
+
+        if (!scan (info, info_size))
+          {
+            return false;
+          }
+
+        if (found_[0] == 0 || found_[1] == 0)
+          {
+            return false;
+          }
+
+        // The members of nested types interleave; group them by parent.
+        std::stable_sort (members_.begin (), members_.end (),
+                          [](const member_entry_t& a, const member_entry_t& b)
+                            { return a.parent < b.parent;});
+
+        offline_metadata_t& om = *out_metadata;
+        bool ok = true;
+
+        ok = ok && resolve (found_[0], names.thread_name, &om.thread_name_offset);
+        ok = ok && resolve (found_[0], names.thread_parent,
+                            &om.thread_parent_offset);
+        ok = ok && resolve (found_[0], names.thread_list_node,
+                            &om.thread_list_node_offset);
+        ok = ok && resolve (found_[0], names.thread_children_node,
+                            &om.thread_children_node_offset);
+        ok = ok && resolve (found_[0], names.thread_state,
+                            &om.thread_state_offset);
+        ok = ok && resolve (found_[0], names.thread_stack,
+                            &om.thread_stack_offset);
+        ok = ok && resolve (found_[0], names.thread_prio_assigned,
+                            &om.thread_prio_assigned_offset);
+        ok = ok && resolve (found_[0], names.thread_prio_inherited,
+                            &om.thread_prio_inherited_offset);
+
+        ok = ok && resolve (found_[1], names.list_links_prev,
+                            &om.list_links_prev_offset);
+        ok = ok && resolve (found_[1], names.list_links_next,
+                            &om.list_links_next_offset);
+
+        ok = ok
+            && elf.lookup (names.scheduler_is_started_symbol,
+                           &om.scheduler_is_started_addr);
+        ok = ok
+            && elf.lookup (names.scheduler_top_threads_list_symbol,
+                           &om.scheduler_top_threads_list_addr);
+        ok = ok
+            && elf.lookup (names.scheduler_current_thread_symbol,
+                           &om.scheduler_current_thread_addr);
+
+        // The collected entries refer the mapped image, and are
+        // no longer needed.
+        types_.clear ();
+        members_.clear ();
+
+        return ok;
+      }
+
+      /**
+       * @brief Compute the metadata for µOS++ IIIe.
+       */
+      inline bool
+      compute (const elf_type& elf, offline_metadata_t* out_metadata)
+      {
+        return compute (elf, micro_os_plus_names, out_metadata);
+      }
+
+    protected:
+
+      // ----------------------------------------------------------------------
+      // Readers; all advance the pointer and check the limit.
+
+      typedef struct cursor_s
+      {
+        const uint8_t* p;
+        const uint8_t* end;
+        bool is_valid;
+      } cursor_t;
+
+      uint64_t
+      read_fixed (cursor_t& c, std::size_t size)
+      {
+        if (static_cast<std::size_t> (c.end - c.p) < size)
+          {
+            c.is_valid = false;
+            c.p = c.end;
+            return 0;
+          }
+
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < size; ++i)
+          {
+            std::size_t j = is_big_endian_ ? i : (size - 1 - i);
+            value = (value << 8) | c.p[j];
+          }
+        c.p += size;
+        return value;
+      }
+
+      static uint64_t
+      read_uleb (cursor_t& c)
+      {
+        uint64_t value = 0;
+        unsigned int shift = 0;
+        while (c.p < c.end)
+          {
+            uint8_t b = *c.p++;
+            if (shift < 64)
+              {
+                value |= static_cast<uint64_t> (b & 0x7F) << shift;
+              }
+            shift += 7;
+            if ((b & 0x80) == 0)
+              {
+                return value;
+              }
+          }
+        c.is_valid = false;
+        return 0;
+      }
+
+      static int64_t
+      read_sleb (cursor_t& c)
+      {
+        int64_t value = 0;
+        unsigned int shift = 0;
+        while (c.p < c.end)
+          {
+            uint8_t b = *c.p++;
+            if (shift < 64)
+              {
+                value |= static_cast<int64_t> (static_cast<uint64_t> (b & 0x7F)
+                    << shift);
+              }
+            shift += 7;
+            if ((b & 0x80) == 0)
+              {
+                if (shift < 64 && (b & 0x40) != 0)
+                  {
+                    value |= -(static_cast<int64_t> (1) << shift);
+                  }
+                return value;
+              }
+          }
+        c.is_valid = false;
+        return 0;
+      }
+
+      static const char*
+      read_string (cursor_t& c)
+      {
+        const char* s = reinterpret_cast<const char*> (c.p);
+        const void* z = std::memchr (c.p, '\0',
+                                     static_cast<std::size_t> (c.end - c.p));
+        if (z == nullptr)
+          {
+            c.is_valid = false;
+            c.p = c.end;
+            return nullptr;
+          }
+        c.p = static_cast<const uint8_t*> (z) + 1;
+        return s;
+      }
+
+      static const char*
+      string_at (const uint8_t* section, std::size_t size, uint64_t offset)
+      {
+        if (section == nullptr || offset >= size)
+          {
+            return nullptr;
+          }
+        const char* s = reinterpret_cast<const char*> (section + offset);
+        if (std::memchr (s, '\0', static_cast<std::size_t> (size - offset))
+            == nullptr)
+          {
+            return nullptr;
+          }
+        return s;
+      }
+
+      // ----------------------------------------------------------------------
+
+      // The unit being scanned.
+      typedef struct unit_s
+      {
+        uint64_t offset;
+        uint16_t version;
+        uint8_t address_size;
+        uint8_t offset_size;
+      } unit_t;
+
+      // The value of an attribute, as needed here.
+      typedef struct value_s
+      {
+        uint64_t number;
+        const char* string;
+        // For references, true if the number is a section offset.
+        bool is_reference;
+        bool is_number;
+      } value_t;
+
+      /**
+       * @brief Read an attribute value, or skip it.
+       *
+       * @return false if the form is not known.
+       */
+      bool
+      read_value (cursor_t& c, uint64_t form, int64_t implicit,
+                  const unit_t& u, value_t* v)
+      {
+        v->number = 0;
+        v->string = nullptr;
+        v->is_reference = false;
+        v->is_number = true;
+
+        switch (form)
+          {
+          case 0x01: // DW_FORM_addr
+            v->number = read_fixed (c, u.address_size);
+            break;
+          case 0x03: // DW_FORM_block2
+            skip (c, read_fixed (c, 2));
+            v->is_number = false;
+            break;
+          case 0x04: // DW_FORM_block4
+            skip (c, read_fixed (c, 4));
+            v->is_number = false;
+            break;
+          case 0x05: // DW_FORM_data2
+            v->number = read_fixed (c, 2);
+            break;
+          case 0x06: // DW_FORM_data4
+            v->number = read_fixed (c, 4);
+            break;
+          case 0x07: // DW_FORM_data8
+            v->number = read_fixed (c, 8);
+            break;
+          case 0x08: // DW_FORM_string
+            v->string = read_string (c);
+            v->is_number = false;
+            break;
+          case 0x09: // DW_FORM_block
+          case 0x18: // DW_FORM_exprloc
+            {
+              uint64_t len = read_uleb (c);
+              read_location (c, len, v);
+            }
+            break;
+          case 0x0a: // DW_FORM_block1
+            {
+              uint64_t len = read_fixed (c, 1);
+              read_location (c, len, v);
+            }
+            break;
+          case 0x0b: // DW_FORM_data1
+          case 0x0c: // DW_FORM_flag
+            v->number = read_fixed (c, 1);
+            break;
+          case 0x0d: // DW_FORM_sdata
+            v->number = static_cast<uint64_t> (read_sleb (c));
+            break;
+          case 0x0e: // DW_FORM_strp
+            v->string = string_at (str_, str_size_,
+                                   read_fixed (c, u.offset_size));
+            v->is_number = false;
+            break;
+          case 0x1f: // DW_FORM_line_strp
+            v->string = string_at (line_str_, line_str_size_,
+                                   read_fixed (c, u.offset_size));
+            v->is_number = false;
+            break;
+          case 0x0f: // DW_FORM_udata
+            v->number = read_uleb (c);
+            break;
+          case 0x10: // DW_FORM_ref_addr
+            v->number = read_fixed (c,
+                                    (u.version == 2) ?
+                                        u.address_size : u.offset_size);
+            v->is_reference = true;
+            break;
+          case 0x11: // DW_FORM_ref1
+            v->number = u.offset + read_fixed (c, 1);
+            v->is_reference = true;
+            break;
+          case 0x12: // DW_FORM_ref2
+            v->number = u.offset + read_fixed (c, 2);
+            v->is_reference = true;
+            break;
+          case 0x13: // DW_FORM_ref4
+            v->number = u.offset + read_fixed (c, 4);
+            v->is_reference = true;
+            break;
+          case 0x14: // DW_FORM_ref8
+            v->number = u.offset + read_fixed (c, 8);
+            v->is_reference = true;
+            break;
+          case 0x15: // DW_FORM_ref_udata
+            v->number = u.offset + read_uleb (c);
+            v->is_reference = true;
+            break;
+          case 0x16: // DW_FORM_indirect
+            {
+              uint64_t f = read_uleb (c);
+              return read_value (c, f, 0, u, v);
+            }
+          case 0x17: // DW_FORM_sec_offset
+          case 0x1d: // DW_FORM_strp_sup
+          case 0x1f20: // DW_FORM_GNU_ref_alt
+          case 0x1f21: // DW_FORM_GNU_strp_alt
+            read_fixed (c, u.offset_size);
+            v->is_number = false;
+            break;
+          case 0x19: // DW_FORM_flag_present
+            v->number = 1;
+            break;
+          case 0x1a: // DW_FORM_strx
+          case 0x1b: // DW_FORM_addrx
+          case 0x22: // DW_FORM_loclistx
+          case 0x23: // DW_FORM_rnglistx
+          case 0x1f01: // DW_FORM_GNU_addr_index
+          case 0x1f02: // DW_FORM_GNU_str_index
+            // Indexed values are not resolved.
+            read_uleb (c);
+            v->is_number = false;
+            break;
+          case 0x1c: // DW_FORM_ref_sup4
+          case 0x28: // DW_FORM_strx4
+          case 0x2c: // DW_FORM_addrx4
+            read_fixed (c, 4);
+            v->is_number = false;
+            break;
+          case 0x1e: // DW_FORM_data16
+            skip (c, 16);
+            v->is_number = false;
+            break;
+          case 0x20: // DW_FORM_ref_sig8
+          case 0x24: // DW_FORM_ref_sup8
+            read_fixed (c, 8);
+            v->is_number = false;
+            break;
+          case 0x21: // DW_FORM_implicit_const
+            v->number = static_cast<uint64_t> (implicit);
+            break;
+          case 0x25: // DW_FORM_strx1
+          case 0x29: // DW_FORM_addrx1
+            read_fixed (c, 1);
+            v->is_number = false;
+            break;
+          case 0x26: // DW_FORM_strx2
+          case 0x2a: // DW_FORM_addrx2
+            read_fixed (c, 2);
+            v->is_number = false;
+            break;
+          case 0x27: // DW_FORM_strx3
+          case 0x2b: // DW_FORM_addrx3
+            read_fixed (c, 3);
+            v->is_number = false;
+            break;
+          default:
+            return false;
+          }
+
+        return c.is_valid;
+      }
+
+      static void
+      skip (cursor_t& c, uint64_t len)
+      {
+        if (len > static_cast<uint64_t> (c.end - c.p))
+          {
+            c.is_valid = false;
+            c.p = c.end;
+            return;
+          }
+        c.p += len;
+      }
+
+      /**
+       * @brief Decode a block; for member locations, DWARF 2 uses
+       * an expression (DW_OP_plus_uconst), later versions a constant.
+       */
+      static void
+      read_location (cursor_t& c, uint64_t len, value_t* v)
+      {
+        v->is_number = false;
+        if (len > static_cast<uint64_t> (c.end - c.p))
+          {
+            c.is_valid = false;
+            c.p = c.end;
+            return;
+          }
+
+        cursor_t e =
+          { c.p, c.p + len, true };
+        // DW_OP_plus_uconst
+        if (len > 1 && *e.p == 0x23)
+          {
+            ++e.p;
+            v->number = read_uleb (e);
+            v->is_number = e.is_valid;
+          }
+        c.p += len;
+      }
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @brief Scan all units in `.debug_info`.
+       */
+      bool
+      scan (const uint8_t* info, std::size_t info_size)
+      {
+        cursor_t c =
+          { info, info + info_size, true };
+
+        while (c.p < c.end && c.is_valid)
+          {
+            unit_t u;
+            u.offset = static_cast<uint64_t> (c.p - info);
+
+            uint64_t length = read_fixed (c, 4);
+            u.offset_size = 4;
+            if (length == 0xFFFFFFFF)
+              {
+                length = read_fixed (c, 8);
+                u.offset_size = 8;
+              }
+            if (!c.is_valid || length > static_cast<uint64_t> (c.end - c.p))
+              {
+                return false;
+              }
+
+            cursor_t uc =
+              { c.p, c.p + length, true };
+            c.p += length;
+
+            u.version = static_cast<uint16_t> (read_fixed (uc, 2));
+            uint64_t abbrev_offset;
+            if (u.version >= 2 && u.version <= 4)
+              {
+                abbrev_offset = read_fixed (uc, u.offset_size);
+                u.address_size = static_cast<uint8_t> (read_fixed (uc, 1));
+              }
+            else if (u.version == 5)
+              {
+                uint8_t unit_type = static_cast<uint8_t> (read_fixed (uc, 1));
+                u.address_size = static_cast<uint8_t> (read_fixed (uc, 1));
+                abbrev_offset = read_fixed (uc, u.offset_size);
+                // DW_UT_compile, DW_UT_partial are the usual ones.
+                if (unit_type == 0x04 || unit_type == 0x05)
+                  {
+                    // DW_UT_skeleton, DW_UT_split_compile: dwo_id
+                    read_fixed (uc, 8);
+                  }
+                else if (unit_type == 0x02 || unit_type == 0x06)
+                  {
+                    // DW_UT_type, DW_UT_split_type: signature, type offset
+                    read_fixed (uc, 8);
+                    read_fixed (uc, u.offset_size);
+                  }
+              }
+            else
+              {
+                // Unknown version, skip the unit.
+                continue;
+              }
+
+            if (!uc.is_valid || !scan_unit (uc, u, info, abbrev_offset))
+              {
+                return false;
+              }
+          }
+
+        return c.is_valid;
+      }
+
+      /**
+       * @brief Index the abbreviations of a unit, by code.
+       */
+      bool
+      index_abbrevs (uint64_t abbrev_offset, abbrevs_type& abbrevs)
+      {
+        if (abbrev_offset >= abbrev_size_)
+          {
+            return false;
+          }
+
+        cursor_t c =
+          { abbrev_ + abbrev_offset, abbrev_ + abbrev_size_, true };
+        abbrevs.clear ();
+
+        for (;;)
+          {
+            const uint8_t* start = c.p;
+            uint64_t code = read_uleb (c);
+            if (code == 0 || !c.is_valid)
+              {
+                break;
+              }
+            if (code >= abbrevs.size ())
+              {
+                // Codes are usually dense, starting from 1.
+                if (code > 0xFFFFF)
+                  {
+                    return false;
+                  }
+                abbrevs.resize (static_cast<std::size_t> (code + 1), no_abbrev);
+              }
+            abbrevs[static_cast<std::size_t> (code)] =
+                static_cast<uint64_t> (start - abbrev_);
+
+            read_uleb (c); // tag
+            read_fixed (c, 1); // children
+            for (;;)
+              {
+                uint64_t attr = read_uleb (c);
+                uint64_t form = read_uleb (c);
+                if (form == 0x21)
+                  {
+                    read_sleb (c);
+                  }
+                if ((attr == 0 && form == 0) || !c.is_valid)
+                  {
+                    break;
+                  }
+              }
+          }
+
+        return c.is_valid;
+      }
+
+      /**
+       * @brief Scan the entries of a unit, collecting the types and
+       * members, and the wanted structures.
+       */
+      bool
+      scan_unit (cursor_t& c, const unit_t& u, const uint8_t* info,
+                 uint64_t abbrev_offset)
+      {
+        abbrevs_type abbrevs
+          { reinterpret_cast<byte_allocator_type&> (allocator_) };
+        if (!index_abbrevs (abbrev_offset, abbrevs))
+          {
+            return false;
+          }
+
+        // The scopes of the current entry, for the qualified names.
+        const char* scope_names[max_depth];
+        uint64_t scope_offsets[max_depth];
+        bool scope_is_type[max_depth];
+        std::size_t depth = 0;
+
+        while (c.p < c.end && c.is_valid)
+          {
+            uint64_t offset = static_cast<uint64_t> (c.p - info);
+            uint64_t code = read_uleb (c);
+            if (code == 0)
+              {
+                // End of children.
+                if (depth > 0)
+                  {
+                    --depth;
+                  }
+                continue;
+              }
+            if (code >= abbrevs.size () || abbrevs[code] == no_abbrev)
+              {
+                return false;
+              }
+
+            cursor_t a =
+              { abbrev_ + abbrevs[code], abbrev_ + abbrev_size_, true };
+            read_uleb (a); // code
+            uint16_t tag = static_cast<uint16_t> (read_uleb (a));
+            bool has_children = (read_fixed (a, 1) != 0);
+
+            const char* name = nullptr;
+            uint64_t type_ref = 0;
+            uint64_t location = 0;
+            bool has_location = false;
+            bool is_declaration = false;
+
+            for (;;)
+              {
+                uint64_t attr = read_uleb (a);
+                uint64_t form = read_uleb (a);
+                int64_t implicit = 0;
+                if (form == 0x21)
+                  {
+                    implicit = read_sleb (a);
+                  }
+                if (attr == 0 && form == 0)
+                  {
+                    break;
+                  }
+                if (!a.is_valid)
+                  {
+                    return false;
+                  }
+
+                value_t v;
+                if (!read_value (c, form, implicit, u, &v))
+                  {
+                    return false;
+                  }
+
+                switch (attr)
+                  {
+                  case at_name:
+                    name = v.string;
+                    break;
+                  case at_type:
+                    type_ref = v.is_reference ? v.number : 0;
+                    break;
+                  case at_data_member_location:
+                    location = v.number;
+                    has_location = v.is_number;
+                    break;
+                  case at_declaration:
+                    is_declaration = (v.number != 0);
+                    break;
+                  default:
+                    break;
+                  }
+              }
+
+            bool parent_is_type = (depth > 0) && scope_is_type[depth - 1];
+            uint64_t parent = (depth > 0) ? scope_offsets[depth - 1] : 0;
+
+            switch (tag)
+              {
+              case tag_structure_type:
+              case tag_class_type:
+              case tag_union_type:
+                types_.push_back (
+                  { offset, 0, tag });
+                if (name != nullptr && !is_declaration)
+                  {
+                    match (scope_names, depth, name, offset);
+                  }
+                break;
+              case tag_typedef:
+              case tag_const_type:
+              case tag_volatile_type:
+                types_.push_back (
+                  { offset, type_ref, tag });
+                break;
+              case tag_member:
+              case tag_inheritance:
+                // Static members have no location.
+                if (parent_is_type && has_location)
+                  {
+                    members_.push_back (
+                      { parent, (tag == tag_member) ? name : nullptr,
+                          type_ref, location });
+                  }
+                break;
+              default:
+                break;
+              }
+
+            if (has_children)
+              {
+                if (depth >= max_depth)
+                  {
+                    return false;
+                  }
+                scope_names[depth] =
+                    (tag == tag_namespace || tag == tag_structure_type
+                        || tag == tag_class_type || tag == tag_union_type) ?
+                        name : nullptr;
+                scope_offsets[depth] = offset;
+                scope_is_type[depth] = (tag == tag_structure_type
+                    || tag == tag_class_type || tag == tag_union_type);
+                ++depth;
+              }
+          }
+
+        return c.is_valid;
+      }
+
+      /**
+       * @brief Check if the qualified name of a structure is one
+       * of the wanted ones; the first definition is used.
+       */
+      void
+      match (const char* const* scope_names, std::size_t depth,
+             const char* name, uint64_t offset)
+      {
+        char qualified[max_name_size_bytes];
+        std::size_t len = 0;
+
+        for (std::size_t i = 0; i <= depth; ++i)
+          {
+            const char* n = (i < depth) ? scope_names[i] : name;
+            if (n == nullptr)
+              {
+                // Units and functions do not add to the name.
+                continue;
+              }
+            std::size_t n_len = std::strlen (n);
+            if (len + n_len + 3 > sizeof(qualified))
+              {
+                return;
+              }
+            if (len > 0)
+              {
+                qualified[len++] = ':';
+                qualified[len++] = ':';
+              }
+            std::memcpy (&qualified[len], n, n_len);
+            len += n_len;
+          }
+        qualified[len] = '\0';
+
+        for (std::size_t i = 0; i < 2; ++i)
+          {
+            if (found_[i] == 0 && std::strcmp (qualified, wanted_[i]) == 0)
+              {
+                found_[i] = offset;
+              }
+          }
+      }
+
+      /**
+       * @brief Follow typedefs and cv-qualifiers to a structure.
+       *
+       * @return The offset of the structure entry, or 0.
+       */
+      uint64_t
+      strip (uint64_t type_ref)
+      {
+        for (std::size_t i = 0; i < max_depth && type_ref != 0; ++i)
+          {
+            auto it = std::lower_bound (
+                types_.begin (), types_.end (), type_ref,
+                [](const type_entry_t& t, uint64_t o)
+                  { return t.offset < o;});
+            if (it == types_.end () || it->offset != type_ref)
+              {
+                return 0;
+              }
+            if (it->tag == tag_structure_type || it->tag == tag_class_type
+                || it->tag == tag_union_type)
+              {
+                return type_ref;
+              }
+            type_ref = it->type_ref;
+          }
+        return 0;
+      }
+
+      /**
+       * @brief Find a member by name in a structure or its bases.
+       */
+      bool
+      find_member (uint64_t type, const char* name, std::size_t name_len,
+                   std::size_t depth, uint64_t* out_offset,
+                   uint64_t* out_type)
+      {
+        if (depth > max_depth)
+          {
+            return false;
+          }
+
+        auto range = std::equal_range (
+            members_.begin (), members_.end (), member_entry_t
+              { type, nullptr, 0, 0 },
+            [](const member_entry_t& a, const member_entry_t& b)
+              { return a.parent < b.parent;});
+
+        for (auto it = range.first; it != range.second; ++it)
+          {
+            if (it->name != nullptr && std::strlen (it->name) == name_len
+                && std::strncmp (it->name, name, name_len) == 0)
+              {
+                *out_offset = it->location;
+                *out_type = it->type_ref;
+                return true;
+              }
+          }
+
+        // Not a direct member, try the base classes.
+        for (auto it = range.first; it != range.second; ++it)
+          {
+            if (it->name == nullptr)
+              {
+                uint64_t base = strip (it->type_ref);
+                if (base != 0
+                    && find_member (base, name, name_len, depth + 1,
+                                    out_offset, out_type))
+                  {
+                    *out_offset += it->location;
+                    return true;
+                  }
+              }
+          }
+
+        return false;
+      }
+
+      /**
+       * @brief Resolve a member path (`a.b.c`) to an offset.
+       */
+      bool
+      resolve (uint64_t type, const char* path, target_offset_t* out_offset)
+      {
+        uint64_t total = 0;
+        const char* p = path;
+
+        for (;;)
+          {
+            const char* dot = std::strchr (p, '.');
+            std::size_t len = (dot != nullptr) ? static_cast<std::size_t> (dot - p) : std::strlen (p);
+
+            uint64_t offset;
+            uint64_t member_type;
+            if (type == 0 || !find_member (type, p, len, 0, &offset, &member_type))
+              {
+                return false;
+              }
+            total += offset;
+
+            if (dot == nullptr)
+              {
+                break;
+              }
+            type = strip (member_type);
+            p = dot + 1;
+          }
+
+        if (total > 0xFFFF)
+          {
+            return false;
+          }
+        *out_offset = static_cast<target_offset_t> (total);
+        return true;
+      }
+
+    private:
+
+      allocator_type& allocator_;
+
+      const uint8_t* abbrev_ = nullptr;
+      std::size_t abbrev_size_ = 0;
+      const uint8_t* str_ = nullptr;
+      std::size_t str_size_ = 0;
+      const uint8_t* line_str_ = nullptr;
+      std::size_t line_str_size_ = 0;
+
+      bool is_big_endian_ = false;
+
+      // The thread and the list links types.
+      const char* wanted_[2];
+      uint64_t found_[2];
+
+      types_type types_
+        { reinterpret_cast<type_allocator_type&> (allocator_) };
+      members_type members_
+        { reinterpret_cast<member_allocator_type&> (allocator_) };
+    };
+
+#pragma GCC diagnostic pop
+
+  // --------------------------------------------------------------------------
+
+  template<typename A>
+    constexpr uint64_t dwarf_metadata<A>::no_abbrev;
+
+  template<typename A>
+    const dwarf_names_t dwarf_metadata<A>::micro_os_plus_names =
+      {
+      //
+          .thread_type = "os::rtos::thread", //
+          .thread_name = "name_", //
+          .thread_parent = "parent_", //
+          .thread_list_node = "child_links_", //
+          .thread_children_node = "children_", //
+          .thread_state = "state_", //
+          .thread_stack = "context_.port_.stack_ptr", //
+          .thread_prio_assigned = "prio_assigned_", //
+          .thread_prio_inherited = "prio_inherited_", //
+
+          .list_links_type = "os::utils::static_double_list_links", //
+          .list_links_prev = "prev_", //
+          .list_links_next = "next_", //
+
+          .scheduler_is_started_symbol =
+              "_ZN2os4rtos9scheduler11is_started_E", //
+          .scheduler_top_threads_list_symbol =
+              "_ZN2os4rtos9scheduler17top_threads_list_E", //
+          .scheduler_current_thread_symbol =
+              "_ZN2os4rtos9scheduler15current_thread_E", //
+      /**/
+      };
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_DWARF_METADATA_H_ */
@@ -0,0 +1,759 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef DRTM_ELF_SYMBOLS_H_
+#define DRTM_ELF_SYMBOLS_H_
+
+#if defined(__cplusplus)
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief Host side reader of the symbols and the memory regions
+   * of an ELF image.
+   *
+   * @details
+   * The application image is mapped in memory, and a hash index
+   * of the `.symtab` section is built when the file is opened,
+   * so symbol lookups do not need to scan the table; the names
+   * are not copied, they are referred directly in the mapped image.
+   *
+   * Both ELF32 and ELF64 images are supported, in either byte order.
+   *
+   * The memory regions are taken from the `PT_LOAD` program headers.
+   *
+   * This is not used by the library itself; the backend can use it
+   * to implement `get_symbol_address()` without further requests
+   * to the debugger.
+   *
+   * @tparam A type of the allocator used for the index and regions.
+   */
+  template<typename A = std::allocator<void*>>
+    class elf_symbols
+    {
+    public:
+
+      using allocator_type = A;
+
+      // Large enough for both ELF32 and ELF64.
+      using address_t = uint64_t;
+
+      typedef struct region_s
+      {
+        // The run time address (p_vaddr).
+        address_t address;
+        // The load address (p_paddr); differs for initialised data.
+        address_t load_address;
+        // The size in memory (p_memsz).
+        uint64_t size_bytes;
+        // The size in the file (p_filesz); the rest is zeroed (.bss).
+        uint64_t file_size_bytes;
+        // PF_X, PF_W, PF_R.
+        uint32_t flags;
+      } region_t;
+
+      static constexpr uint32_t region_flag_execute = 0x1;
+      static constexpr uint32_t region_flag_write = 0x2;
+      static constexpr uint32_t region_flag_read = 0x4;
+
+    protected:
+
+      using index_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<uint32_t>;
+
+      // The hash index; each slot holds a symbol index, 0 is empty
+      // (the symbol 0 is always the undefined symbol).
+      using index_type = class std::vector<uint32_t, index_allocator_type>;
+
+      using region_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<region_t>;
+
+      using regions_type = class std::vector<region_t, region_allocator_type>;
+
+    public:
+
+      /**
+       * @brief Construct the ELF reader; no file is open yet.
+       */
+      elf_symbols (allocator_type& allocator) :
+          allocator_ (allocator) // Parenthesis used to compile with 4.8
+      {
+#if defined(DEBUG)
+        printf ("%s(%p) @%p\n", __func__, &allocator, this);
+#endif /* defined(DEBUG) */
+      }
+
+      // The rule of five.
+      elf_symbols (const elf_symbols&) = delete;
+      elf_symbols (elf_symbols&&) = delete;
+      elf_symbols&
+      operator= (const elf_symbols&) = delete;
+      elf_symbols&
+      operator= (elf_symbols&&) = delete;
+
+      /**
+       * @brief Unmap the image, if open.
+       */
+      ~elf_symbols ()
+      {
+#if defined(DEBUG)
+        printf ("%s() @%p\n", __func__, this);
+#endif /* defined(DEBUG) */
+
+        close ();
+      }
+
+    public:
+
+      /**
+       * @brief Map the ELF file and index its symbols and regions.
+       *
+       * @param path The path of the application ELF file.
+       * @retval true The file was mapped and indexed.
+       * @retval false The file could not be read or is not a
+       *  supported ELF.
+       */
+      bool
+      open (const char* path)
+      {
+#if defined(DEBUG)
+        printf ("%s(\"%s\")\n", __func__, path);
+#endif /* defined(DEBUG) */
+
+        close ();
+
+        int fd = ::open (path, O_RDONLY);
+        if (fd < 0)
+          {
+            return false;
+          }
+
+        struct stat st;
+        if (::fstat (fd, &st) < 0 || st.st_size <= 0)
+          {
+            ::close (fd);
+            return false;
+          }
+
+        void* p = ::mmap (nullptr, static_cast<std::size_t> (st.st_size),
+        PROT_READ,
+                          MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file.
+        ::close (fd);
+
+        if (p == MAP_FAILED)
+          {
+            return false;
+          }
+
+        image_ = static_cast<const uint8_t*> (p);
+        image_size_ = static_cast<std::size_t> (st.st_size);
+
+        if (!parse_identification () || !parse_symbols ()
+            || !parse_regions ())
+          {
+            close ();
+            return false;
+          }
+
+        return true;
+      }
+
+      /**
+       * @brief Unmap the image and clear the index.
+       */
+      void
+      close (void)
+      {
+        if (image_ != nullptr)
+          {
+            ::munmap (const_cast<uint8_t*> (image_), image_size_);
+          }
+
+        image_ = nullptr;
+        image_size_ = 0;
+        symtab_offset_ = 0;
+        symbols_count_ = 0;
+        index_.clear ();
+        regions_.clear ();
+      }
+
+      inline bool
+      is_open (void) const
+      {
+        return image_ != nullptr;
+      }
+
+      /**
+       * @brief Find a symbol by name.
+       *
+       * @details
+       * If multiple symbols have the same name (like file local
+       * statics), the global one is preferred.
+       *
+       * @param name The symbol name.
+       * @param out_address Where to store the symbol value.
+       * @param out_size Where to store the symbol size; may be nullptr.
+       * @retval true The symbol was found.
+       * @retval false There is no symbol with this name.
+       */
+      bool
+      lookup (const char* name, address_t* out_address, uint64_t* out_size =
+                  nullptr) const
+      {
+        if (index_.empty ())
+          {
+            return false;
+          }
+
+        std::size_t mask = index_.size () - 1;
+        for (std::size_t slot = hash (name) & mask;; slot = (slot + 1) & mask)
+          {
+            uint32_t ix = index_[slot];
+            if (ix == 0)
+              {
+                return false;
+              }
+            if (std::strcmp (symbol_name (ix), name) == 0)
+              {
+                *out_address = symbol_value (ix);
+                if (out_size != nullptr)
+                  {
+                    *out_size = symbol_size (ix);
+                  }
+                return true;
+              }
+          }
+      }
+
+      /**
+       * @brief Get the address of a symbol; 0 if not found.
+       */
+      address_t
+      get_symbol_address (const char* name) const
+      {
+        address_t address = 0;
+        lookup (name, &address);
+        return address;
+      }
+
+      /**
+       * @brief Get the number of indexed symbols.
+       */
+      std::size_t
+      symbols_count (void) const
+      {
+        return indexed_count_;
+      }
+
+      /**
+       * @brief Get the loaded memory regions, ordered by address.
+       */
+      const regions_type&
+      regions (void) const
+      {
+        return regions_;
+      }
+
+      /**
+       * @brief Find the memory region containing an address.
+       *
+       * @return A pointer to the region, or nullptr if the address is
+       *  not in any loaded region.
+       */
+      const region_t*
+      region (address_t address) const
+      {
+        auto it = std::upper_bound (
+            regions_.begin (), regions_.end (), address,
+            [](address_t a, const region_t& r)
+              { return a < r.address;});
+
+        if (it == regions_.begin ())
+          {
+            return nullptr;
+          }
+        --it;
+        if (address - it->address < it->size_bytes)
+          {
+            return &*it;
+          }
+        return nullptr;
+      }
+
+      /**
+       * @brief Check if a memory range is fully inside a loaded region.
+       */
+      bool
+      is_mapped (address_t address, std::size_t size_bytes) const
+      {
+        const region_t* r = region (address);
+        return r != nullptr
+            && (address - r->address) + size_bytes <= r->size_bytes;
+      }
+
+      /**
+       * @brief Find a section by name, like `.debug_info`.
+       *
+       * @details
+       * Compressed sections (`SHF_COMPRESSED`) are not supported.
+       *
+       * @param name The section name.
+       * @param out_data Where to store the pointer to the section content,
+       *  in the mapped image.
+       * @param out_size Where to store the section size.
+       * @retval true The section was found.
+       * @retval false There is no such section, or it is compressed.
+       */
+      bool
+      section (const char* name, const uint8_t** out_data,
+               std::size_t* out_size) const
+      {
+        if (image_ == nullptr)
+          {
+            return false;
+          }
+
+        uint64_t shoff = load_word (is_class64_ ? 0x28 : 0x20);
+        uint16_t shentsize = load_short (is_class64_ ? 0x3A : 0x2E);
+        uint16_t shnum = load_short (is_class64_ ? 0x3C : 0x30);
+        uint16_t shstrndx = load_short (is_class64_ ? 0x3E : 0x32);
+
+        if (shstrndx >= shnum)
+          {
+            return false;
+          }
+
+        uint64_t strsh = shoff + static_cast<uint64_t> (shentsize) * shstrndx;
+        uint64_t names = load_word (strsh + (is_class64_ ? 0x18 : 0x10));
+        uint64_t names_size = load_word (strsh + (is_class64_ ? 0x20 : 0x14));
+        if (!in_image (names, names_size))
+          {
+            return false;
+          }
+
+        std::size_t len = std::strlen (name);
+        for (uint16_t i = 0; i < shnum; ++i)
+          {
+            uint64_t sh = shoff + static_cast<uint64_t> (shentsize) * i;
+            uint32_t n = load_long (sh);
+            if (n + len >= names_size
+                || std::memcmp (image_ + names + n, name, len + 1) != 0)
+              {
+                continue;
+              }
+
+            uint64_t flags = load_word (sh + 8);
+            uint64_t offset = load_word (sh + (is_class64_ ? 0x18 : 0x10));
+            uint64_t size = load_word (sh + (is_class64_ ? 0x20 : 0x14));
+            // SHF_COMPRESSED
+            if ((flags & 0x800) != 0 || !in_image (offset, size))
+              {
+                return false;
+              }
+
+            *out_data = image_ + offset;
+            *out_size = static_cast<std::size_t> (size);
+            return true;
+          }
+
+        return false;
+      }
+
+      inline bool
+      is_class64 (void) const
+      {
+        return is_class64_;
+      }
+
+      inline bool
+      is_big_endian (void) const
+      {
+        return is_big_endian_;
+      }
+
+    protected:
+
+      // ----------------------------------------------------------------------
+      // Raw accessors; all offsets are checked against the image size.
+
+      inline bool
+      in_image (uint64_t offset, uint64_t size) const
+      {
+        return offset <= image_size_ && size <= image_size_ - offset;
+      }
+
+      uint64_t
+      load (uint64_t offset, std::size_t size) const
+      {
+        const uint8_t* p = image_ + offset;
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < size; ++i)
+          {
+            std::size_t j = is_big_endian_ ? i : (size - 1 - i);
+            value = (value << 8) | p[j];
+          }
+        return value;
+      }
+
+      inline uint16_t
+      load_short (uint64_t offset) const
+      {
+        return static_cast<uint16_t> (load (offset, 2));
+      }
+
+      inline uint32_t
+      load_long (uint64_t offset) const
+      {
+        return static_cast<uint32_t> (load (offset, 4));
+      }
+
+      // A word is 4 bytes in ELF32, 8 bytes in ELF64.
+      inline uint64_t
+      load_word (uint64_t offset) const
+      {
+        return load (offset, is_class64_ ? 8 : 4);
+      }
+
+      // ----------------------------------------------------------------------
+
+      bool
+      parse_identification (void)
+      {
+        // e_ident[EI_NIDENT], e_type, e_machine, e_version.
+        if (!in_image (0, 0x34) || std::memcmp (image_, "\177ELF", 4) != 0)
+          {
+            return false;
+          }
+
+        // EI_CLASS: 1 = ELFCLASS32, 2 = ELFCLASS64.
+        if (image_[4] == 1)
+          {
+            is_class64_ = false;
+          }
+        else if (image_[4] == 2 && in_image (0, 0x40))
+          {
+            is_class64_ = true;
+          }
+        else
+          {
+            return false;
+          }
+
+        // EI_DATA: 1 = ELFDATA2LSB, 2 = ELFDATA2MSB.
+        if (image_[5] != 1 && image_[5] != 2)
+          {
+            return false;
+          }
+        is_big_endian_ = (image_[5] == 2);
+
+        return true;
+      }
+
+      /**
+       * @brief Locate the `.symtab` section and its string table,
+       * and build the hash index.
+       */
+      bool
+      parse_symbols (void)
+      {
+        uint64_t shoff = load_word (is_class64_ ? 0x28 : 0x20);
+        uint16_t shentsize = load_short (is_class64_ ? 0x3A : 0x2E);
+        uint16_t shnum = load_short (is_class64_ ? 0x3C : 0x30);
+
+        if (shoff == 0 || shnum == 0
+            || !in_image (shoff, static_cast<uint64_t> (shentsize) * shnum))
+          {
+            return false;
+          }
+
+        for (uint16_t i = 0; i < shnum; ++i)
+          {
+            uint64_t sh = shoff + static_cast<uint64_t> (shentsize) * i;
+            // SHT_SYMTAB
+            if (load_long (sh + 4) != 2)
+              {
+                continue;
+              }
+
+            uint64_t offset = load_word (sh + (is_class64_ ? 0x18 : 0x10));
+            uint64_t size = load_word (sh + (is_class64_ ? 0x20 : 0x14));
+            uint32_t link = load_long (sh + (is_class64_ ? 0x28 : 0x18));
+            uint64_t entsize = load_word (sh + (is_class64_ ? 0x38 : 0x24));
+
+            if (entsize < (is_class64_ ? 24u : 16u) || !in_image (offset, size)
+                || link >= shnum)
+              {
+                return false;
+              }
+
+            uint64_t strsh = shoff + static_cast<uint64_t> (shentsize) * link;
+            strtab_offset_ = load_word (strsh + (is_class64_ ? 0x18 : 0x10));
+            strtab_size_ = load_word (strsh + (is_class64_ ? 0x20 : 0x14));
+            if (!in_image (strtab_offset_, strtab_size_) || strtab_size_ == 0)
+              {
+                return false;
+              }
+
+            symtab_offset_ = offset;
+            symtab_entsize_ = entsize;
+            symbols_count_ = static_cast<std::size_t> (size / entsize);
+
+            build_index ();
+            return true;
+          }
+
+        // No symbols, possibly stripped.
+        return false;
+      }
+
+      void
+      build_index (void)
+      {
+        // A power of two, at least twice the number of symbols,
+        // to keep the probe sequences short.
+        std::size_t slots = 16;
+        while (slots < symbols_count_ * 2)
+          {
+            slots *= 2;
+          }
+        index_.assign (slots, 0);
+        indexed_count_ = 0;
+
+        std::size_t mask = slots - 1;
+        for (std::size_t ix = 1; ix < symbols_count_; ++ix)
+          {
+            uint64_t sym = symtab_offset_ + ix * symtab_entsize_;
+            uint8_t info = image_[sym + (is_class64_ ? 4 : 12)];
+            uint16_t shndx = load_short (sym + (is_class64_ ? 6 : 14));
+
+            // Skip undefined symbols, sections and files.
+            uint8_t type = info & 0xF;
+            if (shndx == 0 || type == 3 || type == 4)
+              {
+                continue;
+              }
+
+            const char* name = symbol_name (static_cast<uint32_t> (ix));
+            if (*name == '\0')
+              {
+                continue;
+              }
+
+            for (std::size_t slot = hash (name) & mask;;
+                slot = (slot + 1) & mask)
+              {
+                uint32_t other = index_[slot];
+                if (other == 0)
+                  {
+                    index_[slot] = static_cast<uint32_t> (ix);
+                    ++indexed_count_;
+                    break;
+                  }
+                if (std::strcmp (symbol_name (other), name) == 0)
+                  {
+                    // Same name; a global symbol replaces a local one.
+                    if (symbol_binding (other) == 0
+                        && symbol_binding (static_cast<uint32_t> (ix)) != 0)
+                      {
+                        index_[slot] = static_cast<uint32_t> (ix);
+                      }
+                    break;
+                  }
+              }
+          }
+      }
+
+      /**
+       * @brief Collect the `PT_LOAD` segments.
+       */
+      bool
+      parse_regions (void)
+      {
+        uint64_t phoff = load_word (is_class64_ ? 0x20 : 0x1C);
+        uint16_t phentsize = load_short (is_class64_ ? 0x36 : 0x2A);
+        uint16_t phnum = load_short (is_class64_ ? 0x38 : 0x2C);
+
+        if (phoff == 0 || phnum == 0)
+          {
+            // Relocatable files have no segments; not an error.
+            return true;
+          }
+        if (!in_image (phoff, static_cast<uint64_t> (phentsize) * phnum))
+          {
+            return false;
+          }
+
+        for (uint16_t i = 0; i < phnum; ++i)
+          {
+            uint64_t ph = phoff + static_cast<uint64_t> (phentsize) * i;
+            // PT_LOAD
+            if (load_long (ph) != 1)
+              {
+                continue;
+              }
+
+            region_t r;
+            if (is_class64_)
+              {
+                r.flags = load_long (ph + 0x04);
+                r.address = load_word (ph + 0x10);
+                r.load_address = load_word (ph + 0x18);
+                r.file_size_bytes = load_word (ph + 0x20);
+                r.size_bytes = load_word (ph + 0x28);
+              }
+            else
+              {
+                r.address = load_word (ph + 0x08);
+                r.load_address = load_word (ph + 0x0C);
+                r.file_size_bytes = load_word (ph + 0x10);
+                r.size_bytes = load_word (ph + 0x14);
+                r.flags = load_long (ph + 0x18);
+              }
+
+            if (r.size_bytes != 0)
+              {
+                regions_.push_back (r);
+              }
+          }
+
+        std::sort (regions_.begin (), regions_.end (),
+                   [](const region_t& a, const region_t& b)
+                     { return a.address < b.address;});
+
+        return true;
+      }
+
+      // ----------------------------------------------------------------------
+      // Symbol accessors.
+
+      const char*
+      symbol_name (uint32_t ix) const
+      {
+        uint64_t sym = symtab_offset_ + ix * symtab_entsize_;
+        uint32_t name = load_long (sym);
+        if (name >= strtab_size_)
+          {
+            return "";
+          }
+
+        const char* p = reinterpret_cast<const char*> (image_ + strtab_offset_
+            + name);
+        // The string must be terminated inside the table.
+        if (std::memchr (p, '\0', static_cast<std::size_t> (strtab_size_ - name))
+            == nullptr)
+          {
+            return "";
+          }
+        return p;
+      }
+
+      address_t
+      symbol_value (uint32_t ix) const
+      {
+        uint64_t sym = symtab_offset_ + ix * symtab_entsize_;
+        return load_word (sym + (is_class64_ ? 8 : 4));
+      }
+
+      uint64_t
+      symbol_size (uint32_t ix) const
+      {
+        uint64_t sym = symtab_offset_ + ix * symtab_entsize_;
+        return load_word (sym + (is_class64_ ? 16 : 8));
+      }
+
+      // STB_LOCAL 0, STB_GLOBAL 1, STB_WEAK 2.
+      uint8_t
+      symbol_binding (uint32_t ix) const
+      {
+        uint64_t sym = symtab_offset_ + ix * symtab_entsize_;
+        return static_cast<uint8_t> (image_[sym + (is_class64_ ? 4 : 12)] >> 4);
+      }
+
+      // FNV-1a.
+      static std::size_t
+      hash (const char* name)
+      {
+        uint32_t h = 2166136261u;
+        for (; *name != '\0'; ++name)
+          {
+            h ^= static_cast<uint8_t> (*name);
+            h *= 16777619u;
+          }
+        return h;
+      }
+
+    private:
+
+      allocator_type& allocator_;
+
+      const uint8_t* image_ = nullptr;
+      std::size_t image_size_ = 0;
+
+      bool is_class64_ = false;
+      bool is_big_endian_ = false;
+
+      uint64_t symtab_offset_ = 0;
+      uint64_t symtab_entsize_ = 0;
+      std::size_t symbols_count_ = 0;
+      std::size_t indexed_count_ = 0;
+
+      uint64_t strtab_offset_ = 0;
+      uint64_t strtab_size_ = 0;
+
+      index_type index_
+        { reinterpret_cast<index_allocator_type&> (allocator_) };
+
+      regions_type regions_
+        { reinterpret_cast<region_allocator_type&> (allocator_) };
+    };
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_ELF_SYMBOLS_H_ */
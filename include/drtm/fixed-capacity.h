@@ -0,0 +1,375 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_FIXED_CAPACITY_H_
+#define DRTM_FIXED_CAPACITY_H_
+
+#if defined(__cplusplus)
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+#include <iterator>
+#include <new>
+
+// The size of the thread names, including the terminator, when the
+// allocator does not define it.
+#if !defined(DRTM_THREAD_NAME_MAX_SIZE_BYTES)
+#define DRTM_THREAD_NAME_MAX_SIZE_BYTES   256
+#endif
+
+namespace drtm
+{
+
+  /**
+   * @brief An allocator that only tags the heap-free configuration.
+   *
+   * @details
+   * With this allocator, the threads collection uses static arrays
+   * sized at compile time, for at most `N` threads, with names of
+   * at most `NameBytes` bytes (including the terminator); it never
+   * allocates and never throws. When the target has more threads,
+   * the extra ones are not shown.
+   *
+   * @tparam N The maximum number of threads.
+   * @tparam NameBytes The size of the thread names.
+   */
+  template<std::size_t N, std::size_t NameBytes = 32, typename T = void*>
+    class fixed_capacity_allocator
+    {
+    public:
+
+      // Standard types.
+      using value_type = T;
+
+      template<typename U>
+        struct rebind
+        {
+          using other = fixed_capacity_allocator<N, NameBytes, U>;
+        };
+
+      static constexpr std::size_t threads_max_count = N;
+      static constexpr std::size_t name_max_size_bytes = NameBytes;
+
+      static_assert(threads_max_count > 0, "At least one thread is needed");
+      static_assert(name_max_size_bytes > 1, "Names need at least 2 bytes");
+
+    public:
+
+      fixed_capacity_allocator () noexcept = default;
+
+      template<typename U>
+        fixed_capacity_allocator (
+            fixed_capacity_allocator<N, NameBytes, U> const & other __attribute__((unused))) noexcept
+        {
+          ; // No members to copy.
+        }
+
+      /**
+       * @brief Never used, all storage is static.
+       */
+      value_type*
+      allocate (std::size_t objects __attribute__((unused))) noexcept
+      {
+        assert(false);
+        return nullptr;
+      }
+
+      void
+      deallocate (value_type* p __attribute__((unused)),
+                  std::size_t objects __attribute__((unused))) noexcept
+      {
+        assert(false);
+      }
+    };
+
+  template<std::size_t N, std::size_t NameBytes, typename T>
+    constexpr std::size_t fixed_capacity_allocator<N, NameBytes, T>::threads_max_count;
+
+  template<std::size_t N, std::size_t NameBytes, typename T>
+    constexpr std::size_t fixed_capacity_allocator<N, NameBytes, T>::name_max_size_bytes;
+
+  // --------------------------------------------------------------------------
+
+  template<typename X>
+    struct capacity_voider
+    {
+      using type = void;
+    };
+
+  /**
+   * @brief The capacity configuration of an allocator; dynamic,
+   * unless the allocator defines `threads_max_count`.
+   */
+  template<typename A, typename Enable = void>
+    struct capacity_traits
+    {
+      static constexpr bool is_fixed = false;
+      static constexpr std::size_t threads_max_count = 0;
+      static constexpr std::size_t name_max_size_bytes =
+      DRTM_THREAD_NAME_MAX_SIZE_BYTES;
+    };
+
+  template<typename A>
+    struct capacity_traits<A,
+        typename capacity_voider<decltype(A::threads_max_count)>::type>
+    {
+      static constexpr bool is_fixed = true;
+      static constexpr std::size_t threads_max_count = A::threads_max_count;
+      static constexpr std::size_t name_max_size_bytes = A::name_max_size_bytes;
+    };
+
+  template<typename A, typename Enable>
+    constexpr bool capacity_traits<A, Enable>::is_fixed;
+
+  template<typename A, typename Enable>
+    constexpr std::size_t capacity_traits<A, Enable>::threads_max_count;
+
+  template<typename A, typename Enable>
+    constexpr std::size_t capacity_traits<A, Enable>::name_max_size_bytes;
+
+  template<typename A>
+    constexpr bool capacity_traits<A,
+        typename capacity_voider<decltype(A::threads_max_count)>::type>::is_fixed;
+
+  template<typename A>
+    constexpr std::size_t capacity_traits<A,
+        typename capacity_voider<decltype(A::threads_max_count)>::type>::threads_max_count;
+
+  template<typename A>
+    constexpr std::size_t capacity_traits<A,
+        typename capacity_voider<decltype(A::threads_max_count)>::type>::name_max_size_bytes;
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief A vector like container, in a static array; the subset
+   * of `std::vector` used by the threads collection.
+   *
+   * @details
+   * Elements that do not fit are dropped; `max_size()` tells
+   * the capacity.
+   */
+  template<typename T, std::size_t N>
+    class fixed_vector
+    {
+    public:
+
+      using value_type = T;
+      using size_type = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using reference = value_type&;
+      using const_reference = const value_type&;
+      using pointer = value_type*;
+      using const_pointer = const value_type*;
+      using iterator = value_type*;
+      using const_iterator = const value_type*;
+      using reverse_iterator = std::reverse_iterator<iterator>;
+      using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    public:
+
+      /**
+       * @brief The allocator is ignored, to keep the same
+       * construction as `std::vector`.
+       */
+      template<typename X>
+        fixed_vector (const X& allocator __attribute__((unused))) noexcept
+        {
+        }
+
+      // The rule of five; copies are needed to initialise arrays
+      // of vectors, like with `std::vector`.
+      fixed_vector (const fixed_vector&) = default;
+      fixed_vector (fixed_vector&&) = default;
+      fixed_vector&
+      operator= (const fixed_vector&) = default;
+      fixed_vector&
+      operator= (fixed_vector&&) = default;
+
+      ~fixed_vector () = default;
+
+    public:
+
+      inline void
+      reserve (size_type n __attribute__((unused))) noexcept
+      {
+        ; // Always reserved.
+      }
+
+      inline size_type
+      size (void) const noexcept
+      {
+        return size_;
+      }
+
+      inline constexpr size_type
+      max_size (void) const noexcept
+      {
+        return N;
+      }
+
+      inline void
+      clear (void) noexcept
+      {
+        size_ = 0;
+      }
+
+      /**
+       * @brief Shrink to a smaller size.
+       */
+      inline void
+      resize (size_type n) noexcept
+      {
+        assert(n <= size_);
+        size_ = n;
+      }
+
+      /**
+       * @brief Append, if not full; otherwise the value is dropped,
+       * so the callers that must not lose it check `size()` first.
+       */
+      void
+      push_back (const value_type& value) noexcept
+      {
+        if (size_ < N)
+          {
+            data_[size_++] = value;
+          }
+      }
+
+      /**
+       * @brief Append a range; only insertions at the end are supported.
+       */
+      void
+      insert (iterator pos __attribute__((unused)), const_pointer first,
+              const_pointer last) noexcept
+      {
+        assert(pos == end ());
+        for (; first != last && size_ < N; ++first)
+          {
+            data_[size_++] = *first;
+          }
+      }
+
+      inline reference
+      operator[] (size_type pos) noexcept
+      {
+        return data_[pos];
+      }
+
+      inline pointer
+      data (void) noexcept
+      {
+        return &data_[0];
+      }
+
+      inline iterator
+      begin (void) noexcept
+      {
+        return &data_[0];
+      }
+
+      inline iterator
+      end (void) noexcept
+      {
+        return &data_[size_];
+      }
+
+    private:
+
+      value_type data_[N];
+      size_type size_ = 0;
+    };
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief Static storage for `N` objects, constructed when needed.
+   */
+  template<typename T, std::size_t N>
+    class fixed_slots
+    {
+    public:
+
+      fixed_slots () = default;
+
+      // The rule of five.
+      fixed_slots (const fixed_slots&) = delete;
+      fixed_slots (fixed_slots&&) = delete;
+      fixed_slots&
+      operator= (const fixed_slots&) = delete;
+      fixed_slots&
+      operator= (fixed_slots&&) = delete;
+
+      ~fixed_slots () = default;
+
+    public:
+
+      /**
+       * @brief Get the storage of the next object.
+       *
+       * @return The storage, or nullptr if all are used.
+       */
+      void*
+      allocate (void) noexcept
+      {
+        if (used_ >= N)
+          {
+            return nullptr;
+          }
+        return &slots_[used_++];
+      }
+
+    private:
+
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type slots_[N];
+      std::size_t used_ = 0;
+    };
+
+  /**
+   * @brief No static storage, for dynamic configurations.
+   */
+  template<typename T>
+    class fixed_slots<T, 0>
+    {
+    public:
+
+      void*
+      allocate (void) noexcept
+      {
+        return nullptr;
+      }
+    };
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_FIXED_CAPACITY_H_ */
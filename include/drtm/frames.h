@@ -0,0 +1,659 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef DRTM_FRAMES_H_
+#define DRTM_FRAMES_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Stack frame layout policies.
+ *
+ * Each policy describes, for one architecture, the context saved on
+ * the thread stack by the µOS++ context switch handler, and must provide:
+ *
+ * - `register_size_bytes`: the size of the registers;
+ * - `context_size_words`: the size of the largest frame; the thread
+ *   context buffers are sized exactly for it;
+ * - `out_registers_size_words`: the max number of registers in
+ *   the `g` reply;
+ * - `has_variable_frames`: true if the frame layout must be decided
+ *   at run-time;
+ * - `selector_offset_words`: the offset, from SP, of the word that
+ *   decides the layout (like EXC_RETURN); not used for fixed frames;
+ * - `frame_info(selector)`: the stack info for a given selector word.
+ *
+ * All are resolved at compile time, so each build gets a decoder
+ * specialised for its frames.
+ */
+
+namespace drtm
+{
+  namespace frames
+  {
+
+    /**
+     * @brief The µOS++ Cortex-M stack frames.
+     *
+     * @details
+     * A class template only to allow the constexpr tables to be
+     * defined in the header.
+     */
+    template<typename T = void>
+      class cortex_m_tables
+      {
+      public:
+
+        // Non FP stack context, 17 words.
+        // Offsets in words, from SP up.
+
+        // Saved always by ARM.
+        // (17 optional padding/aligner)
+        // 16 xPSR (xPSR bit 9 = 1 if padded)
+        // 15 return address (PC, R15)
+        // 14 LR (R14)
+        // 13 R12
+        // 12 R3
+        // 11 R2
+        // 10 R1
+        //  9 R0
+
+        // Saved always by context switch handler.
+        // "stmdb %[r]!, {r4-r9,sl,fp,lr}"
+        //  8 EXC_RETURN (R14)
+        //  7 FP (R11)
+        //  6 SL (R10)
+        //  5 R9
+        //  4 R8
+        //  3 R7
+        //  2 R6
+        //  1 R5
+        //  0 R4 <-- new SP value
+
+        /*
+         <!DOCTYPE feature SYSTEM "gdb-target.dtd">
+         <target version="1.0">
+         <architecture>arm</architecture>
+         <feature name="org.gnu.gdb.arm.m-profile">
+         <reg name="r0" bitsize="32" regnum="0" type="uint32" group="general"/>
+         <reg name="r1" bitsize="32" regnum="1" type="uint32" group="general"/>
+         <reg name="r2" bitsize="32" regnum="2" type="uint32" group="general"/>
+         <reg name="r3" bitsize="32" regnum="3" type="uint32" group="general"/>
+         <reg name="r4" bitsize="32" regnum="4" type="uint32" group="general"/>
+         <reg name="r5" bitsize="32" regnum="5" type="uint32" group="general"/>
+         <reg name="r6" bitsize="32" regnum="6" type="uint32" group="general"/>
+         <reg name="r7" bitsize="32" regnum="7" type="uint32" group="general"/>
+         <reg name="r8" bitsize="32" regnum="8" type="uint32" group="general"/>
+         <reg name="r9" bitsize="32" regnum="9" type="uint32" group="general"/>
+         <reg name="r10" bitsize="32" regnum="10" type="uint32" group="general"/>
+         <reg name="r11" bitsize="32" regnum="11" type="uint32" group="general"/>
+         <reg name="r12" bitsize="32" regnum="12" type="uint32" group="general"/>
+         <reg name="sp" bitsize="32" regnum="13" type="data_ptr" group="general"/>
+         <reg name="lr" bitsize="32" regnum="14" type="uint32" group="general"/>
+         <reg name="pc" bitsize="32" regnum="15" type="code_ptr" group="general"/>
+         <reg name="xpsr" bitsize="32" regnum="25" type="uint32" group="general"/>
+         </feature>
+         <feature name="org.gnu.gdb.arm.m-system">
+         <reg name="msp" bitsize="32" regnum="26" type="uint32" group="general"/>
+         <reg name="psp" bitsize="32" regnum="27" type="uint32" group="general"/>
+         <reg name="primask" bitsize="32" regnum="28" type="uint32" group="general"/>
+         <reg name="basepri" bitsize="32" regnum="29" type="uint32" group="general"/>
+         <reg name="faultmask" bitsize="32" regnum="30" type="uint32" group="general"/>
+         <reg name="control" bitsize="32" regnum="31" type="uint32" group="general"/>
+         </feature>
+         </target>
+         */
+
+        // This table encodes the offsets in the µOS++ non-VFP stack frame for the
+        // registers defined in the previous XML.
+        // Offsets are from the saved SP to each register, in 32-bits words.
+        // The table is indexed by register index, which is the GDB regnum for
+        // R0-R15 and regnum - 9 for the rest (xPSR is 16, FPSCR is 23,
+        // S0-S31 are 24-55). The FP entries are present in both tables,
+        // so that both have the same size.
+        //
+        // Special cases:
+        // -1 return as 0x00000000
+        // -2 SP should be taken from TCB, not from the context.
+        static constexpr register_offset_t basic_offsets[] =
+          {
+            9, // R0
+            10, // R1
+            11, // R2
+            12, // R3
+            0, // R4
+            1, // R5
+            2, // R6
+            3, // R7
+            4, // R8
+            5, // R9
+            6, // R10
+            7, // R11
+            13, // R12
+            -2, // SP
+            14, // LR
+            15, // PC
+            16, // XPSR
+
+            -1, // MSP
+            -1, // PSP
+            -1, // PRIMASK
+            -1, // BASEPRI
+            -1, // FAULTMASK
+            -1, // CONTROL
+
+            // No FP context was saved, the thread did not use the FPU.
+            -1, // FPSCR
+            -1, // S0
+            -1, // S1
+            -1, // S2
+            -1, // S3
+            -1, // S4
+            -1, // S5
+            -1, // S6
+            -1, // S7
+            -1, // S8
+            -1, // S9
+            -1, // S10
+            -1, // S11
+            -1, // S12
+            -1, // S13
+            -1, // S14
+            -1, // S15
+            -1, // S16
+            -1, // S17
+            -1, // S18
+            -1, // S19
+            -1, // S20
+            -1, // S21
+            -1, // S22
+            -1, // S23
+            -1, // S24
+            -1, // S25
+            -1, // S26
+            -1, // S27
+            -1, // S28
+            -1, // S29
+            -1, // S30
+            -1, // S31
+          };
+
+        static constexpr stack_info_t basic_info =
+          {
+          //
+              .in_registers = 13 + 2 + 1 + 1, // R0-R12, LR, PC + EXC_RETURN + xPSR
+              .core_in_registers = 13 + 2 + 1 + 1, // All of them
+              .out_registers = 16 + 1, // R0-R15 + xPSR
+              .offsets = basic_offsets, //
+              .offsets_size = sizeof(basic_offsets)
+                  / sizeof(basic_offsets[0]), //
+              .is_floating_point = false,
+          /**/
+          };
+
+        // FP stack context, 50 words.
+        // Offsets in words, from SP up.
+
+        // Saved always by ARM.
+        // (50 optional padding/aligner)
+        // 49 FPSCR
+        // 48 S15
+        // ...
+        // 34 S1
+        // 33 S0
+        // 32 xPSR (xPSR bit 9 = 1 if padded)
+        // 31 return address (PC, R15)
+        // 30 LR (R14)
+        // 29 R12
+        // 28 R3
+        // 27 R2
+        // 26 R1
+        // 25 R0
+
+        // Saved conditionally if EXC_RETURN, bit 4 is 0 (zero).
+        // "vldmiaeq %[r]!, {s16-s31}"
+        // 24 S31
+        // 23 S30
+        // ...
+        // 10 S17
+        //  9 S16
+
+        // Saved always by context switch handler.
+        // "stmdb %[r]!, {r4-r9,sl,fp,lr}"
+        //  8 EXC_RETURN (R14)
+        //  7 FP (R11)
+        //  6 SL (R10)
+        //  5 R9
+        //  4 R8
+        //  3 R7
+        //  2 R6
+        //  1 R5
+        //  0 R4 <-- new SP value
+
+        /*
+         <!DOCTYPE feature SYSTEM "gdb-target.dtd">
+         <target version="1.0">
+         <architecture>arm</architecture>
+         <feature name="org.gnu.gdb.arm.m-profile">
+         <reg name="r0" bitsize="32" regnum="0" type="uint32" group="general"/>
+         <reg name="r1" bitsize="32" regnum="1" type="uint32" group="general"/>
+         <reg name="r2" bitsize="32" regnum="2" type="uint32" group="general"/>
+         <reg name="r3" bitsize="32" regnum="3" type="uint32" group="general"/>
+         <reg name="r4" bitsize="32" regnum="4" type="uint32" group="general"/>
+         <reg name="r5" bitsize="32" regnum="5" type="uint32" group="general"/>
+         <reg name="r6" bitsize="32" regnum="6" type="uint32" group="general"/>
+         <reg name="r7" bitsize="32" regnum="7" type="uint32" group="general"/>
+         <reg name="r8" bitsize="32" regnum="8" type="uint32" group="general"/>
+         <reg name="r9" bitsize="32" regnum="9" type="uint32" group="general"/>
+         <reg name="r10" bitsize="32" regnum="10" type="uint32" group="general"/>
+         <reg name="r11" bitsize="32" regnum="11" type="uint32" group="general"/>
+         <reg name="r12" bitsize="32" regnum="12" type="uint32" group="general"/>
+         <reg name="sp" bitsize="32" regnum="13" type="data_ptr" group="general"/>
+         <reg name="lr" bitsize="32" regnum="14" type="uint32" group="general"/>
+         <reg name="pc" bitsize="32" regnum="15" type="code_ptr" group="general"/>
+         <reg name="xpsr" bitsize="32" regnum="25" type="uint32" group="general"/>
+         </feature>
+         <feature name="org.gnu.gdb.arm.m-system">
+         <reg name="msp" bitsize="32" regnum="26" type="uint32" group="general"/>
+         <reg name="psp" bitsize="32" regnum="27" type="uint32" group="general"/>
+         <reg name="primask" bitsize="32" regnum="28" type="uint32" group="general"/>
+         <reg name="basepri" bitsize="32" regnum="29" type="uint32" group="general"/>
+         <reg name="faultmask" bitsize="32" regnum="30" type="uint32" group="general"/>
+         <reg name="control" bitsize="32" regnum="31" type="uint32" group="general"/>
+         </feature>
+         <feature name="org.gnu.gdb.arm.m-float">
+         <reg name="fpscr" bitsize="32" regnum="32" type="uint32" group="float"/>
+         <reg name="s0" bitsize="32" regnum="33" type="float" group="float"/>
+         <reg name="s1" bitsize="32" regnum="34" type="float" group="float"/>
+         <reg name="s2" bitsize="32" regnum="35" type="float" group="float"/>
+         <reg name="s3" bitsize="32" regnum="36" type="float" group="float"/>
+         <reg name="s4" bitsize="32" regnum="37" type="float" group="float"/>
+         <reg name="s5" bitsize="32" regnum="38" type="float" group="float"/>
+         <reg name="s6" bitsize="32" regnum="39" type="float" group="float"/>
+         <reg name="s7" bitsize="32" regnum="40" type="float" group="float"/>
+         <reg name="s8" bitsize="32" regnum="41" type="float" group="float"/>
+         <reg name="s9" bitsize="32" regnum="42" type="float" group="float"/>
+         <reg name="s10" bitsize="32" regnum="43" type="float" group="float"/>
+         <reg name="s11" bitsize="32" regnum="44" type="float" group="float"/>
+         <reg name="s12" bitsize="32" regnum="45" type="float" group="float"/>
+         <reg name="s13" bitsize="32" regnum="46" type="float" group="float"/>
+         <reg name="s14" bitsize="32" regnum="47" type="float" group="float"/>
+         <reg name="s15" bitsize="32" regnum="48" type="float" group="float"/>
+         <reg name="s16" bitsize="32" regnum="49" type="float" group="float"/>
+         <reg name="s17" bitsize="32" regnum="50" type="float" group="float"/>
+         <reg name="s18" bitsize="32" regnum="51" type="float" group="float"/>
+         <reg name="s19" bitsize="32" regnum="52" type="float" group="float"/>
+         <reg name="s20" bitsize="32" regnum="53" type="float" group="float"/>
+         <reg name="s21" bitsize="32" regnum="54" type="float" group="float"/>
+         <reg name="s22" bitsize="32" regnum="55" type="float" group="float"/>
+         <reg name="s23" bitsize="32" regnum="56" type="float" group="float"/>
+         <reg name="s24" bitsize="32" regnum="57" type="float" group="float"/>
+         <reg name="s25" bitsize="32" regnum="58" type="float" group="float"/>
+         <reg name="s26" bitsize="32" regnum="59" type="float" group="float"/>
+         <reg name="s27" bitsize="32" regnum="60" type="float" group="float"/>
+         <reg name="s28" bitsize="32" regnum="61" type="float" group="float"/>
+         <reg name="s29" bitsize="32" regnum="62" type="float" group="float"/>
+         <reg name="s30" bitsize="32" regnum="63" type="float" group="float"/>
+         <reg name="s31" bitsize="32" regnum="64" type="float" group="float"/>
+         </feature>
+         </target>
+         */
+
+        // This table encodes the offsets in the µOS++ VFP stack frame for the
+        // registers defined in the previous XML.
+        // Used conditionally if EXC_RETURN, bit 4 is 0 (zero).
+        // The core registers are all in the first 33 words (R4-R11, S16-S31,
+        // R0-R3, R12, LR, PC, xPSR); S0-S15 and FPSCR, above them, are
+        // read only when a FP register is requested.
+        static constexpr register_offset_t extended_offsets[] =
+          {
+            25, // R0
+            26, // R1
+            27, // R2
+            28, // R3
+            0, // R4
+            1, // R5
+            2, // R6
+            3, // R7
+            4, // R8
+            5, // R9
+            6, // R10
+            7, // R11
+            29, // R12
+            -2, // SP
+            30, // LR
+            31, // PC
+            32, // XPSR
+
+            -1, // MSP
+            -1, // PSP
+            -1, // PRIMASK
+            -1, // BASEPRI
+            -1, // FAULTMASK
+            -1, // CONTROL
+            49, // FPSCR
+            33, // S0
+            34, // S1
+            35, // S2
+            36, // S3
+            37, // S4
+            38, // S5
+            39, // S6
+            40, // S7
+            41, // S8
+            42, // S9
+            43, // S10
+            44, // S11
+            45, // S12
+            46, // S13
+            47, // S14
+            48, // S15
+            9, // S16
+            10, // S17
+            11, // S18
+            12, // S19
+            13, // S20
+            14, // S21
+            15, // S22
+            16, // S23
+            17, // S24
+            18, // S25
+            19, // S26
+            20, // S27
+            21, // S28
+            22, // S29
+            23, // S30
+            24, // S31
+          };
+
+        static constexpr stack_info_t extended_info =
+          {
+          //
+              .in_registers = 13 + 2 + 1 + 1 + 32 + 1, // R0-R12, LR, PC + EXC_RETURN + xPSR + S0-S31 + FPSCR
+              .core_in_registers = 32 + 1, // Up to xPSR, S16-S31 included
+              .out_registers = 16 + 1, // R0-R15 + xPSR
+              .offsets = extended_offsets, //
+              .offsets_size = sizeof(extended_offsets)
+                  / sizeof(extended_offsets[0]), //
+              .is_floating_point = true,
+          /**/
+          };
+
+        // Both frames, indexed by the `is extended` condition.
+        static constexpr const stack_info_t* infos[] =
+          { &basic_info, &extended_info };
+      };
+
+    template<typename T>
+      constexpr register_offset_t cortex_m_tables<T>::basic_offsets[];
+
+    template<typename T>
+      constexpr stack_info_t cortex_m_tables<T>::basic_info;
+
+    template<typename T>
+      constexpr register_offset_t cortex_m_tables<T>::extended_offsets[];
+
+    template<typename T>
+      constexpr stack_info_t cortex_m_tables<T>::extended_info;
+
+    template<typename T>
+      constexpr const stack_info_t* cortex_m_tables<T>::infos[];
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Cortex-M3, and Cortex-M4/M7 without FPU (ARMv7-M).
+     *
+     * @details
+     * Threads never save FP registers, so there is a single frame
+     * and no need to read EXC_RETURN.
+     */
+    struct cortex_m3
+    {
+      static constexpr std::size_t register_size_bytes = 4;
+      static constexpr std::size_t context_size_words = 17;
+      static constexpr std::size_t out_registers_size_words = 17;
+
+      static constexpr bool has_variable_frames = false;
+      static constexpr std::size_t selector_offset_words = 0;
+
+      static inline const stack_info_t*
+      frame_info (uint32_t selector __attribute__((unused)))
+      {
+        return &cortex_m_tables<>::basic_info;
+      }
+    };
+
+    using cortex_m4 = cortex_m3;
+    using cortex_m7 = cortex_m3;
+
+    /**
+     * @brief Cortex-M0/M0+ (ARMv6-M).
+     *
+     * @details
+     * ARMv6-M cannot store the high registers with a single `stmdb`,
+     * but the port saves them in several steps, in the same order,
+     * so the layout is the same as ARMv7-M without FPU.
+     */
+    struct cortex_m0 : cortex_m3
+    {
+    };
+
+    /**
+     * @brief Cortex-M33 without FPU (ARMv8-M mainline, non-secure).
+     */
+    struct cortex_m33 : cortex_m3
+    {
+    };
+
+    /**
+     * @brief Cortex-M4 with FPU (ARMv7E-M, FPv4-SP).
+     *
+     * @details
+     * The extended frame is used when EXC_RETURN, saved in the
+     * context, is valid and has bit 4 (FType) 0 (zero).
+     */
+    struct cortex_m4f
+    {
+      static constexpr std::size_t register_size_bytes = 4;
+      static constexpr std::size_t context_size_words = 50;
+      static constexpr std::size_t out_registers_size_words = 17;
+
+      static constexpr bool has_variable_frames = true;
+      // Tells how far up is the EXC word.
+      static constexpr std::size_t selector_offset_words = 8;
+
+      static inline const stack_info_t*
+      frame_info (uint32_t exc_return)
+      {
+        // Branch-free; the conditions are evaluated as integers.
+        std::size_t is_extended =
+            static_cast<std::size_t> ((exc_return & 0xFFFFFFE3) == 0xFFFFFFE1)
+                & ((exc_return >> 4) ^ 1) & 1;
+
+        return cortex_m_tables<>::infos[is_extended];
+      }
+    };
+
+    /**
+     * @brief Cortex-M7 with FPU (ARMv7E-M, FPv5); the frame is the
+     * same as on Cortex-M4.
+     */
+    using cortex_m7f = cortex_m4f;
+
+    /**
+     * @brief Cortex-M33 with FPU (ARMv8-M mainline, non-secure).
+     *
+     * @details
+     * The ARMv8-M EXC_RETURN has the top 25 bits set, and more
+     * information in the low bits, but FType is still bit 4.
+     */
+    struct cortex_m33f : cortex_m4f
+    {
+      static inline const stack_info_t*
+      frame_info (uint32_t exc_return)
+      {
+        std::size_t is_extended =
+            static_cast<std::size_t> ((exc_return & 0xFFFFFF80) == 0xFFFFFF80)
+                & ((exc_return >> 4) ^ 1) & 1;
+
+        return cortex_m_tables<>::infos[is_extended];
+      }
+    };
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief The RISC-V stack frame (provisional).
+     *
+     * @details
+     * The layout is provisional, it is not yet backed by a µOS++
+     * RISC-V port, and may change when the port context switch
+     * handler is available.
+     *
+     * A class template only to allow the constexpr tables to be
+     * defined in the header.
+     */
+    template<typename T = void>
+      class riscv_tables
+      {
+      public:
+
+        // RV32 stack context, 31 words.
+        // Offsets in words, from SP up.
+
+        // Saved always by context switch handler.
+        // 30 mepc (PC)
+        // 29 x31 (t6)
+        // ...
+        //  2 x4 (tp)
+        //  1 x3 (gp)
+        //  0 x1 (ra) <-- new SP value
+
+        // x0 is always zero and x2 (sp) is saved in the TCB.
+
+        // This table encodes the offsets for the registers in the
+        // `org.gnu.gdb.riscv.cpu` feature (x0-x31, pc), in GDB
+        // regnum order.
+        // Special cases:
+        // -1 return as 0x00000000
+        // -2 SP should be taken from TCB, not from the context.
+        static constexpr register_offset_t offsets[] =
+          {
+              -1, // x0 (zero)
+              0, // x1 (ra)
+              -2, // x2 (sp)
+              1, // x3 (gp)
+              2, // x4 (tp)
+              3, // x5 (t0)
+              4, // x6 (t1)
+              5, // x7 (t2)
+              6, // x8 (s0/fp)
+              7, // x9 (s1)
+              8, // x10 (a0)
+              9, // x11 (a1)
+              10, // x12 (a2)
+              11, // x13 (a3)
+              12, // x14 (a4)
+              13, // x15 (a5)
+              14, // x16 (a6)
+              15, // x17 (a7)
+              16, // x18 (s2)
+              17, // x19 (s3)
+              18, // x20 (s4)
+              19, // x21 (s5)
+              20, // x22 (s6)
+              21, // x23 (s7)
+              22, // x24 (s8)
+              23, // x25 (s9)
+              24, // x26 (s10)
+              25, // x27 (s11)
+              26, // x28 (t3)
+              27, // x29 (t4)
+              28, // x30 (t5)
+              29, // x31 (t6)
+              30, // pc
+          };
+
+        static constexpr stack_info_t info =
+          {
+          //
+              .in_registers = 1 + 29 + 1, // x1, x3-x31, mepc
+              .core_in_registers = 1 + 29 + 1, // All of them
+              .out_registers = 32 + 1, // x0-x31 + pc
+              .offsets = offsets, //
+              .offsets_size = sizeof(offsets) / sizeof(offsets[0]), //
+              .is_floating_point = false,
+          /**/
+          };
+      };
+
+    template<typename T>
+      constexpr register_offset_t riscv_tables<T>::offsets[];
+
+    template<typename T>
+      constexpr stack_info_t riscv_tables<T>::info;
+
+    /**
+     * @brief RISC-V RV32I/RV32IMAC, integer registers only
+     * (provisional).
+     */
+    struct riscv_rv32
+    {
+      static constexpr std::size_t register_size_bytes = 4;
+      static constexpr std::size_t context_size_words = 31;
+      static constexpr std::size_t out_registers_size_words = 33;
+
+      static constexpr bool has_variable_frames = false;
+      static constexpr std::size_t selector_offset_words = 0;
+
+      static inline const stack_info_t*
+      frame_info (uint32_t selector __attribute__((unused)))
+      {
+        return &riscv_tables<>::info;
+      }
+    };
+
+  // --------------------------------------------------------------------------
+  } /* namespace frames */
+
+  // The frame policy used when none is specified, compatible with
+  // all Cortex-M4/M7 builds, with or without FPU.
+  using default_frame_type = frames::cortex_m4f;
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_FRAMES_H_ */
@@ -31,28 +31,92 @@
 #if defined(__cplusplus)
 
 #include <drtm/types.h>
+#include <drtm/sink.h>
+#include <drtm/frames.h>
 #include <drtm/metadata.h>
 #include <drtm/threads.h>
 #include <drtm/run-time-data.h>
+#include <drtm/snapshot.h>
+#include <drtm/memory.h>
 
 #include <stdio.h>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+
+// The most times an update is read again, if the threads changed
+// while the target was running.
+#if !defined(DRTM_CONSISTENT_RETRIES_MAX_COUNT)
+#define DRTM_CONSISTENT_RETRIES_MAX_COUNT   8
+#endif
+
+// The delay before the first retry, doubled for each retry.
+#if !defined(DRTM_CONSISTENT_BACKOFF_MIN_US)
+#define DRTM_CONSISTENT_BACKOFF_MIN_US   100
+#endif
+
+#if !defined(DRTM_CONSISTENT_BACKOFF_MAX_US)
+#define DRTM_CONSISTENT_BACKOFF_MAX_US   10000
+#endif
 
 namespace drtm
 {
 
-  template<typename B, typename A>
+  /**
+   * @brief Wait, via the backend, if it has a `delay_us()`.
+   *
+   * @retval true The backend waited.
+   * @retval false No delay function, did not wait.
+   */
+  template<typename B>
+    inline auto
+    backend_delay_us (B& backend, uint32_t us, int)
+    -> decltype(backend.delay_us (us), bool ())
+    {
+      backend.delay_us (us);
+      return true;
+    }
+
+  template<typename B>
+    inline bool
+    backend_delay_us (B& backend __attribute__((unused)),
+                      uint32_t us __attribute__((unused)), long)
+    {
+      return false;
+    }
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * A class template to implement the functions called by the
+   * GDB server.
+   *
+   * The threads are kept in two snapshots; the queries use the
+   * published one, without locks, while `update_thread_list()`
+   * rebuilds the other one and publishes it at the end. Queries
+   * may come from any host thread; updates from one host thread
+   * at a time.
+   *
+   * @tparam F The stack frame layout policy, from `frames.h`.
+   * @tparam M The metadata, parsed from the target (`metadata`) or
+   *  known at compile time (`static_metadata`).
+   */
+  template<typename B, typename A, typename F = default_frame_type,
+      typename M = metadata<B>>
     class frontend
     {
     public:
 
       using backend_type = B;
       using allocator_type = A;
+      using frame_type = F;
 
-      using metadata_type = class metadata<B>;
-      using threads_type = class threads<B, A>;
-      using rtd_type = class run_time_data<B, A>;
+      using metadata_type = M;
+      using threads_type = class threads<B, A, F>;
+      using rtd_type = class run_time_data<B, A, F, M>;
+      using snapshots_type = class snapshots<B, A, F, M>;
+      using snapshot_type = typename snapshots_type::snapshot_type;
+      using progress_type = typename rtd_type::progress_type;
 
       using thread_type = typename threads_type::thread_type;
       using thread_id_t = typename thread_type::thread_id_t;
@@ -88,20 +152,60 @@ namespace drtm
        * information within this function at once, so later requests can
        * be served without further communication to the target.
        *
-       * @par Parameters
-       *  None.
+       * While single stepping, use `update_mode::step`; once the
+       * scheduler was seen started, the header and `is_started` are
+       * not read again, and, if the running thread and the top threads
+       * list did not change (two transactions), the snapshot is kept;
+       * otherwise a full update is performed.
+       *
+       * If the target provides the thread lists generation (DRTM
+       * v1.2), a full update does not walk the lists again while
+       * the generation does not change.
+       *
+       * If the target provides the sequence counter (DRTM v1.4), it
+       * is read before and after the threads, and, if it changed,
+       * the threads are read again, after a delay, so the snapshot
+       * is consistent even if the target is running. After
+       * `DRTM_CONSISTENT_RETRIES_MAX_COUNT` retries the snapshot is
+       * published anyway, with a warning.
+       *
+       * @param mode The update mode.
        *
        * @retval 0 Updating threads OK.
        * @retval <0 Updating threads failed.
        */
       int
-      update_thread_list (void)
+      update_thread_list (update_mode mode = update_mode::full)
       {
 #if defined(DEBUG)
-        printf ("%s()\n", __func__);
+        printf ("%s(%s)\n", __func__,
+                (mode == update_mode::step) ? "step" : "full");
+#endif /* defined(DEBUG) */
+
+        if (progress_.is_active ())
+          {
+            // Complete the budgeted update.
+            return update_thread_list (mode, update_budget_t
+              { 0, 0 });
+          }
+
+        if (mode == update_mode::step && is_snapshot_current ())
+          {
+#if defined(DEBUG)
+            printf ("%s()=0 unchanged\n", __func__);
 #endif /* defined(DEBUG) */
+            return 0;
+          }
+
+        // Wait for the readers of the older snapshot to leave it, and
+        // rebuild it while the readers use the published one.
+        snapshot_type* s = snapshots_.back ();
 
-        if (!metadata_.parse ())
+        // The target transactions are serialised, one at a time,
+        // with the lazy reads. The header is read once; the retries
+        // read it again only if the sequence counter could not be
+        // read, which may mean the firmware was reflashed.
+        if (!parse_metadata ())
           {
 #if defined(DEBUG)
             printf ("%s()=-1 no drtm\n", __func__);
@@ -109,23 +213,258 @@ namespace drtm
             return -1;
           }
 
-        is_scheduler_started_ = rt_.is_scheduler_started ();
-
-        if (!is_scheduler_started_)
+        uint32_t backoff_us = DRTM_CONSISTENT_BACKOFF_MIN_US;
+        for (uint32_t retries = 0;; ++retries)
           {
-            threads_.clear ();
+            uint32_t sequence = 0;
+            bool is_checked;
+            bool is_consistent = true;
+
+            {
+              if (retries > 0 && s->rt.is_sequence_read_failed ()
+                  && !parse_metadata ())
+                {
+#if defined(DEBUG)
+                  printf ("%s()=-1 no drtm\n", __func__);
+#endif /* defined(DEBUG) */
+                  return -1;
+                }
+
+              is_checked = consistent_reads_
+                  && s->rt.begin_consistent_read (&sequence);
+
+              s->is_scheduler_started = s->rt.is_scheduler_started ();
+
+              if (s->is_scheduler_started)
+                {
+                  s->rt.update_threads ();
+                }
+              else
+                {
+                  s->rt.clear_threads ();
+                }
+
+              if (is_checked)
+                {
+                  is_consistent = s->rt.end_consistent_read (sequence);
+                }
+            }
+
+            if (!is_checked)
+              {
+                break;
+              }
+
+            if (is_consistent || retries == DRTM_CONSISTENT_RETRIES_MAX_COUNT)
+              {
+                ++consistency_statistics_.updates_count;
+                consistency_statistics_.retries_count += retries;
+                consistency_statistics_.retries_max_count = std::max (
+                    consistency_statistics_.retries_max_count, retries);
+                if (!is_consistent)
+                  {
+                    ++consistency_statistics_.failures_count;
+                    backend_.output_warning (
+                        "Threads changed while read, may be inconsistent.\n");
+                  }
+                break;
+              }
 
+#if defined(DEBUG)
+            printf ("%s() retry %u\n", __func__, retries + 1);
+#endif /* defined(DEBUG) */
+
+            // Without locks, the target may need a while to finish;
+            // without a backend delay, retry right away.
+            backend_delay_us (backend_, backoff_us, 0);
+            backoff_us = std::min<uint32_t> (backoff_us * 2,
+            DRTM_CONSISTENT_BACKOFF_MAX_US);
+          }
+
+        s->is_complete = true;
+
+        if (s->is_scheduler_started)
+          {
+            // Render all descriptions once per snapshot; unchanged
+            // descriptions are reused from the previous snapshot.
+            s->threads.prepare_descriptions ();
+          }
+        else
+          {
 #if defined(DEBUG)
             printf ("%s()=0 no scheduler\n", __func__);
+#endif /* defined(DEBUG) */
+          }
+
+        snapshots_.publish (s);
+
+        return 0;
+      }
+
+      /**
+       * @brief Update the thread information from the target, within
+       * a budget, for slow links.
+       *
+       * @details
+       * The threads running on each core are read first, then the
+       * others, highest priority first, until the budget (target
+       * transactions or duration) is exhausted; the threads read
+       * so far are published, and `is_thread_list_complete()`
+       * returns false. The next call, with or without a budget,
+       * continues where this one stopped; if, meanwhile, the running
+       * threads or the lists changed (like after the target ran),
+       * it starts again.
+       *
+       * The sequence counter is not checked by the budgeted updates.
+       *
+       * @param mode The update mode.
+       * @param budget The limits of this call; zero means no limit.
+       *
+       * @retval 0 Updating threads OK, maybe not complete.
+       * @retval <0 Updating threads failed.
+       */
+      int
+      update_thread_list (update_mode mode, const update_budget_t& budget)
+      {
+#if defined(DEBUG)
+        printf ("%s(%s, %u, %u)\n", __func__,
+                (mode == update_mode::step) ? "step" : "full",
+                budget.transactions_max_count, budget.duration_max_us);
+#endif /* defined(DEBUG) */
+
+        if (!progress_.is_active () && mode == update_mode::step
+            && is_snapshot_current ())
+          {
+#if defined(DEBUG)
+            printf ("%s()=0 unchanged\n", __func__);
 #endif /* defined(DEBUG) */
             return 0;
           }
 
-        rt_.update_threads ();
+        snapshot_type* s = snapshots_.back ();
+
+        if (!resume_update (s))
+          {
+#if defined(DEBUG)
+            printf ("%s()=-1 no drtm\n", __func__);
+#endif /* defined(DEBUG) */
+            return -1;
+          }
+
+        if (s->is_scheduler_started)
+          {
+            s->is_complete = s->rt.update_threads (progress_, budget);
+          }
+        else
+          {
+            s->rt.clear_threads ();
+            s->is_complete = true;
+          }
+
+        if (s->is_scheduler_started)
+          {
+            s->threads.prepare_descriptions ();
+          }
+
+        snapshots_.publish (s);
 
         return 0;
       }
 
+      /**
+       * @brief Start a new enumeration of the threads, to be
+       * streamed by `next_thread_ids()`.
+       *
+       * @details
+       * Any budgeted update in progress is abandoned; no target
+       * accesses.
+       */
+      void
+      begin_thread_enumeration (void)
+      {
+#if defined(DEBUG)
+        printf ("%s()\n", __func__);
+#endif /* defined(DEBUG) */
+
+        progress_.reset ();
+      }
+
+      /**
+       * @brief Get the IDs of the next threads found, without
+       * waiting for the whole enumeration.
+       *
+       * @details
+       * Intended for `qfThreadInfo`/`qsThreadInfo`: each call
+       * advances the enumeration only until `max_count` new IDs are
+       * found (the running threads first) and returns them, so the
+       * server can answer each packet right away. The IDs are
+       * returned once per enumeration; if the threads changed
+       * meanwhile (like after the target ran), the enumeration
+       * starts again, and the IDs are returned again.
+       *
+       * This is a budgeted update with no details read; the streamed
+       * threads are published, without their details, and
+       * `update_thread_list()`, with or without a budget, continues
+       * with them. Until then, their descriptions are the default
+       * one and their registers are not available (<0).
+       *
+       * @param ids The output array.
+       * @param max_count The size of the output array.
+       *
+       * @return The number of IDs; 0 after the last one;
+       *  <0 if the update failed.
+       */
+      int
+      next_thread_ids (thread_id_t* ids, std::size_t max_count)
+      {
+#if defined(DEBUG)
+        printf ("%s(%p, %zu)\n", __func__, ids, max_count);
+#endif /* defined(DEBUG) */
+
+        snapshot_type* s = snapshots_.back ();
+        std::size_t count = 0;
+
+        if (!resume_update (s))
+          {
+#if defined(DEBUG)
+            printf ("%s()=-1 no drtm\n", __func__);
+#endif /* defined(DEBUG) */
+            return -1;
+          }
+
+        if (s->is_scheduler_started)
+          {
+            count = s->rt.stream_thread_ids (progress_, ids, max_count);
+            s->is_complete = !progress_.is_active ();
+          }
+        else
+          {
+            s->rt.clear_threads ();
+            s->is_complete = true;
+          }
+
+        if (s->is_scheduler_started)
+          {
+            s->threads.prepare_descriptions ();
+          }
+
+        snapshots_.publish (s);
+
+        return static_cast<int> (count);
+      }
+
+      /**
+       * @brief Tell if the last update read all threads.
+       */
+      bool
+      is_thread_list_complete (void)
+      {
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        return snap->is_complete;
+      }
+
       /**
        * @brief Get the number of threads.
        *
@@ -145,7 +484,10 @@ namespace drtm
         printf ("%s()\n", __func__);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        if (!snap->is_scheduler_started)
           {
 #if defined(DEBUG)
             printf ("%s()=0 no scheduler\n", __func__);
@@ -154,10 +496,10 @@ namespace drtm
           }
 
 #if defined(DEBUG)
-        printf ("%s()=%zu\n", __func__, threads_.size ());
+        printf ("%s()=%zu\n", __func__, snap->threads.size ());
 #endif /* defined(DEBUG) */
 
-        return threads_.size ();
+        return snap->threads.size ();
       }
 
       /**
@@ -178,12 +520,21 @@ namespace drtm
         printf ("%s(%zu)\n", __func__, index);
 #endif /* defined(DEBUG) */
 
-        assert(index < threads_.size ());
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        // With concurrent updates, the index may refer to an older
+        // snapshot.
+        if (index >= snap->threads.size ())
+          {
+            return thread_type::id_none;
+          }
+
 #if defined(DEBUG)
-        printf ("%s(%zu)=%u\n", __func__, index, threads_[index]->id ());
+        printf ("%s(%zu)=%u\n", __func__, index, snap->threads[index]->id ());
 #endif /* defined(DEBUG) */
 
-        return threads_[index]->id ();
+        return snap->threads[index]->id ();
       }
 
       /**
@@ -191,7 +542,8 @@ namespace drtm
        *
        * @details
        * For single core devices, there is only one thread running
-       * and the scheduler obviously knows it.
+       * and the scheduler obviously knows it. For multi-core devices,
+       * this is the thread running on the first core.
        *
        * @par Parameters
        *  None.
@@ -205,7 +557,10 @@ namespace drtm
         printf ("%s()\n", __func__);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        if (!snap->is_scheduler_started)
           {
 #if defined(DEBUG)
             printf ("%s()=%d no scheduler\n", __func__, thread_type::id_none);
@@ -214,7 +569,7 @@ namespace drtm
             return thread_type::id_none;
           }
 
-        if (threads_.current () == nullptr)
+        if (snap->threads.current () == nullptr)
           {
 #if defined(DEBUG)
             printf ("%s()=%d null\n", __func__, thread_type::id_none);
@@ -224,12 +579,140 @@ namespace drtm
           }
 
 #if defined(DEBUG)
-        printf ("%s()=%u\n", __func__, threads_.current ()->id ());
+        printf ("%s()=%u\n", __func__, snap->threads.current ()->id ());
+#endif /* defined(DEBUG) */
+
+        return snap->threads.current ()->id ();
+      }
+
+      /**
+       * @brief Get the number of cores.
+       *
+       * @details
+       * Single core targets, and targets with older DRTM headers,
+       * have one core.
+       *
+       * @return The number of cores, at least 1.
+       */
+      std::size_t
+      get_cores_count (void)
+      {
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        return snap->threads.cores_count ();
+      }
+
+      /**
+       * @brief Get the ID of the thread running on a core.
+       *
+       * @details
+       * All these threads have their registers in the cores,
+       * not on the stack.
+       *
+       * @param core The core index, from 0.
+       * @return The ID of the thread, or `id_none` if not known.
+       */
+      thread_id_t
+      get_current_thread_id (std::size_t core)
+      {
+#if defined(DEBUG)
+        printf ("%s(%zu)\n", __func__, core);
 #endif /* defined(DEBUG) */
 
-        return threads_.current ()->id ();
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        if (!snap->is_scheduler_started)
+          {
+            return thread_type::id_none;
+          }
+
+        thread_type* th = snap->threads.current (core);
+        if (th == nullptr)
+          {
+            return thread_type::id_none;
+          }
+
+        return th->id ();
       }
 
+      /**
+       * @brief Call a visitor for each thread of the published snapshot.
+       *
+       * @details
+       * The snapshot is pinned during the visit; the visitor
+       * is called with the thread and a flag telling if the thread
+       * is running, and must not keep the pointer.
+       *
+       * @tparam V Type of the visitor, callable as
+       *  `void (thread_type*, bool)`.
+       * @return The number of visited threads.
+       */
+      template<typename V>
+        std::size_t
+        visit_threads (V&& visitor)
+        {
+          typename snapshots_type::reader snap
+            { snapshots_ };
+
+          if (!snap->is_scheduler_started)
+            {
+              return 0;
+            }
+
+          for (auto* th : snap->threads)
+            {
+              visitor (th, snap->threads.is_current (th->id ()));
+            }
+
+          return snap->threads.size ();
+        }
+
+      /**
+       * @brief Get the printable thread name.
+       *
+       * @details
+       * The name may contain extra information about the tread’s
+       * status (running/suspended, priority, etc.).
+       *
+       * The description is written directly to the sink (for example
+       * the `qThreadExtraInfo` reply buffer); the sink keeps the exact
+       * length accounting, including the characters that did not fit.
+       *
+       * @tparam O Type of the sink output iterator.
+       * @param [in] tid ID of the thread.
+       * @param [out] out The sink where the description is written.
+       *
+       * @return The number of characters written to the sink.
+       */
+      template<typename O>
+        std::size_t
+        get_thread_description (thread_id_t tid, sink<O>& out)
+        {
+#if defined(DEBUG)
+          printf ("%s(*, %u)\n", __func__, tid);
+#endif /* defined(DEBUG) */
+
+          typename snapshots_type::reader snap
+            { snapshots_ };
+
+          std::size_t length = out.length ();
+
+          // The threads whose IDs were streamed may not be read yet.
+          thread_type* td = snap->threads.thread (tid);
+          if (snap->is_scheduler_started && td != nullptr && td->is_read ())
+            {
+              snap->threads.output_description (td, out);
+            }
+          else
+            {
+              out.write (thread_type::default_description);
+            }
+
+          return out.length () - length;
+        }
+
       /**
        * @brief Get the printable thread name.
        *
@@ -248,24 +731,14 @@ namespace drtm
       get_thread_description (thread_id_t tid, char* out_description,
                               std::size_t out_size_bytes)
       {
-#if defined(DEBUG)
-        printf ("%s(*, %u)\n", __func__, tid);
-#endif /* defined(DEBUG) */
-
         assert(out_description != NULL);
+        assert(out_size_bytes > 0);
 
-        thread_type* td = threads_.thread (tid);
-        std::size_t count = 0;
-        if (is_scheduler_started_ && td != nullptr)
-          {
-            count = td->prepare_description (out_description, out_size_bytes);
-          }
-        else
-          {
-            assert(std::strlen (thread_type::default_description) < 256);
-            std::strcpy (out_description, thread_type::default_description);
-            count = std::strlen (thread_type::default_description);
-          }
+        // Keep space for the terminator.
+        sink<char*> out
+          { out_description, out_size_bytes - 1 };
+        std::size_t count = get_thread_description (tid, out);
+        out_description[count] = '\0';
 
 #if defined(DEBUG)
         printf ("%s(*, %u)='%s'\n", __func__, tid, out_description);
@@ -282,72 +755,138 @@ namespace drtm
        * the function must return a value <0. The register value is then
        * read from the CPU by the GDB server itself.
        *
+       * The register index follows the order of the registers in the
+       * `org.gnu.gdb.arm.m-profile`, `m-system` and `m-float` features
+       * (R0-R15, xPSR, MSP, PSP, PRIMASK, BASEPRI, FAULTMASK, CONTROL,
+       * FPSCR, S0-S31). For threads without a FP context, the FP
+       * registers are returned as zero.
+       *
+       * @tparam O Type of the sink output iterator.
        * @param [in] tid ID of the thread.
        * @param [in] reg_index Index of the register.
-       * @param [out] out_hex_value Pointer to the string, the value has
-       *  to be copied to.
-       * @param [in] out_size_bytes The max size of the output buffer.
+       * @param [out] out The sink where the hex digits are written.
        *
        * @retval 0 Reading register OK.
-       * @retval <0 Reading register failed.
+       * @retval <0 Reading register failed, the thread is not known,
+       *  or the sink is too small.
        */
-      int
-      get_thread_register (thread_id_t tid, std::size_t reg_index,
-                           char* out_hex_value, std::size_t out_size_bytes)
-      {
+      template<typename O>
+        int
+        get_thread_register (thread_id_t tid, std::size_t reg_index,
+                             sink<O>& out)
+        {
 #if defined(DEBUG)
-        printf ("%s(*, %zu, %u)\n", __func__, reg_index, tid);
+          printf ("%s(*, %zu, %u)\n", __func__, reg_index, tid);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
-          {
-            // No scheduler, GDB should use current registers.
+          typename snapshots_type::reader snap
+            { snapshots_ };
+
+          if (!snap->is_scheduler_started)
+            {
+              // No scheduler, GDB should use current registers.
 #if defined(DEBUG)
-            printf ("%s(*, %zu, %u)=-1 no scheduler\n", __func__, reg_index,
-                    tid);
+              printf ("%s(*, %zu, %u)=-1 no scheduler\n", __func__, reg_index,
+                      tid);
 #endif /* defined(DEBUG) */
-            return -1;
-          }
+              return -1;
+            }
 
-        if (tid == thread_type::id_none || threads_.is_current (tid))
-          {
-            // Current thread, GDB should use current CPU registers.
+          if (tid == thread_type::id_none || snap->threads.is_current (tid))
+            {
+              // Current thread, GDB should use current CPU registers.
 #if defined(DEBUG)
-            printf ("%s(*, %zu, %u)=-1 current thread\n", __func__, reg_index,
-                    tid);
+              printf ("%s(*, %zu, %u)=-1 current thread\n", __func__,
+                      reg_index, tid);
 #endif /* defined(DEBUG) */
-            return -1;
-          }
-
-        thread_type* td = threads_.thread (tid);
-        assert(td != NULL);
-
-        td->read_stack ();
-
-        // Note: The FP registers are not returned, only the main registers.
-
-        const stack_info_t* si = td->stack.info;
-        assert(si != NULL);
-
-        char* out = out_hex_value;
-        if (reg_index < si->out_registers)
-          {
+              return -1;
+            }
+
+          // The thread may be gone in a newer snapshot, or, if only
+          // its ID was streamed, not read yet.
+          thread_type* td = snap->threads.thread (tid);
+          if (td == nullptr || !td->is_read ())
+            {
 #if defined(DEBUG)
-            printf ("out ");
+              printf ("%s(*, %zu, %u)=-1 unknown thread\n", __func__,
+                      reg_index, tid);
 #endif /* defined(DEBUG) */
+              return -1;
+            }
+
+          const stack_info_t* si = td->stack.info;
+          assert(si != NULL);
+
+          if (reg_index < si->offsets_size)
+            {
+              if (reg_index < si->out_registers
+                  && td->is_registers_reply_cached ())
+                {
+                  // Copied from the rendered reply, without locks.
+                  td->output_register (reg_index, out);
+                }
+              else
+                {
+                  // The lazy reads change the published snapshot.
+                  spin_lock_guard guard
+                    { snapshots_.lock () };
+
+                  td->read_stack ();
+                  if (td->is_in_fp_bank (reg_index))
+                    {
+                      // The FP bank is read only when a FP register
+                      // is requested.
+                      td->read_stack_fp ();
+                    }
+
+                  td->output_register (reg_index, out);
+                }
+              if (out.overflow ())
+                {
+                  backend_.output_error ("Register output truncated.\n");
+                  return -1;
+                }
+
+              return 0;
+            }
+
+          int ret = -1;
+          printf ("%s(*, %zu, %u)=%d outside range\n", __func__, reg_index,
+                  tid, ret);
+
+          return ret;
+        }
+
+      /**
+       * @brief Get the thread’s register value as HEX string.
+       *
+       * @param [in] tid ID of the thread.
+       * @param [in] reg_index Index of the register.
+       * @param [out] out_hex_value Pointer to the string, the value has
+       *  to be copied to.
+       * @param [in] out_size_bytes The max size of the output buffer.
+       *
+       * @retval 0 Reading register OK.
+       * @retval <0 Reading register failed.
+       */
+      int
+      get_thread_register (thread_id_t tid, std::size_t reg_index,
+                           char* out_hex_value, std::size_t out_size_bytes)
+      {
+        assert(out_hex_value != NULL);
+        assert(out_size_bytes > 0);
 
-            out += td->output_register (reg_index, out, out_size_bytes);
+        sink<char*> out
+          { out_hex_value, out_size_bytes - 1 };
+        int ret = get_thread_register (tid, reg_index, out);
+        out_hex_value[out.length ()] = '\0';
 
 #if defined(DEBUG)
-            printf ("%s \n", out - 8);
-#endif /* defined(DEBUG) */
-
-            return 0;
+        if (ret == 0)
+          {
+            printf ("out %s\n", out_hex_value);
           }
-
-        int ret = -1;
-        printf ("%s(*, %zu, %u)=%d outside range\n", __func__, reg_index, tid,
-                ret);
+#endif /* defined(DEBUG) */
 
         return ret;
       }
@@ -360,69 +899,115 @@ namespace drtm
        * the function must return a value <0. The register values are then
        * read from the CPU by the GDB server itself.
        *
+       * The registers are written directly to the sink, so the
+       * `g` reply can be built in place, in the packet buffer.
+       *
+       * @tparam O Type of the sink output iterator.
        * @param [in] tid ID of the thread.
-       * @param [out] out_hex_values Pointer to the string, the values
-       *  have to be copied to.
-       * @param [in] out_size_bytes The max size of the output buffer.
+       * @param [out] out The sink where the hex digits are written.
        *
        * @retval 0 Reading registers OK.
-       * @retval <0 Reading register failed.
+       * @retval <0 Reading register failed, the thread is not known,
+       *  or the sink is too small.
        */
-      int
-      get_thread_registers (thread_id_t tid, char* out_hex_values,
-                            std::size_t out_size_bytes)
-      {
+      template<typename O>
+        int
+        get_thread_registers (thread_id_t tid, sink<O>& out)
+        {
 #if defined(DEBUG)
-        printf ("%s(*, %u)\n", __func__, tid);
+          printf ("%s(*, %u)\n", __func__, tid);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
-          {
-            // No scheduler, GDB should use current registers.
+          typename snapshots_type::reader snap
+            { snapshots_ };
+
+          if (!snap->is_scheduler_started)
+            {
+              // No scheduler, GDB should use current registers.
 #if defined(DEBUG)
-            printf ("%s(*, %u)=-1 no scheduler\n", __func__, tid);
+              printf ("%s(*, %u)=-1 no scheduler\n", __func__, tid);
 #endif /* defined(DEBUG) */
-            return -1;
-          }
+              return -1;
+            }
 
-        if (tid == thread_type::id_none || threads_.is_current (tid))
-          {
-            // Current thread, GDB should use current CPU registers.
+          if (tid == thread_type::id_none || snap->threads.is_current (tid))
+            {
+              // Current thread, GDB should use current CPU registers.
 #if defined(DEBUG)
-            printf ("%s(*, %u)=-1 current thread\n", __func__, tid);
+              printf ("%s(*, %u)=-1 current thread\n", __func__, tid);
 #endif /* defined(DEBUG) */
 
-            return -1;
-          }
+              return -1;
+            }
 
-        thread_type* th = threads_.thread (tid);
-        assert(th != NULL);
+          // The thread may be gone in a newer snapshot, or, if only
+          // its ID was streamed, not read yet.
+          thread_type* th = snap->threads.thread (tid);
+          if (th == nullptr || !th->is_read ())
+            {
+#if defined(DEBUG)
+              printf ("%s(*, %u)=-1 unknown thread\n", __func__, tid);
+#endif /* defined(DEBUG) */
+              return -1;
+            }
+
+          // Note: The FP registers are not returned, only the main registers;
+          // they are available individually, via get_thread_register().
+
+          // Repeated requests during the same halt are served from
+          // the thread cache, without locks; only the first one
+          // reads the registers and renders the reply.
+          if (!th->is_registers_reply_cached ())
+            {
+              spin_lock_guard guard
+                { snapshots_.lock () };
+
+              th->prepare_registers_reply ();
+            }
+          th->output_registers (out);
+
+          if (out.overflow ())
+            {
+              backend_.output_error (
+                  "Registers output truncated, %zu bytes required.\n",
+                  out.required ());
+              return -1;
+            }
+
+          return 0;
+        }
 
-        th->read_stack ();
+      /**
+       * @brief Get the thread's general registers as HEX string.
+       *
+       * @param [in] tid ID of the thread.
+       * @param [out] out_hex_values Pointer to the string, the values
+       *  have to be copied to.
+       * @param [in] out_size_bytes The max size of the output buffer.
+       *
+       * @retval 0 Reading registers OK.
+       * @retval <0 Reading register failed.
+       */
+      int
+      get_thread_registers (thread_id_t tid, char* out_hex_values,
+                            std::size_t out_size_bytes)
+      {
+        assert(out_hex_values != NULL);
+        assert(out_size_bytes > 0);
 
-        // Note: The FP registers are not returned, only the main registers.
+        sink<char*> out
+          { out_hex_values, out_size_bytes - 1 };
+        int ret = get_thread_registers (tid, out);
+        out_hex_values[out.length ()] = '\0';
 
 #if defined(DEBUG)
-        printf ("out ");
-#endif /* defined(DEBUG) */
-        char* out = out_hex_values;
-        std::size_t count = 0;
-        std::size_t ret;
-        for (std::size_t i = 0; i < th->stack.info->out_registers; ++i)
+        if (ret == 0)
           {
-            ret = th->output_register (i, out, out_size_bytes - count);
-            count += ret;
-            out += ret;
-
-#if defined(DEBUG)
-            printf ("%s ", out - 8);
-#endif /* defined(DEBUG) */
+            printf ("out %s\n", out_hex_values);
           }
-#if defined(DEBUG)
-        printf ("\n");
 #endif /* defined(DEBUG) */
 
-        return 0;
+        return ret;
       }
 
       /**
@@ -449,7 +1034,10 @@ namespace drtm
         printf ("%s(\"%s\", %zu, %u)\n", __func__, hex_value, reg_index, tid);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        if (!snap->is_scheduler_started)
           {
             // No scheduler, GDB should set current registers.
 #if defined(DEBUG)
@@ -459,7 +1047,7 @@ namespace drtm
             return -1;
           }
 
-        if (tid == thread_type::id_none || threads_.is_current (tid))
+        if (tid == thread_type::id_none || snap->threads.is_current (tid))
           {
             // Current thread, GDB should set current CPU registers.
 #if defined(DEBUG)
@@ -469,6 +1057,16 @@ namespace drtm
             return -1;
           }
 
+        thread_type* th = snap->threads.thread (tid);
+        if (th != nullptr)
+          {
+            spin_lock_guard guard
+              { snapshots_.lock () };
+
+            // The registers are about to change.
+            th->invalidate_registers_reply ();
+          }
+
         int ret = 0;
         backend_.output_warning ("%s() not yet implemented (%d)\n", __func__,
                                  ret);
@@ -498,7 +1096,10 @@ namespace drtm
         printf ("%s(\"%s\", %d)\n", __func__, hex_values, tid);
 #endif /* defined(DEBUG) */
 
-        if (!is_scheduler_started_)
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        if (!snap->is_scheduler_started)
           {
             // No scheduler, GDB should set current registers.
 #if defined(DEBUG)
@@ -508,7 +1109,7 @@ namespace drtm
             return -1;
           }
 
-        if (tid == thread_type::id_none || threads_.is_current (tid))
+        if (tid == thread_type::id_none || snap->threads.is_current (tid))
           {
             // Current thread, GDB should set current CPU registers.
 #if defined(DEBUG)
@@ -518,14 +1119,195 @@ namespace drtm
             return -1;
           }
 
+        thread_type* th = snap->threads.thread (tid);
+        if (th != nullptr)
+          {
+            spin_lock_guard guard
+              { snapshots_.lock () };
+
+            // The registers are about to change.
+            th->invalidate_registers_reply ();
+          }
+
         int ret = 0;
         backend_.output_warning ("%s() not yet implemented (%d)\n", __func__,
                                  ret);
         return ret;
       }
 
+      /**
+       * @brief Enable/disable the speculative read of the stack frames
+       * during updates.
+       *
+       * @details
+       * When enabled, each thread frame is read in a single transaction
+       * and the layout is decided from the buffer; when disabled, the
+       * registers are read lazily, when requested.
+       */
+      void
+      speculative_frame_read (bool enabled)
+      {
+        snapshots_.speculative_frame_read (enabled);
+      }
+
+      /**
+       * @brief Get the allocation statistics of this session.
+       *
+       * @details
+       * Available when the allocator has a memory resource, like
+       * `polymorphic_allocator`; the statistics are those of the
+       * resource, so give each session its own resource.
+       *
+       * @return Pointer to the statistics, or nullptr if the allocator
+       *  has no resource (like `std::allocator`).
+       */
+      const memory_statistics_t*
+      get_memory_statistics (void)
+      {
+        memory_resource* mr = allocator_resource (allocator_, 0);
+        return (mr != nullptr) ? &mr->statistics () : nullptr;
+      }
+
+      /**
+       * @brief Enable/disable checking the updates with the target
+       * sequence counter (enabled by default, if the target provides
+       * it); while the target is halted, disabling it saves two
+       * transactions per update.
+       */
+      void
+      consistent_reads (bool enabled)
+      {
+        consistent_reads_ = enabled;
+      }
+
+      /**
+       * @brief Get the statistics of the updates checked with the
+       * target sequence counter.
+       *
+       * @details
+       * Updated by `update_thread_list()`; read them from the same
+       * host thread.
+       */
+      const consistency_statistics_t*
+      get_consistency_statistics (void)
+      {
+        return &consistency_statistics_;
+      }
+
+      void
+      reset_consistency_statistics (void)
+      {
+        consistency_statistics_ = consistency_statistics_t ();
+      }
+
+      /**
+       * @brief Force the DRTM header to be parsed again at the
+       * next update.
+       *
+       * @details
+       * Normally not needed, since each update checks if the header
+       * changed (for example after a reflash); use it when the
+       * server knows the symbols were reloaded.
+       */
+      void
+      invalidate_metadata (void)
+      {
+        metadata_.invalidate ();
+      }
+
+      /**
+       * @brief Use the metadata computed on the host (like by
+       * `dwarf_metadata`), instead of the target header; nullptr
+       * returns to the target header.
+       */
+      void
+      use_offline_metadata (const offline_metadata_t* om)
+      {
+        metadata_.use_offline (om);
+      }
+
       // ----------------------------------------------------------------------
 
+    private:
+
+      /**
+       * @brief Continue the budgeted update in progress, from the
+       * published partial snapshot, or, if none or if the threads
+       * changed, prepare a new one.
+       *
+       * @retval false The metadata is not available.
+       */
+      bool
+      resume_update (snapshot_type* s)
+      {
+        if (progress_.is_active ())
+          {
+            {
+              // The lazy reads may change the published threads.
+              spin_lock_guard guard
+                { snapshots_.lock () };
+
+              s->rt.resume_from (snapshots_.published ()->rt);
+            }
+            s->is_scheduler_started = true;
+            if (!s->rt.is_unchanged ())
+              {
+                progress_.reset ();
+              }
+          }
+
+        if (!progress_.is_active ())
+          {
+            if (!parse_metadata ())
+              {
+                return false;
+              }
+
+            s->is_scheduler_started = s->rt.is_scheduler_started ();
+          }
+
+        return true;
+      }
+
+      /**
+       * @brief Check if the published snapshot is still current,
+       * for the step mode.
+       */
+      bool
+      is_snapshot_current (void)
+      {
+        if (!metadata_.available ())
+          {
+            return false;
+          }
+
+        typename snapshots_type::reader snap
+          { snapshots_ };
+
+        // `is_started` is read by the full updates, until it latches.
+        if (!snap->is_scheduler_started)
+          {
+            return false;
+          }
+
+        // Only the updating host thread uses the run-time data of
+        // the published snapshot; the transactions are locked.
+        return snap->rt.is_unchanged ();
+      }
+
+      /**
+       * @brief Parse the DRTM header, if changed, holding the lock
+       * only for its target transactions.
+       */
+      bool
+      parse_metadata (void)
+      {
+        spin_lock_guard guard
+          { snapshots_.lock () };
+
+        return metadata_.parse ();
+      }
+
     private:
 
       backend_type& backend_;
@@ -533,12 +1315,17 @@ namespace drtm
 
       metadata_type metadata_
         { backend_ };
-      threads_type threads_
-        { backend_, allocator_ };
-      rtd_type rt_
-        { backend_, metadata_, threads_, allocator_ };
+      snapshots_type snapshots_
+        { backend_, metadata_, allocator_ };
+
+      bool consistent_reads_ = true;
+
+      // The state of a budgeted update, shared by the snapshots.
+      progress_type progress_
+        { allocator_ };
 
-      bool is_scheduler_started_ = false;
+      consistency_statistics_t consistency_statistics_
+        { };
 
     };
 
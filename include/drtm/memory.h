@@ -30,6 +30,7 @@
 
 #if defined(__cplusplus)
 
+#include <stdio.h>
 #include <cstdint>
 #include <cstddef>
 #include <cerrno>
@@ -38,10 +39,44 @@
 #include <memory>
 #include <system_error>
 
+// The number of size classes in the allocation statistics
+// histogram, from 16 bytes, doubling.
+#if !defined(DRTM_MEMORY_SIZE_CLASSES)
+#define DRTM_MEMORY_SIZE_CLASSES   12
+#endif
+
 namespace drtm
 {
   // --------------------------------------------------------------------------
 
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief The allocation statistics of a memory resource.
+   *
+   * @details
+   * The histogram counts the allocations by size; class `i` has the
+   * requests up to `16 << i` bytes, the last class also includes
+   * all larger requests.
+   */
+  struct memory_statistics_s
+  {
+    // The bytes allocated and not yet deallocated.
+    std::size_t current_bytes;
+    // The largest value of `current_bytes`.
+    std::size_t peak_bytes;
+    std::size_t allocations_count;
+    std::size_t deallocations_count;
+    // The allocations that threw or returned nullptr.
+    std::size_t failed_allocations_count;
+    std::size_t size_classes[DRTM_MEMORY_SIZE_CLASSES];
+  };
+
+#pragma GCC diagnostic pop
+
+  using memory_statistics_t = struct memory_statistics_s;
+
   /**
    * @brief Memory resource manager (abstract class).
    *
@@ -49,11 +84,19 @@ namespace drtm
    * This class is based on the standard C++17 memory manager, with
    * several extensions, to control the throw behaviour and to
    * add statistics.
+   *
+   * The statistics are kept for all derived resources, by the
+   * non virtual `allocate()` and `deallocate()`; like the resources,
+   * they are not synchronised.
    */
   class memory_resource
   {
     static const std::size_t max_align_ = alignof(max_align_t);
 
+  public:
+
+    static constexpr std::size_t size_classes = DRTM_MEMORY_SIZE_CLASSES;
+
   public:
 
     virtual
@@ -67,7 +110,36 @@ namespace drtm
 #if defined(DEBUG_)
       printf ("%s(%zu,%zu) @%p\n", __PRETTY_FUNCTION__, bytes, align, this);
 #endif
-      return do_allocate (bytes, align);
+      void* p;
+#if defined(__EXCEPTIONS)
+      try
+        {
+          p = do_allocate (bytes, align);
+        }
+      catch (...)
+        {
+          ++statistics_.failed_allocations_count;
+          throw;
+        }
+#else
+      p = do_allocate (bytes, align);
+#endif /* defined(__EXCEPTIONS) */
+
+      if (p == nullptr)
+        {
+          ++statistics_.failed_allocations_count;
+          return p;
+        }
+
+      ++statistics_.allocations_count;
+      ++statistics_.size_classes[size_class (bytes)];
+      statistics_.current_bytes += bytes;
+      if (statistics_.current_bytes > statistics_.peak_bytes)
+        {
+          statistics_.peak_bytes = statistics_.current_bytes;
+        }
+
+      return p;
     }
 
     inline
@@ -76,6 +148,9 @@ namespace drtm
     deallocate (void* p, std::size_t bytes, std::size_t align = max_align_)
     {
       do_deallocate (p, bytes, align);
+
+      ++statistics_.deallocations_count;
+      statistics_.current_bytes -= bytes;
     }
 
     inline
@@ -86,6 +161,44 @@ namespace drtm
       return do_is_equal (other);
     }
 
+    /**
+     * @brief Get the allocation statistics.
+     */
+    inline const memory_statistics_t&
+    statistics (void) const noexcept
+    {
+      return statistics_;
+    }
+
+    /**
+     * @brief Clear the counters; the peak restarts from the
+     * current bytes, which are kept.
+     */
+    void
+    reset_statistics (void) noexcept
+    {
+      std::size_t current_bytes = statistics_.current_bytes;
+      statistics_ = memory_statistics_t ();
+      statistics_.current_bytes = current_bytes;
+      statistics_.peak_bytes = current_bytes;
+    }
+
+    /**
+     * @brief Get the histogram class of a request size.
+     */
+    static std::size_t
+    size_class (std::size_t bytes) noexcept
+    {
+      std::size_t i = 0;
+      std::size_t limit = 16;
+      while (bytes > limit && i < size_classes - 1)
+        {
+          limit <<= 1;
+          ++i;
+        }
+      return i;
+    }
+
   protected:
 
     virtual void*
@@ -96,6 +209,10 @@ namespace drtm
 
     virtual bool
     do_is_equal (memory_resource const & other) const noexcept = 0;
+
+  private:
+
+    memory_statistics_t statistics_ = memory_statistics_t ();
   };
 
   inline __attribute__ ((__always_inline__))
@@ -151,7 +268,7 @@ namespace drtm
       template<typename U>
         polymorphic_allocator (polymorphic_allocator<U> const & other) noexcept
         {
-          mr_ = other.mr_;
+          mr_ = other.resource ();
         }
 
       polymorphic_allocator&
@@ -166,8 +283,12 @@ namespace drtm
 
         if (objects > max_size ())
           {
+#if defined(__EXCEPTIONS)
             throw std::system_error (
                 std::error_code (EINVAL, std::system_category ()));
+#else
+            return nullptr;
+#endif /* defined(__EXCEPTIONS) */
           }
 
         value_type*p = static_cast<value_type*> (mr_->allocate (
@@ -214,6 +335,490 @@ namespace drtm
       memory_resource* mr_ = nullptr;
     };
 
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief Get the memory resource of an allocator, if it has one
+   * (like `polymorphic_allocator`).
+   *
+   * @return The resource, or nullptr for allocators without
+   *  a `resource()` (like `std::allocator`).
+   */
+  template<typename A>
+    inline auto
+    allocator_resource (const A& allocator, int) noexcept
+    -> decltype(static_cast<memory_resource*> (allocator.resource ()))
+    {
+      return allocator.resource ();
+    }
+
+  template<typename A>
+    inline memory_resource*
+    allocator_resource (const A& allocator __attribute__((unused)), long) noexcept
+    {
+      return nullptr;
+    }
+
+  // --------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief Monotonic memory resource.
+   *
+   * @details
+   * Allocations are carved sequentially from an optional initial
+   * buffer, then from chunks obtained from the upstream resource,
+   * each chunk twice as large as the previous one. Deallocation
+   * does nothing; the memory is reclaimed only at once, by
+   * `reset()`, which keeps the chunks for reuse, or by `release()`,
+   * which returns them to the upstream resource.
+   *
+   * Intended for scratch data with a well defined life time,
+   * like the data used during one update. Not synchronised.
+   */
+  class monotonic_buffer_resource : public memory_resource
+  {
+  public:
+
+    /**
+     * @brief Construct a resource that allocates the chunks from
+     * the upstream resource.
+     *
+     * @param initial_size The size of the first chunk.
+     * @param upstream The resource for the chunks; if nullptr,
+     *  when the buffer is exhausted, allocations throw.
+     */
+    monotonic_buffer_resource (std::size_t initial_size,
+                               memory_resource* upstream) noexcept :
+        upstream_ (upstream), // Parenthesis used to compile with 4.8
+        next_size_ (initial_size)
+    {
+#if defined(DEBUG)
+      printf ("%s(%zu, %p) @%p\n", __func__, initial_size, upstream, this);
+#endif /* defined(DEBUG) */
+    }
+
+    /**
+     * @brief Construct a resource that allocates first from
+     * a given buffer, then from the upstream resource.
+     */
+    monotonic_buffer_resource (void* buffer, std::size_t size_bytes,
+                               memory_resource* upstream = nullptr) noexcept :
+        upstream_ (upstream), // Parenthesis used to compile with 4.8
+        buffer_ (static_cast<char*> (buffer)), //
+        buffer_size_ (size_bytes), //
+        next_size_ (size_bytes * 2), //
+        ptr_ (buffer_), //
+        end_ (buffer_ + size_bytes)
+    {
+#if defined(DEBUG)
+      printf ("%s(%p, %zu, %p) @%p\n", __func__, buffer, size_bytes, upstream,
+              this);
+#endif /* defined(DEBUG) */
+    }
+
+    // The rule of five.
+    monotonic_buffer_resource (const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource (monotonic_buffer_resource&&) = delete;
+    monotonic_buffer_resource&
+    operator= (const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource&
+    operator= (monotonic_buffer_resource&&) = delete;
+
+    virtual
+    ~monotonic_buffer_resource () override
+    {
+      release ();
+    }
+
+  public:
+
+    /**
+     * @brief Make all memory available again, keeping the chunks.
+     *
+     * @details
+     * All previously allocated blocks become invalid.
+     */
+    void
+    reset (void) noexcept
+    {
+      current_ = nullptr;
+      ptr_ = buffer_;
+      end_ = buffer_ + buffer_size_;
+    }
+
+    /**
+     * @brief Return all chunks to the upstream resource.
+     *
+     * @details
+     * All previously allocated blocks become invalid.
+     */
+    void
+    release (void) noexcept
+    {
+      chunk_s* c = chunks_;
+      while (c != nullptr)
+        {
+          chunk_s* next = c->next;
+          upstream_->deallocate (c, c->size_bytes, alignof(max_align_t));
+          c = next;
+        }
+      chunks_ = nullptr;
+      last_ = nullptr;
+
+      reset ();
+    }
+
+    memory_resource*
+    upstream_resource (void) const noexcept
+    {
+      return upstream_;
+    }
+
+  protected:
+
+    virtual void*
+    do_allocate (std::size_t bytes, std::size_t align) override
+    {
+      void* p = carve (bytes, align);
+      if (p != nullptr)
+        {
+          return p;
+        }
+
+      // Try the chunks kept by `reset()`, then get a new one.
+      chunk_s* c = (current_ != nullptr) ? current_->next : chunks_;
+      for (; c != nullptr; c = c->next)
+        {
+          use (c);
+          p = carve (bytes, align);
+          if (p != nullptr)
+            {
+              return p;
+            }
+        }
+
+      if (upstream_ == nullptr)
+        {
+#if defined(__EXCEPTIONS)
+          throw std::system_error (
+              std::error_code (ENOMEM, std::system_category ()));
+#else
+          return nullptr;
+#endif /* defined(__EXCEPTIONS) */
+        }
+
+      std::size_t size = sizeof(chunk_s) + bytes + align;
+      if (size < next_size_)
+        {
+          size = next_size_;
+        }
+
+      c = static_cast<chunk_s*> (upstream_->allocate (size,
+                                                      alignof(max_align_t)));
+      if (c == nullptr)
+        {
+          // Upstream exhausted, without exceptions; nothing changed.
+          return nullptr;
+        }
+      next_size_ = size * 2;
+
+      c->next = nullptr;
+      c->size_bytes = size;
+      if (last_ != nullptr)
+        {
+          last_->next = c;
+        }
+      else
+        {
+          chunks_ = c;
+        }
+      last_ = c;
+
+      use (c);
+      p = carve (bytes, align);
+      assert(p != nullptr);
+
+      return p;
+    }
+
+    virtual void
+    do_deallocate (void* p __attribute__((unused)),
+                   std::size_t bytes __attribute__((unused)),
+                   std::size_t align __attribute__((unused))) override
+    {
+      ; // Reclaimed only by reset() or release().
+    }
+
+    virtual bool
+    do_is_equal (memory_resource const & other) const noexcept override
+    {
+      return this == &other;
+    }
+
+  private:
+
+    struct chunk_s
+    {
+      chunk_s* next;
+      std::size_t size_bytes;
+      max_align_t align;
+    };
+
+    void*
+    carve (std::size_t bytes, std::size_t align) noexcept
+    {
+      if (ptr_ == nullptr)
+        {
+          return nullptr;
+        }
+
+      std::size_t space = static_cast<std::size_t> (end_ - ptr_);
+      void* p = ptr_;
+      if (std::align (align, bytes, p, space) == nullptr)
+        {
+          return nullptr;
+        }
+
+      ptr_ = static_cast<char*> (p) + bytes;
+      return p;
+    }
+
+    void
+    use (chunk_s* c) noexcept
+    {
+      current_ = c;
+      ptr_ = reinterpret_cast<char*> (&c->align);
+      end_ = reinterpret_cast<char*> (c) + c->size_bytes;
+    }
+
+    memory_resource* upstream_ = nullptr;
+
+    char* buffer_ = nullptr;
+    std::size_t buffer_size_ = 0;
+
+    std::size_t next_size_ = 0;
+
+    // The chunks from upstream, in allocation order.
+    chunk_s* chunks_ = nullptr;
+    chunk_s* last_ = nullptr;
+    // The chunk in use, or nullptr for the initial buffer.
+    chunk_s* current_ = nullptr;
+
+    char* ptr_ = nullptr;
+    char* end_ = nullptr;
+  };
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief Fixed size blocks pool memory resource.
+   *
+   * @details
+   * Requests up to the block size are served from a free list of
+   * blocks, carved from chunks obtained from the upstream resource;
+   * released blocks return to the free list, so once the pool
+   * grew to the working set, there are no more upstream calls.
+   * Larger requests are forwarded to the upstream resource.
+   *
+   * Intended for the thread objects, which all have the same size.
+   * Not synchronised.
+   */
+  class pool_resource : public memory_resource
+  {
+  public:
+
+    /**
+     * @brief Construct a pool.
+     *
+     * @param block_size_bytes The size of the blocks.
+     * @param blocks_per_chunk The number of blocks obtained at once.
+     * @param upstream The resource for the chunks and for the
+     *  larger requests.
+     */
+    pool_resource (std::size_t block_size_bytes, std::size_t blocks_per_chunk,
+                   memory_resource* upstream) noexcept :
+        upstream_ (upstream), // Parenthesis used to compile with 4.8
+        block_size_bytes_ (round_up (block_size_bytes)), //
+        blocks_per_chunk_ (blocks_per_chunk > 0 ? blocks_per_chunk : 1)
+    {
+#if defined(DEBUG)
+      printf ("%s(%zu, %zu, %p) @%p\n", __func__, block_size_bytes,
+              blocks_per_chunk, upstream, this);
+#endif /* defined(DEBUG) */
+
+      assert(upstream_ != nullptr);
+    }
+
+    // The rule of five.
+    pool_resource (const pool_resource&) = delete;
+    pool_resource (pool_resource&&) = delete;
+    pool_resource&
+    operator= (const pool_resource&) = delete;
+    pool_resource&
+    operator= (pool_resource&&) = delete;
+
+    virtual
+    ~pool_resource () override
+    {
+      release ();
+    }
+
+  public:
+
+    /**
+     * @brief Make all blocks free again, keeping the chunks.
+     *
+     * @details
+     * All previously allocated blocks become invalid; the
+     * larger requests forwarded to upstream are not affected.
+     */
+    void
+    reset (void) noexcept
+    {
+      free_ = nullptr;
+      for (chunk_s* c = chunks_; c != nullptr; c = c->next)
+        {
+          add_blocks (c);
+        }
+    }
+
+    /**
+     * @brief Return all chunks to the upstream resource.
+     */
+    void
+    release (void) noexcept
+    {
+      chunk_s* c = chunks_;
+      while (c != nullptr)
+        {
+          chunk_s* next = c->next;
+          upstream_->deallocate (c, chunk_size_bytes (), alignof(max_align_t));
+          c = next;
+        }
+      chunks_ = nullptr;
+      free_ = nullptr;
+    }
+
+    inline std::size_t
+    block_size_bytes (void) const noexcept
+    {
+      return block_size_bytes_;
+    }
+
+    memory_resource*
+    upstream_resource (void) const noexcept
+    {
+      return upstream_;
+    }
+
+  protected:
+
+    virtual void*
+    do_allocate (std::size_t bytes, std::size_t align) override
+    {
+      if (bytes > block_size_bytes_ || align > alignof(max_align_t))
+        {
+          return upstream_->allocate (bytes, align);
+        }
+
+      if (free_ == nullptr)
+        {
+          chunk_s* c = static_cast<chunk_s*> (upstream_->allocate (
+              chunk_size_bytes (), alignof(max_align_t)));
+          if (c == nullptr)
+            {
+              // Upstream exhausted, without exceptions.
+              return nullptr;
+            }
+          c->next = chunks_;
+          chunks_ = c;
+
+          add_blocks (c);
+        }
+
+      block_s* b = free_;
+      free_ = b->next;
+
+      return b;
+    }
+
+    virtual void
+    do_deallocate (void* p, std::size_t bytes, std::size_t align) override
+    {
+      if (bytes > block_size_bytes_ || align > alignof(max_align_t))
+        {
+          upstream_->deallocate (p, bytes, align);
+          return;
+        }
+
+      block_s* b = static_cast<block_s*> (p);
+      b->next = free_;
+      free_ = b;
+    }
+
+    virtual bool
+    do_is_equal (memory_resource const & other) const noexcept override
+    {
+      return this == &other;
+    }
+
+  private:
+
+    struct block_s
+    {
+      block_s* next;
+    };
+
+    struct chunk_s
+    {
+      chunk_s* next;
+      max_align_t align;
+    };
+
+    static std::size_t
+    round_up (std::size_t bytes) noexcept
+    {
+      if (bytes < sizeof(block_s))
+        {
+          bytes = sizeof(block_s);
+        }
+      return (bytes + alignof(max_align_t) - 1)
+          & ~(alignof(max_align_t) - 1);
+    }
+
+    inline std::size_t
+    chunk_size_bytes (void) const noexcept
+    {
+      return offsetof(chunk_s, align) + blocks_per_chunk_ * block_size_bytes_;
+    }
+
+    void
+    add_blocks (chunk_s* c) noexcept
+    {
+      char* p = reinterpret_cast<char*> (&c->align);
+      for (std::size_t i = 0; i < blocks_per_chunk_; ++i)
+        {
+          block_s* b = reinterpret_cast<block_s*> (p
+              + i * block_size_bytes_);
+          b->next = free_;
+          free_ = b;
+        }
+    }
+
+    memory_resource* upstream_;
+
+    std::size_t block_size_bytes_;
+    std::size_t blocks_per_chunk_;
+
+    chunk_s* chunks_ = nullptr;
+    block_s* free_ = nullptr;
+  };
+
+#pragma GCC diagnostic pop
+
 // ----------------------------------------------------------------------------
 }
 #endif /* #if defined(__cplusplus) */
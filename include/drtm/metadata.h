@@ -52,9 +52,45 @@
 #define OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_ASSIGNED 0x20
 #define OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_INHERITED 0x22
 
-// Tells how far up is the EXC word.
-// TODO: make this configurable
-#define STACK_EXC_OFFSET_WORDS   8
+#define OS_RTOS_DRTM_V0_SIZEOF 0x24
+
+// Debug Run Time Information v1.x additional offsets (provisional).
+
+#define OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_PREV_OFFSET 0x24
+#define OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_NEXT_OFFSET 0x26
+#define OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_SELECTOR_OFFSET 0x28
+
+#define OS_RTOS_DRTM_V1_SIZEOF 0x2C
+
+// Debug Run Time Information v1.1 additional offsets (provisional),
+// for multi-core targets.
+
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREADS_ADDR 0x2C
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT 0x30
+
+#define OS_RTOS_DRTM_V1_1_SIZEOF 0x34
+
+// Debug Run Time Information v1.2 additional offsets (provisional),
+// for the counter of changes of the thread lists.
+
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_GENERATION_ADDR 0x34
+
+#define OS_RTOS_DRTM_V1_2_SIZEOF 0x38
+
+// Debug Run Time Information v1.3 additional offsets (provisional),
+// for the flat table of pointers to all threads.
+
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_TABLE_ADDR 0x38
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_COUNT_ADDR 0x3C
+
+#define OS_RTOS_DRTM_V1_3_SIZEOF 0x40
+
+// Debug Run Time Information v1.4 additional offsets (provisional),
+// for reading the threads while the target runs.
+
+#define OS_RTOS_DRTM_OFFSETOF_SCHEDULER_SEQUENCE_ADDR 0x40
+
+#define OS_RTOS_DRTM_V1_4_SIZEOF 0x44
 
 namespace drtm
 {
@@ -73,6 +109,59 @@ namespace drtm
       using addr_t = typename backend_type::target_addr_t;
       using offset_t = ::drtm::target_offset_t;
 
+      // The header fields that can be described by a schema.
+      enum class field_id
+        : uint8_t
+          {
+            scheduler_is_started_addr, //
+            scheduler_top_threads_list_addr, //
+            scheduler_current_thread_addr, //
+            scheduler_current_threads_addr, //
+            scheduler_cores_count, //
+            scheduler_threads_generation_addr, //
+            scheduler_threads_table_addr, //
+            scheduler_threads_count_addr, //
+            scheduler_sequence_addr, //
+
+            thread_name_offset, //
+            thread_parent_offset, //
+            thread_list_node_offset, //
+            thread_children_node_offset, //
+            thread_state_offset, //
+            thread_stack_offset, //
+            thread_prio_assigned_offset, //
+            thread_prio_inherited_offset, //
+            thread_stack_selector_offset_words, //
+
+            list_links_prev_offset, //
+            list_links_next_offset, //
+          };
+
+      // A field and its offset in the header.
+      typedef struct schema_entry_s
+      {
+        field_id id;
+        target_offset_t offset;
+      } schema_entry_t;
+
+      // The layout of the header for a range of versions; the
+      // fields of the base version, plus the added entries.
+      typedef struct schema_s
+      {
+        uint8_t major;
+        // The first minor version using this layout.
+        uint8_t minor;
+        std::size_t header_size_bytes;
+        // The extended version, or nullptr.
+        const struct schema_s* base;
+        const schema_entry_t* entries;
+        std::size_t entries_size;
+      } schema_t;
+
+      // The largest known header, read in a single transaction.
+      static constexpr std::size_t header_max_size_bytes =
+      OS_RTOS_DRTM_V1_4_SIZEOF;
+
     public:
 
       /**
@@ -101,6 +190,23 @@ namespace drtm
 
     public:
 
+      /**
+       * @brief Parse the DRTM header.
+       *
+       * @details
+       * The header is read in a single transaction, and decoded
+       * with the schema of its version.
+       *
+       * This is called for each update; the symbol address and a
+       * checksum of the header are used as a probe, and the header
+       * is decoded again only when the probe changes (for example
+       * after the firmware was reflashed). Once parsed, only the
+       * bytes of the parsed header are read and checked, so the
+       * memory after a shorter header does not matter.
+       *
+       * @retval true The header was parsed and the metadata is available.
+       * @retval false There is no usable header.
+       */
       bool
       parse (void)
       {
@@ -108,7 +214,41 @@ namespace drtm
         printf ("%s()\n", __func__);
 #endif /* defined(DEBUG) */
 
-        if (was_parsed)
+        if (is_offline_)
+          {
+            // Computed on the host, no need to read the target.
+            if (!was_parsed)
+              {
+                apply_offline ();
+                backend_.output ("DRTM metadata from the debug information.\n");
+
+                was_parsed = true;
+                is_available = true;
+                ++generation_;
+              }
+            return true;
+          }
+
+        addr_t drtm_addr = backend_.get_symbol_address (DRTM_SYMBOL_NAME);
+
+        if (drtm_addr == 0x0)
+          {
+            if (!was_parsed || probe_ != 0)
+              {
+                backend_.output_error ("The '%s' symbol was not resolved.\n",
+                DRTM_SYMBOL_NAME);
+              }
+            // Remember the failure, to report it only once.
+            was_parsed = true;
+            probe_ = 0;
+            is_available = false;
+            return false;
+          }
+
+        std::size_t size = read_header (drtm_addr);
+        uint32_t probe = compute_probe (drtm_addr, size);
+
+        if (was_parsed && probe == probe_)
           {
 #if defined(DEBUG)
             printf ("%s()=%s\n", __func__, is_available ? "true" : "false");
@@ -116,20 +256,34 @@ namespace drtm
             return is_available;
           }
 
-        addr_t drtm_addr = backend_.get_symbol_address (DRTM_SYMBOL_NAME);
+        if (was_parsed && is_available)
+          {
+            backend_.output ("DRTM header changed, parse again.\n");
+          }
 
-        if (drtm_addr == 0x0)
+        if (header_size_bytes_ != 0)
           {
-            backend_.output_error ("The '%s' symbol was not resolved.\n",
-            DRTM_SYMBOL_NAME);
-            return false;
+            // The new header may be larger, read all of it.
+            header_size_bytes_ = 0;
+            size = read_header (drtm_addr);
+            probe = compute_probe (drtm_addr, size);
           }
 
-        // Set this early, to prevent useless checks if parsing fails.
+        // Set this early, to prevent useless checks if parsing fails;
+        // the header is checked again only if the probe changes.
         was_parsed = true;
+        probe_ = probe;
+        header_size_bytes_ = size;
+        is_available = false;
+
+        if (size == 0)
+          {
+            backend_.output_error ("Could not read DRTM.\n");
+            return false;
+          }
 
-        backend_.read_byte_array (drtm_addr + OS_RTOS_DRTM_OFFSETOF_MAGIC,
-                                  &magic[0], sizeof(magic));
+        std::memcpy (&magic[0], &header_[OS_RTOS_DRTM_OFFSETOF_MAGIC],
+                     sizeof(magic));
         if (std::strncmp (reinterpret_cast<char*> (&magic[0]), "DRTM", 4) != 0)
           {
             backend_.output_error ("DRTM magic not found, abort.\n",
@@ -137,8 +291,8 @@ namespace drtm
             return false;
           }
 
-        backend_.read_byte_array (drtm_addr + OS_RTOS_DRTM_OFFSETOF_VERSION,
-                                  &version.v, sizeof(version));
+        std::memcpy (&version.v, &header_[OS_RTOS_DRTM_OFFSETOF_VERSION],
+                     sizeof(version));
         if (version.v != 'v')
           {
             backend_.output_error ("DRTM version field not found, abort.\n",
@@ -148,116 +302,337 @@ namespace drtm
         backend_.output ("DRTM v%u.%u.%u header @0x%08X\n", version.major,
                          version.minor, version.patch, drtm_addr);
 
-        if (version.major == 0)
+        const schema_t* schema = find_schema (version.major, version.minor);
+        if (schema == nullptr)
           {
-            int ret;
-            ret = backend_.read_long (
-                drtm_addr + OS_RTOS_DRTM_OFFSETOF_SCHEDULER_IS_STARTED_ADDR,
-                &scheduler.is_started_addr);
-            if (ret >= 0)
-              {
-                ret = backend_.read_long (
-                    drtm_addr
-                        + OS_RTOS_DRTM_OFFSETOF_SCHEDULER_TOP_THREADS_LIST_ADDR,
-                    &scheduler.top_threads_list_addr);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_long (
-                    drtm_addr
-                        + OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREAD_ADDR,
-                    &scheduler.current_thread_addr);
-              }
+            backend_.output_error ("Version not supported.\n");
+            return false;
+          }
 
+        if (schema->header_size_bytes > size)
+          {
+            // Only the short header could be read.
+            backend_.output_error ("Could not read DRTM.\n");
+            return false;
+          }
+
+        decode (schema);
+
+        // From now on, read and check only the bytes of this header.
+        header_size_bytes_ = schema->header_size_bytes;
+        probe_ = compute_probe (drtm_addr, header_size_bytes_);
+
+        ++generation_;
+        is_available = true;
+        return true;
+      }
+
+      /**
+       * @brief Use the metadata computed on the host, instead of
+       * the target header.
+       *
+       * @details
+       * This allows applications without the DRTM header to be
+       * debugged with thread awareness, and avoids reading the
+       * header from the target.
+       *
+       * @param om Pointer to the offline metadata, which is copied,
+       *  or nullptr to return to the target header.
+       */
+      void
+      use_offline (const offline_metadata_t* om)
+      {
+        is_offline_ = (om != nullptr);
+        if (is_offline_)
+          {
+            offline_ = *om;
+          }
+        invalidate ();
+      }
+
+      /**
+       * @brief Force the header to be parsed again at the next update.
+       */
+      inline void
+      invalidate (void)
+      {
+        was_parsed = false;
+        is_available = false;
+      }
+
+      /**
+       * @brief Tell if the last parse succeeded, without accessing
+       * the target.
+       */
+      inline bool
+      available (void)
+      {
+        return is_available;
+      }
+
+      /**
+       * @brief Get the number of times the header was decoded; it
+       * changes when the metadata changes.
+       */
+      inline uint32_t
+      generation (void)
+      {
+        return generation_;
+      }
+
+    protected:
+
+      /**
+       * @brief Read the header in a single transaction.
+       *
+       * @details
+       * The size of the header last read is tried first, or, if not
+       * known, the largest known header; if this fails (an older
+       * header may be at the end of the flash), the smaller known
+       * headers are tried.
+       *
+       * @return The number of bytes read, or 0 if reading failed.
+       */
+      std::size_t
+      read_header (addr_t drtm_addr)
+      {
+        std::size_t size =
+            (header_size_bytes_ != 0) ?
+                header_size_bytes_ : header_max_size_bytes;
+        for (;;)
+          {
+            int ret = backend_.read_byte_array (drtm_addr, &header_[0], size);
             if (ret >= 0)
               {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_NAME_OFFSET,
-                    &thread.name_offset);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_PARENT_OFFSET,
-                    &thread.parent_offset);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_LIST_NODE_OFFSET,
-                    &thread.list_node_offset);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_short (
-                    drtm_addr
-                        + OS_RTOS_DRTM_OFFSETOF_THREAD_CHILDREN_NODE_OFFSET,
-                    &thread.children_node_offset);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_STATE_OFFSET,
-                    &thread.state_offset);
-              }
-            if (ret >= 0)
-              {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_OFFSET,
-                    &thread.stack_offset);
+                return size;
               }
-            if (ret >= 0)
+
+            // The next smaller header size.
+            std::size_t next = 0;
+            for (const schema_t& sc : schemas_)
               {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_ASSIGNED,
-                    &thread.prio_assigned_offset);
+                if (sc.header_size_bytes < size && sc.header_size_bytes > next)
+                  {
+                    next = sc.header_size_bytes;
+                  }
               }
-            if (ret >= 0)
+            if (next == 0)
               {
-                ret = backend_.read_short (
-                    drtm_addr + OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_INHERITED,
-                    &thread.prio_inherited_offset);
+                return 0;
               }
-            if (ret < 0)
+            size = next;
+          }
+      }
+
+      void
+      apply_offline (void)
+      {
+        scheduler.is_started_addr =
+            static_cast<addr_t> (offline_.scheduler_is_started_addr);
+        scheduler.top_threads_list_addr =
+            static_cast<addr_t> (offline_.scheduler_top_threads_list_addr);
+        scheduler.current_thread_addr =
+            static_cast<addr_t> (offline_.scheduler_current_thread_addr);
+        scheduler.current_threads_addr = 0;
+        scheduler.cores_count = 1;
+        scheduler.threads_generation_addr = 0;
+        scheduler.threads_table_addr = 0;
+        scheduler.threads_count_addr = 0;
+        scheduler.sequence_addr = 0;
+
+        thread.name_offset = offline_.thread_name_offset;
+        thread.parent_offset = offline_.thread_parent_offset;
+        thread.list_node_offset = offline_.thread_list_node_offset;
+        thread.children_node_offset = offline_.thread_children_node_offset;
+        thread.state_offset = offline_.thread_state_offset;
+        thread.stack_offset = offline_.thread_stack_offset;
+        thread.prio_assigned_offset = offline_.thread_prio_assigned_offset;
+        thread.prio_inherited_offset = offline_.thread_prio_inherited_offset;
+        thread.stack_selector_offset_words = 0;
+
+        list_links.prev_offset = offline_.list_links_prev_offset;
+        list_links.next_offset = offline_.list_links_next_offset;
+      }
+
+      /**
+       * @brief Compute the validity probe, a FNV-1a hash of the
+       * header address and its content.
+       */
+      uint32_t
+      compute_probe (addr_t drtm_addr, std::size_t size)
+      {
+        uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < sizeof(drtm_addr); ++i)
+          {
+            hash ^= static_cast<uint8_t> (drtm_addr >> (i * 8));
+            hash *= 16777619u;
+          }
+        for (std::size_t i = 0; i < size; ++i)
+          {
+            hash ^= header_[i];
+            hash *= 16777619u;
+          }
+        // Keep 0 for 'no header'.
+        return (hash != 0) ? hash : 1;
+      }
+
+      /**
+       * @brief Find the schema for a version; the one with the
+       * same major and the highest minor not above the given one.
+       */
+      static const schema_t*
+      find_schema (uint8_t major, uint8_t minor)
+      {
+        const schema_t* found = nullptr;
+        for (const schema_t& sc : schemas_)
+          {
+            if (sc.major == major && sc.minor <= minor
+                && (found == nullptr || sc.minor > found->minor))
               {
-                backend_.output_error ("Could not read DRTM.\n");
+                found = &sc;
               }
+          }
 
-#if defined(DEBUG)
-            printf ("%08X scheduler.is_started_addr\n",
-                    scheduler.is_started_addr);
-            printf ("%08X scheduler.top_threads_list_addr\n",
-                    scheduler.top_threads_list_addr);
-            printf ("%08X scheduler.current_thread_addr\n",
-                    scheduler.current_thread_addr);
-            printf ("%04X thread.name_offset\n", thread.name_offset);
-            printf ("%04X thread.parent_offset\n", thread.parent_offset);
-            printf ("%04X thread.list_node_offset\n", thread.list_node_offset);
-            printf ("%04X thread.children_node_offset\n",
-                    thread.children_node_offset);
-            printf ("%04X thread.state_offset\n", thread.state_offset);
-            printf ("%04X thread.stack_offset\n", thread.stack_offset);
-            printf ("%04X thread.prio_assigned_offset\n",
-                    thread.prio_assigned_offset);
-            printf ("%04X thread.prio_inherited_offset\n",
-                    thread.prio_inherited_offset);
-#endif /* defined(DEBUG) */
+        return found;
+      }
 
-            // TODO: get from DRTM
-            list_links.prev_offset = 0;
-            list_links.next_offset = 4;
+      /**
+       * @brief Decode the header fields, as described by the schema;
+       * fields not in the schema get their default values.
+       */
+      void
+      decode (const schema_t* schema)
+      {
+        // Defaults for fields not present in older headers.
+        scheduler.current_threads_addr = 0;
+        scheduler.cores_count = 1;
+        scheduler.threads_generation_addr = 0;
+        scheduler.threads_table_addr = 0;
+        scheduler.threads_count_addr = 0;
+        scheduler.sequence_addr = 0;
+        list_links.prev_offset = 0;
+        list_links.next_offset = 4;
+        thread.stack_selector_offset_words = 0;
+
+        decode_entries (schema);
 
-            thread.stack_exc_offset_words = STACK_EXC_OFFSET_WORDS;
+#if defined(DEBUG)
+        printf ("%08X scheduler.is_started_addr\n", scheduler.is_started_addr);
+        printf ("%08X scheduler.top_threads_list_addr\n",
+                scheduler.top_threads_list_addr);
+        printf ("%08X scheduler.current_thread_addr\n",
+                scheduler.current_thread_addr);
+        printf ("%08X scheduler.current_threads_addr\n",
+                scheduler.current_threads_addr);
+        printf ("%u scheduler.cores_count\n", scheduler.cores_count);
+        printf ("%08X scheduler.threads_generation_addr\n",
+                scheduler.threads_generation_addr);
+        printf ("%08X scheduler.threads_table_addr\n",
+                scheduler.threads_table_addr);
+        printf ("%08X scheduler.threads_count_addr\n",
+                scheduler.threads_count_addr);
+        printf ("%08X scheduler.sequence_addr\n", scheduler.sequence_addr);
+        printf ("%04X thread.name_offset\n", thread.name_offset);
+        printf ("%04X thread.parent_offset\n", thread.parent_offset);
+        printf ("%04X thread.list_node_offset\n", thread.list_node_offset);
+        printf ("%04X thread.children_node_offset\n",
+                thread.children_node_offset);
+        printf ("%04X thread.state_offset\n", thread.state_offset);
+        printf ("%04X thread.stack_offset\n", thread.stack_offset);
+        printf ("%04X thread.prio_assigned_offset\n",
+                thread.prio_assigned_offset);
+        printf ("%04X thread.prio_inherited_offset\n",
+                thread.prio_inherited_offset);
+        printf ("%04X thread.stack_selector_offset_words\n",
+                thread.stack_selector_offset_words);
+        printf ("%04X list_links.prev_offset\n", list_links.prev_offset);
+        printf ("%04X list_links.next_offset\n", list_links.next_offset);
+#endif /* defined(DEBUG) */
+      }
 
-          }
-        else
+      /**
+       * @brief Decode the fields of the base versions, then the
+       * entries added by this one.
+       */
+      void
+      decode_entries (const schema_t* schema)
+      {
+        if (schema->base != nullptr)
           {
-            backend_.output_error ("Version not supported.\n");
-            return false;
+            decode_entries (schema->base);
           }
 
-        is_available = true;
-        return true;
+        for (std::size_t i = 0; i < schema->entries_size; ++i)
+          {
+            const schema_entry_t& e = schema->entries[i];
+            const uint8_t* p = &header_[e.offset];
+
+            switch (e.id)
+              {
+              case field_id::scheduler_is_started_addr:
+                scheduler.is_started_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_top_threads_list_addr:
+                scheduler.top_threads_list_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_current_thread_addr:
+                scheduler.current_thread_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_current_threads_addr:
+                scheduler.current_threads_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_cores_count:
+                scheduler.cores_count = backend_.load_short (p);
+                break;
+              case field_id::scheduler_threads_generation_addr:
+                scheduler.threads_generation_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_threads_table_addr:
+                scheduler.threads_table_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_threads_count_addr:
+                scheduler.threads_count_addr = backend_.load_long (p);
+                break;
+              case field_id::scheduler_sequence_addr:
+                scheduler.sequence_addr = backend_.load_long (p);
+                break;
+
+              case field_id::thread_name_offset:
+                thread.name_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_parent_offset:
+                thread.parent_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_list_node_offset:
+                thread.list_node_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_children_node_offset:
+                thread.children_node_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_state_offset:
+                thread.state_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_stack_offset:
+                thread.stack_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_prio_assigned_offset:
+                thread.prio_assigned_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_prio_inherited_offset:
+                thread.prio_inherited_offset = backend_.load_short (p);
+                break;
+              case field_id::thread_stack_selector_offset_words:
+                thread.stack_selector_offset_words = backend_.load_short (p);
+                break;
+
+              case field_id::list_links_prev_offset:
+                list_links.prev_offset = backend_.load_short (p);
+                break;
+              case field_id::list_links_next_offset:
+                list_links.next_offset = backend_.load_short (p);
+                break;
+              }
+          }
       }
 
     private:
@@ -270,6 +645,22 @@ namespace drtm
       // Once checked, tell if the structure was properly parsed.
       bool is_available = false;
 
+      // The probe of the header last parsed; 0 if there is no header.
+      uint32_t probe_ = 0;
+
+      // The size of the header last parsed, or read; 0 if not known.
+      std::size_t header_size_bytes_ = 0;
+
+      // Incremented each time the header is decoded.
+      uint32_t generation_ = 0;
+
+      // True if the offline metadata is used instead of the header.
+      bool is_offline_ = false;
+      offline_metadata_t offline_;
+
+      // A local copy of the target header.
+      uint8_t header_[header_max_size_bytes];
+
       // 0x00, 4 bytes
       uint8_t magic[4];
 
@@ -282,6 +673,14 @@ namespace drtm
         uint8_t patch;
       } version;
 
+      static const schema_entry_t v0_entries_[];
+      static const schema_entry_t v1_entries_[];
+      static const schema_entry_t v1_1_entries_[];
+      static const schema_entry_t v1_2_entries_[];
+      static const schema_entry_t v1_3_entries_[];
+      static const schema_entry_t v1_4_entries_[];
+      static const schema_t schemas_[6];
+
     public:
 
       struct scheduler_s
@@ -294,6 +693,31 @@ namespace drtm
 
         // 0x10, 32-bits pointer
         addr_t current_thread_addr;
+
+        // v1.1 0x2C, 32-bits pointer to an array of pointers to the
+        // thread running on each core; 0 for single core targets.
+        addr_t current_threads_addr;
+
+        // v1.1 0x30, 16-bits unsigned int; 1 in older versions.
+        uint16_t cores_count;
+
+        // v1.2 0x34, 32-bits pointer to a 32-bits counter, incremented
+        // by the scheduler when a thread is created, destroyed or
+        // moved to another parent; 0 if not available.
+        addr_t threads_generation_addr;
+
+        // v1.3 0x38, 32-bits pointer to an array of pointers to all
+        // threads, kept updated by the scheduler; 0 if not available.
+        addr_t threads_table_addr;
+
+        // v1.3 0x3C, 32-bits pointer to the 32-bits number of valid
+        // entries in the threads table.
+        addr_t threads_count_addr;
+
+        // v1.4 0x40, 32-bits pointer to a 32-bits sequence counter,
+        // incremented by the scheduler before and after changing the
+        // threads, so it is odd while they change; 0 if not available.
+        addr_t sequence_addr;
       } scheduler;
 
       struct thread_s
@@ -307,30 +731,33 @@ namespace drtm
         // 0x18, 16-bits unsigned int
         offset_t list_node_offset;
 
-        // 0x1C, 16-bits unsigned int
+        // 0x1A, 16-bits unsigned int
         offset_t children_node_offset;
 
-        // 0x20, 16-bits unsigned int
+        // 0x1C, 16-bits unsigned int
         offset_t state_offset;
 
-        // 0x22, 16-bits unsigned int
+        // 0x1E, 16-bits unsigned int
         offset_t stack_offset;
 
-        // 0x24, 16-bits unsigned int
+        // 0x20, 16-bits unsigned int
         offset_t prio_assigned_offset;
 
-        // 0x26, 16-bits unsigned int
+        // 0x22, 16-bits unsigned int
         offset_t prio_inherited_offset;
 
-        offset_t stack_exc_offset_words;
+        // v1 0x28, 16-bits unsigned int; the offset in words, from SP,
+        // of the frame selector (like EXC_RETURN), or 0 to use the
+        // frame policy default.
+        offset_t stack_selector_offset_words;
       } thread;
 
       struct list_links_s
       {
-        // TODO
+        // v1 0x24, 16-bits unsigned int; 0 in v0.
         offset_t prev_offset;
 
-        // TODO
+        // v1 0x26, 16-bits unsigned int; 4 in v0.
         offset_t next_offset;
       } list_links;
 
@@ -338,6 +765,153 @@ namespace drtm
 
 #pragma GCC diagnostic pop
 
+  // --------------------------------------------------------------------------
+  // Header schemas.
+
+  // v0.x, the simple structure.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v0_entries_[] =
+      {
+      //
+          { field_id::scheduler_is_started_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_IS_STARTED_ADDR }, //
+          { field_id::scheduler_top_threads_list_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_TOP_THREADS_LIST_ADDR }, //
+          { field_id::scheduler_current_thread_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREAD_ADDR }, //
+          { field_id::thread_name_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_NAME_OFFSET }, //
+          { field_id::thread_parent_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_PARENT_OFFSET }, //
+          { field_id::thread_list_node_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_LIST_NODE_OFFSET }, //
+          { field_id::thread_children_node_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_CHILDREN_NODE_OFFSET }, //
+          { field_id::thread_state_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_STATE_OFFSET }, //
+          { field_id::thread_stack_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_OFFSET }, //
+          { field_id::thread_prio_assigned_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_ASSIGNED }, //
+          { field_id::thread_prio_inherited_offset,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_INHERITED }, //
+      /**/
+      };
+
+  // v1.x adds to v0 the list links and frame offsets.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v1_entries_[] =
+      {
+      //
+          { field_id::list_links_prev_offset,
+          OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_PREV_OFFSET }, //
+          { field_id::list_links_next_offset,
+          OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_NEXT_OFFSET }, //
+          { field_id::thread_stack_selector_offset_words,
+          OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_SELECTOR_OFFSET }, //
+      /**/
+      };
+
+  // v1.1 adds the per core current threads.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v1_1_entries_[] =
+      {
+      //
+          { field_id::scheduler_current_threads_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREADS_ADDR }, //
+          { field_id::scheduler_cores_count,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT }, //
+      /**/
+      };
+
+  // v1.2 adds the thread lists generation.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v1_2_entries_[] =
+      {
+      //
+          { field_id::scheduler_threads_generation_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_GENERATION_ADDR }, //
+      /**/
+      };
+
+  // v1.3 adds the threads table.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v1_3_entries_[] =
+      {
+      //
+          { field_id::scheduler_threads_table_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_TABLE_ADDR }, //
+          { field_id::scheduler_threads_count_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_COUNT_ADDR }, //
+      /**/
+      };
+
+  // v1.4 adds the sequence counter.
+  template<typename B>
+    const typename metadata<B>::schema_entry_t metadata<B>::v1_4_entries_[] =
+      {
+      //
+          { field_id::scheduler_sequence_addr,
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_SEQUENCE_ADDR }, //
+      /**/
+      };
+
+  // Each version extends the previous one, at the same offsets.
+  template<typename B>
+    const typename metadata<B>::schema_t metadata<B>::schemas_[6] =
+      {
+      //
+          {
+              .major = 0, //
+              .minor = 0, //
+              .header_size_bytes = OS_RTOS_DRTM_V0_SIZEOF, //
+              .base = nullptr, //
+              .entries = v0_entries_, //
+              .entries_size = sizeof(v0_entries_) / sizeof(v0_entries_[0]) //
+          }, //
+          {
+              .major = 1, //
+              .minor = 0, //
+              .header_size_bytes = OS_RTOS_DRTM_V1_SIZEOF, //
+              .base = &schemas_[0], //
+              .entries = v1_entries_, //
+              .entries_size = sizeof(v1_entries_) / sizeof(v1_entries_[0]) //
+          }, //
+          {
+              .major = 1, //
+              .minor = 1, //
+              .header_size_bytes = OS_RTOS_DRTM_V1_1_SIZEOF, //
+              .base = &schemas_[1], //
+              .entries = v1_1_entries_, //
+              .entries_size = sizeof(v1_1_entries_) / sizeof(v1_1_entries_[0]) //
+          }, //
+          {
+              .major = 1, //
+              .minor = 2, //
+              .header_size_bytes = OS_RTOS_DRTM_V1_2_SIZEOF, //
+              .base = &schemas_[2], //
+              .entries = v1_2_entries_, //
+              .entries_size = sizeof(v1_2_entries_) / sizeof(v1_2_entries_[0]) //
+          }, //
+          {
+              .major = 1, //
+              .minor = 3, //
+              .header_size_bytes = OS_RTOS_DRTM_V1_3_SIZEOF, //
+              .base = &schemas_[3], //
+              .entries = v1_3_entries_, //
+              .entries_size = sizeof(v1_3_entries_) / sizeof(v1_3_entries_[0]) //
+          }, //
+          {
+              .major = 1, //
+              .minor = 4, //
+              .header_size_bytes = OS_RTOS_DRTM_V1_4_SIZEOF, //
+              .base = &schemas_[4], //
+              .entries = v1_4_entries_, //
+              .entries_size = sizeof(v1_4_entries_) / sizeof(v1_4_entries_[0]) //
+          }, //
+      /**/
+      };
+
 // ----------------------------------------------------------------------------
 } /* namespace drtm */
 
@@ -0,0 +1,401 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_POLLER_H_
+#define DRTM_POLLER_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+
+// The size of the thread names in the live views, including the
+// terminator; longer names are truncated.
+#if !defined(DRTM_POLLER_NAME_SIZE_BYTES)
+#define DRTM_POLLER_NAME_SIZE_BYTES   32
+#endif
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief A class template to refresh the thread list in the
+   * background, while the target runs.
+   *
+   * @details
+   * A host thread calls `update_thread_list()` at a configurable
+   * period; after each update, the states and priorities of the
+   * threads are copied in a view and handed to a single consumer
+   * (like a dashboard) through a lock-free single producer, single
+   * consumer ring. When the consumer is late and the ring is full,
+   * the newest view is dropped.
+   *
+   * The backend must be able to read the target memory without
+   * halting it (like via the Cortex-M debug access port).
+   *
+   * While the poller runs it is the only one allowed to update
+   * the frontend; stop it before updating at a halt.
+   *
+   * @tparam Fe The frontend type.
+   * @tparam N The number of views in the ring.
+   */
+  template<typename Fe, std::size_t N = 4>
+    class poller
+    {
+    public:
+
+      using frontend_type = Fe;
+      using allocator_type = typename frontend_type::allocator_type;
+      using thread_type = typename frontend_type::thread_type;
+      using thread_id_t = typename frontend_type::thread_id_t;
+
+      static constexpr std::size_t views_size = N;
+
+      static_assert(views_size >= 2, "At least 2 views are needed");
+
+      static constexpr std::size_t name_size_bytes =
+      DRTM_POLLER_NAME_SIZE_BYTES;
+
+      /**
+       * @brief The live details of a thread.
+       */
+      struct thread_view_s
+      {
+        thread_id_t id;
+        uint8_t state;
+        uint8_t prio_assigned;
+        uint8_t prio_inherited;
+        bool is_running;
+        char name[name_size_bytes];
+      };
+
+      using thread_view_type = struct thread_view_s;
+
+      // Make a new allocator, for the thread views.
+      using thread_view_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<thread_view_type>;
+
+      using thread_views_type = class std::vector<thread_view_type, thread_view_allocator_type>;
+
+      /**
+       * @brief The threads, as seen at one poll.
+       */
+      struct view_s
+      {
+        view_s (allocator_type& allocator) :
+            threads
+              { thread_view_allocator_type (allocator) }
+        {
+        }
+
+        // The number of the poll, from 1.
+        uint64_t sequence = 0;
+        // The result of `update_thread_list()`.
+        int status = 0;
+        thread_views_type threads;
+      };
+
+      using view_type = struct view_s;
+
+    public:
+
+      poller (frontend_type& frontend, allocator_type& allocator) :
+          frontend_ (frontend), // Parenthesis used to compile with 4.8
+          allocator_ (allocator)
+      {
+#if defined(DEBUG)
+        printf ("%s(%p, %p) @%p\n", __func__, &frontend, &allocator, this);
+#endif /* defined(DEBUG) */
+
+        views_.reserve (views_size);
+        for (std::size_t i = 0; i < views_size; ++i)
+          {
+            views_.emplace_back (allocator_);
+          }
+      }
+
+      // The rule of five.
+      poller (const poller&) = delete;
+      poller (poller&&) = delete;
+      poller&
+      operator= (const poller&) = delete;
+      poller&
+      operator= (poller&&) = delete;
+
+      ~poller ()
+      {
+#if defined(DEBUG)
+        printf ("%s() @%p\n", __func__, this);
+#endif /* defined(DEBUG) */
+
+        stop ();
+      }
+
+    public:
+
+      /**
+       * @brief Start polling, on a new host thread.
+       *
+       * @param period The time between the start of two updates.
+       * @retval true The poller was started.
+       * @retval false The poller was already running.
+       */
+      bool
+      start (std::chrono::milliseconds period)
+      {
+        if (thread_.joinable ())
+          {
+            return false;
+          }
+
+        period_ = period;
+        {
+          std::lock_guard<std::mutex> lock
+            { mutex_ };
+          is_stopping_ = false;
+        }
+        thread_ = std::thread
+          { &poller::run, this };
+
+        return true;
+      }
+
+      /**
+       * @brief Stop polling and wait for the host thread to exit;
+       * the views not yet consumed are kept.
+       */
+      void
+      stop (void)
+      {
+        if (!thread_.joinable ())
+          {
+            return;
+          }
+
+        {
+          std::lock_guard<std::mutex> lock
+            { mutex_ };
+          is_stopping_ = true;
+        }
+        cv_.notify_one ();
+
+        thread_.join ();
+      }
+
+      inline bool
+      is_running (void)
+      {
+        return thread_.joinable ();
+      }
+
+      /**
+       * @brief Poll once, on the caller thread.
+       *
+       * @details
+       * This is the body of the polling loop; it can also be used
+       * without starting the poller, when the caller has its own
+       * timing, but not while the poller runs.
+       */
+      void
+      poll (void)
+      {
+        int status = frontend_.update_thread_list ();
+        uint64_t sequence = polls_count_.fetch_add (
+            1, std::memory_order_relaxed) + 1;
+
+        std::size_t head = head_.load (std::memory_order_relaxed);
+        if (head - tail_.load (std::memory_order_acquire) >= views_size)
+          {
+            // The consumer is late, the ring is full.
+            dropped_count_.fetch_add (1, std::memory_order_relaxed);
+            return;
+          }
+
+        view_type& view = views_[head % views_size];
+        view.sequence = sequence;
+        view.status = status;
+        view.threads.clear ();
+
+        frontend_.visit_threads ([&view](thread_type* th, bool is_running)
+          {
+            thread_view_type tv;
+            tv.id = th->id ();
+            tv.state = th->state;
+            tv.prio_assigned = th->prio_assigned;
+            tv.prio_inherited = th->prio_inherited;
+            tv.is_running = is_running;
+            std::strncpy (tv.name, th->name, sizeof(tv.name) - 1);
+            tv.name[sizeof(tv.name) - 1] = '\0';
+
+            view.threads.push_back (tv);
+          });
+
+        head_.store (head + 1, std::memory_order_release);
+      }
+
+      /**
+       * @brief Get the oldest view not yet consumed.
+       *
+       * @details
+       * Must be called from a single consumer thread. The threads
+       * are copied into the view passed by the caller, which may
+       * use a different allocator; once its buffer is grown, there
+       * are no allocations.
+       *
+       * @param [out] out The view.
+       * @retval true A view was returned.
+       * @retval false There are no new views.
+       */
+      bool
+      try_pop (view_type& out)
+      {
+        std::size_t tail = tail_.load (std::memory_order_relaxed);
+        if (tail == head_.load (std::memory_order_acquire))
+          {
+            return false;
+          }
+
+        view_type& view = views_[tail % views_size];
+        out.sequence = view.sequence;
+        out.status = view.status;
+        out.threads.assign (view.threads.begin (), view.threads.end ());
+
+        tail_.store (tail + 1, std::memory_order_release);
+
+        return true;
+      }
+
+      /**
+       * @brief Get the number of polls since construction.
+       */
+      inline uint64_t
+      polls_count (void)
+      {
+        return polls_count_.load (std::memory_order_relaxed);
+      }
+
+      /**
+       * @brief Get the number of views dropped because the
+       * ring was full.
+       */
+      inline uint64_t
+      dropped_count (void)
+      {
+        return dropped_count_.load (std::memory_order_relaxed);
+      }
+
+    private:
+
+      void
+      run (void)
+      {
+#if defined(DEBUG)
+        printf ("%s() @%p\n", __func__, this);
+#endif /* defined(DEBUG) */
+
+        auto next = std::chrono::steady_clock::now ();
+        std::unique_lock<std::mutex> lock
+          { mutex_ };
+        while (!is_stopping_)
+          {
+            lock.unlock ();
+            poll ();
+            lock.lock ();
+
+            // Keep the rate, even if an update was slow.
+            next += period_;
+            auto now = std::chrono::steady_clock::now ();
+            if (next < now)
+              {
+                next = now;
+              }
+            cv_.wait_until (lock, next, [this]
+              { return is_stopping_;});
+          }
+      }
+
+    private:
+
+      // The type of the views ring.
+      using view_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<view_type>;
+
+      using views_type = class std::vector<view_type, view_allocator_type>;
+
+      frontend_type& frontend_;
+      allocator_type& allocator_;
+
+      views_type views_
+        { view_allocator_type (allocator_) };
+
+      // Written only by the producer, the number of views pushed.
+      std::atomic<std::size_t> head_
+        { 0 };
+      // Written only by the consumer, the number of views popped.
+      std::atomic<std::size_t> tail_
+        { 0 };
+
+      // Written only by the producer, read by any thread.
+      std::atomic<uint64_t> polls_count_
+        { 0 };
+      std::atomic<uint64_t> dropped_count_
+        { 0 };
+
+      std::chrono::milliseconds period_
+        { 100 };
+
+      std::thread thread_;
+      std::mutex mutex_;
+      std::condition_variable cv_;
+      bool is_stopping_ = false;
+    };
+
+#pragma GCC diagnostic pop
+
+  template<typename Fe, std::size_t N>
+    constexpr std::size_t poller<Fe, N>::views_size;
+
+  template<typename Fe, std::size_t N>
+    constexpr std::size_t poller<Fe, N>::name_size_bytes;
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_POLLER_H_ */
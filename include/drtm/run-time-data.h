@@ -31,10 +31,34 @@
 #if defined(__cplusplus)
 
 #include <drtm/types.h>
+#include <drtm/frames.h>
 #include <drtm/metadata.h>
 #include <drtm/threads.h>
+#include <drtm/spin-lock.h>
 
 #include <memory>
+#include <algorithm>
+#include <chrono>
+
+// The number of threads table entries read in a single transaction.
+#if !defined(DRTM_THREADS_TABLE_CHUNK_COUNT)
+#define DRTM_THREADS_TABLE_CHUNK_COUNT   64
+#endif
+
+// Larger counts are considered corrupted.
+#if !defined(DRTM_THREADS_TABLE_MAX_COUNT)
+#define DRTM_THREADS_TABLE_MAX_COUNT   1024
+#endif
+
+// The largest span of thread members read in a single transaction.
+#if !defined(DRTM_THREAD_BLOCK_MAX_SIZE_BYTES)
+#define DRTM_THREAD_BLOCK_MAX_SIZE_BYTES   128
+#endif
+
+// The deepest thread children lists walked by the budgeted update.
+#if !defined(DRTM_THREADS_DEPTH_MAX_COUNT)
+#define DRTM_THREADS_DEPTH_MAX_COUNT   16
+#endif
 
 namespace drtm
 {
@@ -42,24 +66,34 @@ namespace drtm
   /**
    * A class template to manage the run-time data, like iterate through
    * the thread lists, tell if scheduler started, etc.
+   *
+   * @tparam F The stack frame layout policy, from `frames.h`.
+   * @tparam M The metadata, parsed from the target (`metadata`) or
+   *  known at compile time (`static_metadata`).
    */
-  template<typename B, typename A>
+  template<typename B, typename A, typename F = default_frame_type,
+      typename M = metadata<B>>
     class run_time_data
     {
     public:
 
       using backend_type = B;
       using allocator_type = A;
+      using frame_type = F;
 
-      using metadata_type = class metadata<B>;
-      using threads_type = class threads<B, A>;
+      using metadata_type = M;
+      using threads_type = class threads<B, A, F>;
 
       using thread_type = typename threads_type::thread_type;
 
       using thread_addr_t = typename thread_type::thread_addr_t;
+      using thread_id_t = typename thread_type::thread_id_t;
 
       using addr_t = typename backend_type::target_addr_t;
 
+      static_assert(frame_type::register_size_bytes == 4,
+          "Only 32-bits registers are supported");
+
       // Address of a target list node.
       using list_node_addr_t = addr_t;
 
@@ -70,6 +104,108 @@ namespace drtm
       using char_allocator_type =
       typename std::allocator_traits<allocator_type>::template rebind_alloc<char>;
 
+      // The members of a thread read in a single transaction.
+      typedef struct members_s
+      {
+        thread_addr_t addr;
+        addr_t name_addr;
+        uint8_t sp_addr[thread_type::register_size_bytes];
+        uint8_t prio_assigned;
+        uint8_t prio_inherited;
+        uint8_t state;
+        // False if only the address is known.
+        bool is_read;
+        // True if the ID was already streamed.
+        bool is_yielded;
+        // The order in which the thread was found.
+        uint32_t order;
+      } members_t;
+
+      using members_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<members_t>;
+
+      using capacity_type = capacity_traits<allocator_type>;
+
+      using members_collection_type = typename std::conditional<capacity_type::is_fixed,
+      fixed_vector<members_t, capacity_type::threads_max_count>,
+      std::vector<members_t, members_allocator_type>>::type;
+
+      /**
+       * @brief The state of a budgeted update, kept between calls,
+       * while the two snapshots alternate.
+       */
+      struct progress_s
+      {
+        progress_s (allocator_type& allocator) :
+            pending
+              { members_allocator_type (allocator) }
+        {
+        }
+
+        enum class phase_t
+          : uint8_t
+            {
+              idle, //
+              enumerate, //
+              members, //
+              details
+        };
+
+        phase_t phase = phase_t::idle;
+
+        // The explicit stack of the lists walk.
+        struct frame_s
+        {
+          iterator it;
+          iterator end;
+        } frames[DRTM_THREADS_DEPTH_MAX_COUNT];
+        std::size_t depth = 0;
+
+        // The threads table, if used.
+        bool is_table = false;
+        uint32_t table_index = 0;
+        uint32_t table_count = 0;
+
+        // The threads found, not yet read, and the next one.
+        members_collection_type pending;
+        std::size_t next = 0;
+        // The number of threads found, for the discovery order.
+        uint32_t found_count = 0;
+
+        // The next running thread and the next pending thread
+        // to stream the ID of.
+        std::size_t yield_core = 0;
+        std::size_t yield_next = 0;
+        std::size_t yield_count = 0;
+
+        inline bool
+        is_active (void)
+        {
+          return phase != phase_t::idle;
+        }
+
+        void
+        reset (void)
+        {
+          phase = phase_t::idle;
+          depth = 0;
+          is_table = false;
+          table_index = 0;
+          table_count = 0;
+          pending.clear ();
+          next = 0;
+          found_count = 0;
+          yield_core = 0;
+          yield_next = 0;
+          yield_count = 0;
+        }
+      };
+
+      using progress_type = struct progress_s;
+
+      // The FNV-1a basis of the threads table hash.
+      static constexpr uint32_t table_hash_basis = 2166136261u;
+
     public:
 
       run_time_data (backend_type& backend, metadata_type& metadata,
@@ -97,230 +233,1594 @@ namespace drtm
 
     public:
 
-      bool
-      is_scheduler_started (void)
+      bool
+      is_scheduler_started (void)
+      {
+#if defined(DEBUG)
+        printf ("%s()\n", __func__);
+#endif /* defined(DEBUG) */
+
+        bool ret;
+
+        int err;
+        err = read_byte (metadata_.scheduler.is_started_addr,
+                         reinterpret_cast<uint8_t*> (&ret));
+        if (err < 0)
+          {
+            backend_.output_error ("Could not read 'is_started'.\n");
+            return false;
+          }
+
+#if defined(DEBUG)
+        printf ("%s() @0x%08X 0x%02X\n", __func__,
+                metadata_.scheduler.is_started_addr, ret);
+#endif /* defined(DEBUG) */
+
+        return ret;
+      }
+
+      /**
+       * @brief Update the local list of threads.
+       *
+       * @details
+       * If the target provides the thread lists generation, and it
+       * did not change since these threads were collected, the lists
+       * are not walked again; only the state, the priorities and
+       * the stack of each known thread are read. Since the counter
+       * restarts with the target, the tree is first checked with a
+       * few transactions, like for the step mode.
+       */
+      void
+      update_threads (void)
+      {
+        uint32_t generation = 0;
+        bool has_generation = read_threads_generation (&generation);
+
+        if (has_generation && is_generation_known_
+            && generation == threads_generation_
+            && metadata_generation_ == metadata_.generation ()
+            && is_tree_valid ())
+          {
+#if defined(DEBUG)
+            printf ("%s() generation %u unchanged\n", __func__, generation);
+#endif /* defined(DEBUG) */
+
+            for (auto* th : threads_)
+              {
+                th->clear_state ();
+                read_thread_state (th, th->addr ());
+              }
+
+            // The running threads were read by the check.
+            link_current_threads ();
+            return;
+          }
+
+        threads_.clear ();
+        is_table_used_ = enumerate_threads_table ();
+        if (!is_table_used_)
+          {
+            // Older firmware, walk the lists.
+            threads_.clear ();
+            iterate_threads (0, 0);
+          }
+
+        is_generation_known_ = has_generation;
+        threads_generation_ = generation;
+        metadata_generation_ = metadata_.generation ();
+
+        update_current_thread ();
+      }
+
+      /**
+       * @brief Continue a budgeted update of the threads.
+       *
+       * @details
+       * The work is split in small steps, and the budget is checked
+       * before each step:
+       * - the threads running on each core are read first; this is
+       *   always done by the first call, regardless of the budget;
+       * - the lists are walked, with an explicit stack (or the
+       *   threads table is read), collecting only the addresses;
+       * - the name pointer, the priorities, the state and the stack
+       *   pointer of each thread are read in a single transaction;
+       * - the other threads are read, highest priority first.
+       *
+       * Only the threads completely read, and those whose IDs were
+       * streamed, with only the address, are in the collection, so
+       * a partial collection is consistent, but not complete.
+       *
+       * @param p The progress, kept between calls.
+       * @param budget The limits of this call.
+       *
+       * @retval true All threads were read.
+       * @retval false The budget was exhausted; call again, after
+       *  `resume_from()`, to continue.
+       */
+      bool
+      update_threads (progress_type& p, const update_budget_t& budget)
+      {
+        uint32_t transactions_begin = transactions_count_;
+        auto time_begin = std::chrono::steady_clock::now ();
+
+        if (!p.is_active ())
+          {
+            start_update (p);
+          }
+
+        while (p.is_active ())
+          {
+            if (budget.transactions_max_count != 0
+                && transactions_count_ - transactions_begin
+                    >= budget.transactions_max_count)
+              {
+                break;
+              }
+            if (budget.duration_max_us != 0
+                && std::chrono::steady_clock::now () - time_begin
+                    >= std::chrono::microseconds (budget.duration_max_us))
+              {
+                break;
+              }
+
+            switch (p.phase)
+              {
+              case progress_type::phase_t::enumerate:
+                enumerate_step (p);
+                break;
+              case progress_type::phase_t::members:
+                members_step (p);
+                break;
+              case progress_type::phase_t::details:
+                details_step (p);
+                break;
+              default:
+                p.phase = progress_type::phase_t::idle;
+                break;
+              }
+          }
+
+        link_current_threads ();
+
+#if defined(DEBUG)
+        printf ("%s() %u transactions, %zu threads%s\n", __func__,
+                transactions_count_ - transactions_begin, threads_.size (),
+                p.is_active () ? ", incomplete" : "");
+#endif /* defined(DEBUG) */
+
+        return !p.is_active ();
+      }
+
+      /**
+       * @brief Stream the IDs of the threads, as they are found.
+       *
+       * @details
+       * The IDs of the running threads are returned first, then
+       * the IDs of the other threads, in the order the enumeration
+       * finds them; the enumeration advances only as far as needed
+       * to return `max_count` IDs. The thread details are not read;
+       * each streamed thread is added with only its address, and is
+       * read when continuing with `update_threads(p, budget)`.
+       *
+       * If the update is restarted (like after the target ran),
+       * the IDs are streamed again, from the beginning.
+       *
+       * @param p The progress, shared with the budgeted update.
+       * @param ids The output array.
+       * @param max_count The size of the output array.
+       *
+       * @return The number of IDs returned; 0 if all were streamed.
+       */
+      std::size_t
+      stream_thread_ids (progress_type& p, thread_id_t* ids,
+                         std::size_t max_count)
+      {
+        if (!p.is_active ())
+          {
+            start_update (p);
+          }
+
+        std::size_t count = 0;
+        while (count < max_count)
+          {
+            if (capacity_type::is_fixed
+                && p.yield_count >= capacity_type::threads_max_count)
+              {
+                // The other threads will not be shown.
+                break;
+              }
+
+            thread_addr_t thread_addr = next_yield_addr (p);
+            if (thread_addr != 0)
+              {
+                // The queries for the streamed IDs must find the
+                // threads in the published snapshot.
+                if (find_thread (thread_addr) == nullptr
+                    && !add_placeholder (thread_addr))
+                  {
+                    break;
+                  }
+
+                // The same as thread::id().
+                ids[count++] = static_cast<thread_id_t> (thread_addr >> 2);
+                ++p.yield_count;
+                continue;
+              }
+
+            if (p.phase != progress_type::phase_t::enumerate)
+              {
+                // All found threads were streamed.
+                break;
+              }
+            enumerate_step (p);
+          }
+
+        link_current_threads ();
+
+#if defined(DEBUG)
+        printf ("%s() %zu ids\n", __func__, count);
+#endif /* defined(DEBUG) */
+
+        return count;
+      }
+
+      /**
+       * @brief Copy the threads of a partial update from the other
+       * snapshot, to continue the budgeted update; no target
+       * accesses.
+       */
+      void
+      resume_from (run_time_data& other)
+      {
+        threads_.clear ();
+        for (auto* o : other.threads_)
+          {
+            thread_type* th = threads_.new_thread ();
+            if (th == nullptr)
+              {
+                break;
+              }
+            th->copy_from (*o);
+          }
+
+        std::copy (&other.current_addrs_[0],
+                   &other.current_addrs_[DRTM_CORES_MAX_COUNT],
+                   &current_addrs_[0]);
+        cores_count_ = other.cores_count_;
+        top_list_prev_ = other.top_list_prev_;
+        top_list_next_ = other.top_list_next_;
+        is_table_used_ = other.is_table_used_;
+        threads_table_count_ = other.threads_table_count_;
+        threads_table_hashed_count_ = other.threads_table_hashed_count_;
+        threads_table_hash_ = other.threads_table_hash_;
+        is_generation_known_ = false;
+        // Warn only once per pass, whichever snapshot continues it.
+        is_capacity_reported_ = is_capacity_reported_
+            || other.is_capacity_reported_;
+
+        link_current_threads ();
+      }
+
+      /**
+       * @brief Clear the local list of threads, for example when
+       * the scheduler is not started.
+       */
+      void
+      clear_threads (void)
+      {
+        threads_.clear ();
+        is_generation_known_ = false;
+      }
+
+      /**
+       * @brief Read the target sequence counter, before reading
+       * the threads while the target runs.
+       *
+       * @retval true The counter was read, call
+       *  `end_consistent_read()` after reading the threads.
+       * @retval false Not available, the reads cannot be checked.
+       */
+      bool
+      begin_consistent_read (uint32_t* sequence)
+      {
+        if (metadata_.scheduler.sequence_addr == 0)
+          {
+            return false;
+          }
+
+        int ret;
+        ret = read_long (metadata_.scheduler.sequence_addr, sequence);
+        is_sequence_read_failed_ = (ret < 0);
+        if (ret < 0)
+          {
+            // Odd, it will be read again.
+            *sequence = 1;
+          }
+
+        return true;
+      }
+
+      /**
+       * @brief Read the target sequence counter again, after
+       * reading the threads, and compare it.
+       *
+       * @details
+       * If the threads changed meanwhile, the next update does not
+       * reuse them, even if the generation is the same.
+       *
+       * @retval true The threads did not change while read.
+       * @retval false The threads changed, or were changing, while read.
+       */
+      bool
+      end_consistent_read (uint32_t sequence)
+      {
+        uint32_t after = 1;
+        int ret;
+        ret = read_long (metadata_.scheduler.sequence_addr, &after);
+        is_sequence_read_failed_ = is_sequence_read_failed_ || (ret < 0);
+
+        bool is_consistent = (ret >= 0 && (sequence & 1) == 0
+            && after == sequence);
+        if (!is_consistent)
+          {
+            is_generation_known_ = false;
+          }
+
+        return is_consistent;
+      }
+
+      /**
+       * @brief Tell if the sequence counter could not be read by
+       * the last consistent read; the metadata may be stale, like
+       * after the firmware was reflashed.
+       */
+      inline bool
+      is_sequence_read_failed (void)
+      {
+        return is_sequence_read_failed_;
+      }
+
+      /**
+       * @brief Read the thread lists generation, if the target
+       * provides it.
+       *
+       * @retval true The generation was read.
+       * @retval false Not available, or could not be read.
+       */
+      bool
+      read_threads_generation (uint32_t* generation)
+      {
+        if (metadata_.scheduler.threads_generation_addr == 0)
+          {
+            return false;
+          }
+
+        int ret;
+        ret = read_long (metadata_.scheduler.threads_generation_addr,
+                         generation);
+        if (ret < 0)
+          {
+            backend_.output_error (
+                "Could not read 'scheduler.threads_generation'.\n");
+            return false;
+          }
+
+        return true;
+      }
+
+      /**
+       * @brief Iterate through the thread children, each with its children.
+       */
+      void
+      iterate_threads (thread_addr_t ta, unsigned int depth)
+      {
+#if defined(DEBUG) && defined(DEBUG_LISTS)
+        printf ("%s(0x%08X, %u)\n", __func__, ta, depth);
+#endif /* defined(DEBUG) */
+
+        iterator it = children_threads_iter_begin (ta);
+        iterator end = children_threads_iter_end (ta);
+
+        if (ta == 0)
+          {
+            // Remember the top list links, to check later if it changed.
+            top_list_next_ = it;
+            top_list_prev_ = end;
+          }
+
+        while (it != end)
+          {
+            // Get the pointer to the thread from the iterator.
+            thread_addr_t thread_addr = children_threads_iter_get (it);
+
+            thread_type* th = threads_.new_thread ();
+            if (th == nullptr)
+              {
+                // Fixed capacity, the other threads are not shown.
+                report_capacity ();
+                return;
+              }
+
+            // Remember the thread address, it is used to determine the
+            // current thread.
+            // This will also set the ID.
+            th->addr (thread_addr);
+
+            read_thread_name (th, thread_addr);
+            read_thread_state (th, thread_addr);
+
+#if defined(DEBUG)
+            printf ("thread @0x%08X '%s' S:%u P:%u(%u) %s\n", thread_addr,
+                    th->name, th->state, th->prio_inherited, th->prio_assigned,
+                    (th->stack.is_floating_point ? "FP" : ""));
+#endif /* defined(DEBUG) */
+
+            // Go down one level.
+            iterate_threads (thread_addr, depth + 1);
+
+            if (ta == 0)
+              {
+                top_list_prev_ = it;
+              }
+
+            // Increment the iterator to the next element in the list.
+            it = children_threads_iter_next (it);
+          }
+      }
+
+      /**
+       * @brief Read the thread name, byte by byte.
+       */
+      void
+      read_thread_name (thread_type* th, thread_addr_t thread_addr)
+      {
+        // Get the address of the name string.
+        int ret;
+        addr_t name_addr = 0;
+        ret = read_long (thread_addr + metadata_.thread.name_offset,
+                         &name_addr);
+        if (ret < 0)
+          {
+            backend_.output_error ("Could not read 'thread.name*'.\n");
+          }
+
+        read_name_string (th, name_addr);
+      }
+
+      /**
+       * @brief Copy the name string from the target.
+       */
+      void
+      read_name_string (thread_type* th, addr_t name_addr)
+      {
+        int ret;
+        uint8_t b = 0;
+
+        // Copy the name, byte by byte. A large array copy is risky, since the
+        // thread might be allocated right at the end of RAM, and
+        // the copy might try to access past the limit.
+        if (name_addr != 0)
+          {
+            addr_t addr = name_addr;
+            char* p = &th->name[0];
+            std::size_t count = 0;
+            while (count < thread_type::name_max_size_bytes - 1)
+              {
+                ret = read_byte (addr, &b);
+                if (ret < 0)
+                  {
+                    backend_.output_error ("Could not read 'thread.name'.\n");
+                    break;
+                  }
+                *p = static_cast<char> (b);
+                ++p;
+                ++addr;
+                ++count;
+                if (b == '\0')
+                  {
+                    break;
+                  }
+              }
+            *p = '\0'; // Be sure the string is terminated.
+          }
+      }
+
+      /**
+       * @brief Read the members that change while the thread runs,
+       * the priorities, the state and the stack.
+       */
+      void
+      read_thread_state (thread_type* th, thread_addr_t thread_addr)
+      {
+        addr_t addr;
+        uint8_t b = 0;
+        int ret;
+
+        addr = thread_addr + metadata_.thread.prio_assigned_offset;
+        ret = read_byte (addr, &b);
+        if (ret < 0)
+          {
+            backend_.output_error ("Could not read 'thread.prio_assigned'.\n");
+          }
+        th->prio_assigned = b;
+
+        addr = thread_addr + metadata_.thread.prio_inherited_offset;
+        ret = read_byte (addr, &b);
+        if (ret < 0)
+          {
+            backend_.output_error ("Could not read 'thread.prio_inherited'.\n");
+          }
+        th->prio_inherited = b;
+
+        addr = thread_addr + metadata_.thread.state_offset;
+        ret = read_byte (addr, &b);
+        if (ret < 0)
+          {
+            backend_.output_error ("Could not read 'thread.state'.\n");
+          }
+        th->state = b;
+
+        addr = thread_addr + metadata_.thread.stack_offset;
+        ret = read_byte_array (addr, &th->stack.sp_addr[0],
+                               thread_type::register_size_bytes);
+        if (ret < 0)
+          {
+            backend_.output_error ("Could not read 'thread.stack_ptr'.\n");
+          }
+
+        th->stack.addr = backend_.load_long (&th->stack.sp_addr[0]);
+
+        read_thread_frame (th);
+      }
+
+      /**
+       * @brief Read the name pointer, the priorities, the state and
+       * the stack pointer in a single transaction, then the name.
+       *
+       * @details
+       * If the members are too far apart, or the transaction fails,
+       * they are read one by one.
+       */
+      void
+      read_thread (thread_type* th, thread_addr_t thread_addr)
+      {
+        members_t m;
+        if (!read_members (thread_addr, &m))
+          {
+            read_thread_name (th, thread_addr);
+            read_thread_state (th, thread_addr);
+            return;
+          }
+
+        apply_members (th, m);
+      }
+
+      /**
+       * @brief Read the name pointer, the priorities, the state and
+       * the stack pointer in a single transaction.
+       *
+       * @retval true The members were read.
+       * @retval false Too far apart, or the transaction failed.
+       */
+      bool
+      read_members (thread_addr_t thread_addr, members_t* m)
+      {
+        constexpr std::size_t rsb = thread_type::register_size_bytes;
+
+        std::size_t name_offset = metadata_.thread.name_offset;
+        std::size_t prio_assigned_offset =
+            metadata_.thread.prio_assigned_offset;
+        std::size_t prio_inherited_offset =
+            metadata_.thread.prio_inherited_offset;
+        std::size_t state_offset = metadata_.thread.state_offset;
+        std::size_t stack_offset = metadata_.thread.stack_offset;
+
+        std::size_t first = std::min (
+          { name_offset, prio_assigned_offset, prio_inherited_offset,
+              state_offset, stack_offset });
+        std::size_t last = std::max (
+          { name_offset + rsb, prio_assigned_offset + 1,
+              prio_inherited_offset + 1, state_offset + 1, stack_offset + rsb });
+
+        uint8_t block[DRTM_THREAD_BLOCK_MAX_SIZE_BYTES];
+        if (last - first > sizeof(block))
+          {
+            return false;
+          }
+
+        int ret;
+        ret = read_byte_array (static_cast<addr_t> (thread_addr + first),
+                               &block[0], last - first);
+        if (ret < 0)
+          {
+            return false;
+          }
+
+        m->addr = thread_addr;
+        m->name_addr = backend_.load_long (&block[name_offset - first]);
+        std::memcpy (&m->sp_addr[0], &block[stack_offset - first], rsb);
+        m->prio_assigned = block[prio_assigned_offset - first];
+        m->prio_inherited = block[prio_inherited_offset - first];
+        m->state = block[state_offset - first];
+        m->is_read = true;
+
+        return true;
+      }
+
+      /**
+       * @brief Use the members read before, then read the name
+       * and decide the frame layout.
+       */
+      void
+      apply_members (thread_type* th, const members_t& m)
+      {
+        th->prio_assigned = m.prio_assigned;
+        th->prio_inherited = m.prio_inherited;
+        th->state = m.state;
+
+        std::memcpy (&th->stack.sp_addr[0], &m.sp_addr[0],
+                     thread_type::register_size_bytes);
+        th->stack.addr = backend_.load_long (&th->stack.sp_addr[0]);
+
+        read_name_string (th, m.name_addr);
+        read_thread_frame (th);
+      }
+
+      /**
+       * @brief Decide the frame layout, after the stack pointer
+       * was read.
+       */
+      void
+      read_thread_frame (thread_type* th)
+      {
+        // One read of the largest frame, which also decides
+        // the layout; if it fails, use the lazy path.
+        bool is_read = false;
+        if (speculative_frame_read_)
+          {
+            ++transactions_count_;
+            spin_lock_guard guard
+              { transactions_lock_ };
+
+            is_read = th->read_stack_speculative (selector_offset_words ());
+          }
+        if (!is_read)
+          {
+            decide_frame (th);
+          }
+      }
+
+      /**
+       * @brief Enumerate the threads from the flat threads table,
+       * if the target provides it.
+       *
+       * @details
+       * The number of entries is read first, then the table, in
+       * chunks of `DRTM_THREADS_TABLE_CHUNK_COUNT` pointers, each in
+       * a single transaction; then the members of each thread are
+       * read in a single transaction. Null entries are skipped.
+       *
+       * @retval true The threads were enumerated.
+       * @retval false Not available, or could not be read; the lists
+       *  should be walked.
+       */
+      bool
+      enumerate_threads_table (void)
+      {
+        constexpr std::size_t rsb = thread_type::register_size_bytes;
+
+        addr_t table_addr = metadata_.scheduler.threads_table_addr;
+        if (table_addr == 0 || metadata_.scheduler.threads_count_addr == 0)
+          {
+            return false;
+          }
+
+        uint32_t count = 0;
+        int ret;
+        ret = read_long (metadata_.scheduler.threads_count_addr,
+                         &count);
+        if (ret < 0)
+          {
+            backend_.output_error (
+                "Could not read 'scheduler.threads_count'.\n");
+            return false;
+          }
+        if (count > DRTM_THREADS_TABLE_MAX_COUNT)
+          {
+            backend_.output_error ("Threads table count %u too large.\n",
+                                   count);
+            return false;
+          }
+
+        threads_table_count_ = count;
+        threads_table_hashed_count_ = 0;
+        threads_table_hash_ = table_hash_basis;
+
+        uint8_t buf[DRTM_THREADS_TABLE_CHUNK_COUNT * rsb];
+        for (std::size_t i = 0; i < count; i += DRTM_THREADS_TABLE_CHUNK_COUNT)
+          {
+            std::size_t n = std::min<std::size_t> (
+                count - i, DRTM_THREADS_TABLE_CHUNK_COUNT);
+            ret = read_byte_array (
+                static_cast<addr_t> (table_addr + i * rsb), &buf[0], n * rsb);
+            if (ret < 0)
+              {
+                backend_.output_error (
+                    "Could not read 'scheduler.threads_table'.\n");
+                return false;
+              }
+
+            threads_table_hash_ = hash_table_entries (threads_table_hash_,
+                                                      &buf[0], n * rsb);
+            threads_table_hashed_count_ += static_cast<uint32_t> (n);
+
+            for (std::size_t j = 0; j < n; ++j)
+              {
+                thread_addr_t thread_addr = backend_.load_long (
+                    &buf[j * rsb]);
+                if (thread_addr == 0)
+                  {
+                    continue;
+                  }
+
+                thread_type* th = threads_.new_thread ();
+                if (th == nullptr)
+                  {
+                    report_capacity ();
+                    return true;
+                  }
+
+                // This will also set the ID.
+                th->addr (thread_addr);
+                read_thread (th, thread_addr);
+
+#if defined(DEBUG)
+                printf ("thread @0x%08X '%s' S:%u P:%u(%u) %s\n",
+                        thread_addr, th->name, th->state, th->prio_inherited,
+                        th->prio_assigned,
+                        (th->stack.is_floating_point ? "FP" : ""));
+#endif /* defined(DEBUG) */
+              }
+          }
+
+        return true;
+      }
+
+      /**
+       * @brief Begin a budgeted update; read the running threads
+       * and prepare the enumeration.
+       */
+      void
+      start_update (progress_type& p)
+      {
+        threads_.clear ();
+        p.reset ();
+
+        // Not walked as a whole, do not reuse.
+        is_generation_known_ = false;
+
+        if (read_running_addrs ())
+          {
+            for (std::size_t core = 0; core < cores_count_; ++core)
+              {
+                if (current_addrs_[core] != 0
+                    && find_thread (current_addrs_[core]) == nullptr)
+                  {
+                    add_thread (current_addrs_[core], nullptr);
+                  }
+              }
+          }
+
+        start_enumeration (p);
+      }
+
+      /**
+       * @brief Get the address of the next thread to stream the ID
+       * of, running threads first; 0 if none is left for now.
+       */
+      thread_addr_t
+      next_yield_addr (progress_type& p)
+      {
+        while (p.yield_core < cores_count_)
+          {
+            std::size_t core = p.yield_core++;
+            thread_addr_t thread_addr = current_addrs_[core];
+            // Skip the thread if it also runs on a previous core.
+            if (thread_addr != 0
+                && std::find (&current_addrs_[0], &current_addrs_[core],
+                              thread_addr) == &current_addrs_[core])
+              {
+                return thread_addr;
+              }
+          }
+
+        while (p.yield_next < p.pending.size ())
+          {
+            members_t& m = p.pending[p.yield_next++];
+            if (!m.is_yielded)
+              {
+                m.is_yielded = true;
+                return m.addr;
+              }
+          }
+
+        return 0;
+      }
+
+      /**
+       * @brief Prepare the enumeration of the threads, from the
+       * threads table if the target provides it, or from the lists.
+       */
+      void
+      start_enumeration (progress_type& p)
+      {
+        p.phase = progress_type::phase_t::enumerate;
+
+        if (metadata_.scheduler.threads_table_addr != 0
+            && metadata_.scheduler.threads_count_addr != 0)
+          {
+            uint32_t count = 0;
+            int ret;
+            ret = read_long (metadata_.scheduler.threads_count_addr, &count);
+            if (ret >= 0 && count <= DRTM_THREADS_TABLE_MAX_COUNT)
+              {
+                p.is_table = true;
+                p.table_count = count;
+                is_table_used_ = true;
+                threads_table_count_ = count;
+                threads_table_hashed_count_ = 0;
+                threads_table_hash_ = table_hash_basis;
+                return;
+              }
+          }
+
+        is_table_used_ = false;
+
+        // Remember the top list links, to check later if it changed;
+        // the lists walk may span several calls.
+        if (!read_top_list_links (&top_list_prev_, &top_list_next_))
+          {
+            top_list_prev_ = 0;
+            top_list_next_ = children_threads_iter_begin (0);
+          }
+
+        p.frames[0].it = top_list_next_;
+        p.frames[0].end = children_threads_iter_end (0);
+        p.depth = 1;
+      }
+
+      /**
+       * @brief Find the next thread, or read the next chunk of
+       * the threads table.
+       */
+      void
+      enumerate_step (progress_type& p)
+      {
+        constexpr std::size_t rsb = thread_type::register_size_bytes;
+
+        if (p.is_table)
+          {
+            if (p.table_index < p.table_count)
+              {
+                uint8_t buf[DRTM_THREADS_TABLE_CHUNK_COUNT * rsb];
+                std::size_t n = std::min<std::size_t> (
+                    p.table_count - p.table_index,
+                    DRTM_THREADS_TABLE_CHUNK_COUNT);
+                int ret;
+                ret = read_byte_array (
+                    static_cast<addr_t> (metadata_.scheduler.threads_table_addr
+                        + p.table_index * rsb),
+                    &buf[0], n * rsb);
+                if (ret < 0)
+                  {
+                    backend_.output_error (
+                        "Could not read 'scheduler.threads_table'.\n");
+                    n = p.table_count - p.table_index;
+                  }
+                else
+                  {
+                    threads_table_hash_ = hash_table_entries (
+                        threads_table_hash_, &buf[0], n * rsb);
+                    threads_table_hashed_count_ += static_cast<uint32_t> (n);
+
+                    for (std::size_t j = 0; j < n; ++j)
+                      {
+                        add_pending (p, backend_.load_long (&buf[j * rsb]));
+                      }
+                  }
+                p.table_index += static_cast<uint32_t> (n);
+                return;
+              }
+          }
+        else
+          {
+            while (p.depth > 0)
+              {
+                typename progress_type::frame_s& f = p.frames[p.depth - 1];
+                if (f.it == f.end)
+                  {
+                    // Go up one level.
+                    --p.depth;
+                    continue;
+                  }
+
+                thread_addr_t thread_addr = children_threads_iter_get (f.it);
+                add_pending (p, thread_addr);
+
+                f.it = children_threads_iter_next (f.it);
+
+                // Go down one level.
+                if (p.depth < DRTM_THREADS_DEPTH_MAX_COUNT)
+                  {
+                    p.frames[p.depth].it = children_threads_iter_begin (
+                        thread_addr);
+                    p.frames[p.depth].end = children_threads_iter_end (
+                        thread_addr);
+                    ++p.depth;
+                  }
+                else
+                  {
+                    report_depth (thread_addr);
+                  }
+                return;
+              }
+          }
+
+        p.phase = progress_type::phase_t::members;
+        p.next = 0;
+      }
+
+      /**
+       * @brief Remember a thread found by the enumeration, unless
+       * it is running, and was already read.
+       */
+      void
+      add_pending (progress_type& p, thread_addr_t thread_addr)
+      {
+        if (thread_addr == 0)
+          {
+            return;
+          }
+        for (std::size_t core = 0; core < cores_count_; ++core)
+          {
+            if (current_addrs_[core] == thread_addr)
+              {
+                return;
+              }
+          }
+
+        members_t m;
+        std::memset (&m, 0, sizeof(m));
+        m.addr = thread_addr;
+        m.order = p.found_count++;
+
+        if (capacity_type::is_fixed
+            && p.pending.size () >= p.pending.max_size ())
+          {
+            replace_pending (p, m);
+            return;
+          }
+        p.pending.push_back (m);
+      }
+
+      /**
+       * @brief With a fixed capacity, when all pending entries are
+       * used, keep the threads with the highest priorities.
+       *
+       * @details
+       * The priorities are not known while enumerating, so the
+       * members of the new thread, and of the pending threads not
+       * yet read, are read now (the members step does not read
+       * them again); the entry with the lowest priority, found last,
+       * is replaced, unless its ID was already streamed.
+       */
+      void
+      replace_pending (progress_type& p, members_t& m)
+      {
+        report_capacity ();
+
+        if (!read_members (m.addr, &m))
+          {
+            // The priority is not known, keep the threads found.
+            return;
+          }
+
+        members_t* lowest = nullptr;
+        for (auto& e : p.pending)
+          {
+            if (e.is_yielded)
+              {
+                // Already published.
+                continue;
+              }
+            if (!e.is_read && !read_members (e.addr, &e))
+              {
+                // The priority is not known, the lowest.
+                lowest = &e;
+                break;
+              }
+            if (lowest == nullptr
+                || e.prio_inherited < lowest->prio_inherited
+                || (e.prio_inherited == lowest->prio_inherited
+                    && e.order > lowest->order))
+              {
+                lowest = &e;
+              }
+          }
+
+        if (lowest != nullptr
+            && (!lowest->is_read
+                || m.prio_inherited > lowest->prio_inherited))
+          {
+            *lowest = m;
+          }
+      }
+
+      /**
+       * @brief Read the members of the next thread found; after
+       * the last one, order the threads, highest priority first.
+       */
+      void
+      members_step (progress_type& p)
+      {
+        if (p.next < p.pending.size ())
+          {
+            members_t& m = p.pending[p.next];
+            if (!m.is_read)
+              {
+                read_members (m.addr, &m);
+              }
+            ++p.next;
+            return;
+          }
+
+        std::sort (p.pending.begin (), p.pending.end (),
+                   [] (const members_t& a, const members_t& b) -> bool
+                     {
+                       unsigned int pa = a.is_read ? a.prio_inherited + 1u : 0;
+                       unsigned int pb = b.is_read ? b.prio_inherited + 1u : 0;
+                       return (pa != pb) ? (pa > pb) : (a.order < b.order);
+                     });
+
+        // The order changed, look again for the IDs not streamed.
+        p.yield_next = 0;
+
+        p.phase = progress_type::phase_t::details;
+        p.next = 0;
+      }
+
+      /**
+       * @brief Read the next thread, highest priority first.
+       */
+      void
+      details_step (progress_type& p)
+      {
+        if (p.next >= p.pending.size ())
+          {
+            p.phase = progress_type::phase_t::idle;
+            return;
+          }
+
+        members_t& m = p.pending[p.next];
+        ++p.next;
+
+        if (!add_thread (m.addr, &m))
+          {
+            // Fixed capacity, the other threads are not shown.
+            p.phase = progress_type::phase_t::idle;
+          }
+      }
+
+      /**
+       * @brief Add a thread to the collection and read it; the
+       * threads whose IDs were streamed are already in the
+       * collection, and are only read.
+       *
+       * @retval false The fixed capacity is exhausted.
+       */
+      bool
+      add_thread (thread_addr_t thread_addr, const members_t* m)
+      {
+        thread_type* th = nullptr;
+        if (m != nullptr && m->is_yielded)
+          {
+            th = find_thread (thread_addr);
+          }
+        if (th == nullptr)
+          {
+            th = threads_.new_thread ();
+            if (th == nullptr)
+              {
+                report_capacity ();
+                return false;
+              }
+
+            // This will also set the ID.
+            th->addr (thread_addr);
+          }
+
+        if (m != nullptr && m->is_read)
+          {
+            apply_members (th, *m);
+          }
+        else
+          {
+            read_thread (th, thread_addr);
+          }
+
+#if defined(DEBUG)
+        printf ("thread @0x%08X '%s' S:%u P:%u(%u) %s\n", thread_addr,
+                th->name, th->state, th->prio_inherited, th->prio_assigned,
+                (th->stack.is_floating_point ? "FP" : ""));
+#endif /* defined(DEBUG) */
+
+        return true;
+      }
+
+      /**
+       * @brief Add a thread with only its address, for a streamed ID;
+       * it is read later, by the budgeted update.
+       *
+       * @retval false The fixed capacity is exhausted.
+       */
+      bool
+      add_placeholder (thread_addr_t thread_addr)
+      {
+        thread_type* th = threads_.new_thread ();
+        if (th == nullptr)
+          {
+            report_capacity ();
+            return false;
+          }
+
+        // This will also set the ID; the stack is not known.
+        th->addr (thread_addr);
+
+        return true;
+      }
+
+      /**
+       * @brief Warn, only once, that the fixed capacity is exhausted.
+       */
+      void
+      report_capacity (void)
+      {
+        if (!is_capacity_reported_)
+          {
+            backend_.output_warning (
+                "Too many threads, only %u are shown.\n",
+                static_cast<unsigned int> (capacity_type::threads_max_count));
+            is_capacity_reported_ = true;
+          }
+      }
+
+      /**
+       * @brief Warn, only once, if a thread at the deepest level
+       * of the explicit stack has children, which are not shown.
+       */
+      void
+      report_depth (thread_addr_t thread_addr)
+      {
+        if (!is_depth_reported_
+            && children_threads_iter_begin (thread_addr)
+                != children_threads_iter_end (thread_addr))
+          {
+            backend_.output_warning (
+                "Threads nested deeper than %u levels are not shown.\n",
+                static_cast<unsigned int> (DRTM_THREADS_DEPTH_MAX_COUNT));
+            is_depth_reported_ = true;
+          }
+      }
+
+      /**
+       * @brief Decide the frame layout, reading only the selector word,
+       * if needed; the registers are read later, when requested.
+       */
+      void
+      decide_frame (thread_type* th)
       {
+        // The selector word (like EXC_RETURN) is read only if
+        // the frame policy has more than one layout; the
+        // condition is known at compile time.
+        uint32_t selector = 0;
+        if (frame_type::has_variable_frames)
+          {
+            int ret;
+            ret = read_long (
+                static_cast<addr_t> (th->stack.addr
+                    + (selector_offset_words ()
+                        * thread_type::register_size_bytes)), &selector);
+            if (ret < 0)
+              {
+                backend_.output_error ("Could not read 'thread.stack_ptr'.\n");
+              }
+
 #if defined(DEBUG)
-        printf ("%s()\n", __func__);
+            printf ("thread EXC_RETURN 0x%08X\n", selector);
 #endif /* defined(DEBUG) */
+          }
 
-        bool ret;
+        th->stack.info = frame_type::frame_info (selector);
+        th->stack.is_floating_point = th->stack.info->is_floating_point;
+      }
 
-        int err;
-        err = backend_.read_byte (metadata_.scheduler.is_started_addr,
-                                  reinterpret_cast<uint8_t*> (&ret));
-        if (err < 0)
+      /**
+       * @brief The offset, in words from SP, of the frame selector;
+       * the value from the DRTM header, if present, overrides
+       * the frame policy default.
+       */
+      inline std::size_t
+      selector_offset_words (void)
+      {
+        if (metadata_.thread.stack_selector_offset_words != 0)
           {
-            backend_.output_error ("Could not read 'is_started'.\n");
-            return false;
+            return metadata_.thread.stack_selector_offset_words;
           }
+        return frame_type::selector_offset_words;
+      }
 
-#if defined(DEBUG)
-        printf ("%s() @0x%08X 0x%02X\n", __func__,
-                metadata_.scheduler.is_started_addr, ret);
-#endif /* defined(DEBUG) */
+      /**
+       * @brief Enable/disable the speculative read of the stack frame.
+       *
+       * @details
+       * When enabled (the default for policies with variable frames),
+       * the largest frame is read during the update, in a single
+       * transaction, and the layout is decided from it. When disabled,
+       * the selector word is read separately and the registers are
+       * read only when requested, which transfers less data for
+       * threads that are never inspected.
+       */
+      inline void
+      speculative_frame_read (bool enabled)
+      {
+        speculative_frame_read_ = enabled;
+      }
 
-        return ret;
+      inline bool
+      speculative_frame_read (void)
+      {
+        return speculative_frame_read_;
       }
 
       /**
-       * @brief Update the local list of threads.
+       * @brief Read the address of the current thread and cache
+       * its details and ID.
+       *
+       * @details
+       * For multi-core targets, the pointers to the threads running
+       * on all cores are read in a single transaction; the thread
+       * running on the first core is the current thread.
        */
       void
-      update_threads (void)
+      update_current_thread (void)
       {
-        threads_.clear ();
-        iterate_threads (0, 0);
+        if (read_running_addrs ())
+          {
+            link_current_threads ();
+          }
+      }
 
-        update_current_thread ();
+      /**
+       * @brief Read the addresses of the threads running on each
+       * core, in a single transaction.
+       *
+       * @retval true The addresses were read.
+       * @retval false The addresses could not be read.
+       */
+      bool
+      read_running_addrs (void)
+      {
+        std::size_t cores = metadata_.scheduler.cores_count;
+        if (cores <= 1 || metadata_.scheduler.current_threads_addr == 0)
+          {
+            thread_addr_t current_thread_addr;
+            int ret;
+            ret = read_long (metadata_.scheduler.current_thread_addr,
+                             &current_thread_addr);
+            if (ret < 0)
+              {
+                backend_.output_error (
+                    "Could not read 'scheduler.current_thread_addr'.\n");
+                return false;
+              }
+
+            current_addrs_[0] = current_thread_addr;
+            cores_count_ = 1;
+            return true;
+          }
+
+        if (cores > DRTM_CORES_MAX_COUNT)
+          {
+            backend_.output_warning ("Only %u of %u cores are supported.\n",
+            DRTM_CORES_MAX_COUNT,
+                                     static_cast<unsigned int> (cores));
+            cores = DRTM_CORES_MAX_COUNT;
+          }
+
+        uint8_t buf[DRTM_CORES_MAX_COUNT * thread_type::register_size_bytes];
+        int ret;
+        ret = read_byte_array (
+            metadata_.scheduler.current_threads_addr, &buf[0],
+            cores * thread_type::register_size_bytes);
+        if (ret < 0)
+          {
+            backend_.output_error (
+                "Could not read 'scheduler.current_threads_addr'.\n");
+            return false;
+          }
+
+        for (std::size_t core = 0; core < cores; ++core)
+          {
+            current_addrs_[core] = backend_.load_long (
+                &buf[core * thread_type::register_size_bytes]);
+          }
+        cores_count_ = cores;
+        return true;
       }
 
       /**
-       * @brief Iterate through the thread children, each with its children.
+       * @brief Find the threads running on each core, from the
+       * addresses read before; the thread running on the first
+       * core is the current thread.
        */
       void
-      iterate_threads (thread_addr_t ta, unsigned int depth)
+      link_current_threads (void)
       {
-#if defined(DEBUG) && defined(DEBUG_LISTS)
-        printf ("%s(0x%08X, %u)\n", __func__, ta, depth);
-#endif /* defined(DEBUG) */
+        threads_.cores_count (cores_count_);
+        for (std::size_t core = 0; core < cores_count_; ++core)
+          {
+            thread_type* th = find_thread (current_addrs_[core]);
 
-        iterator it = children_threads_iter_begin (ta);
-        iterator end = children_threads_iter_end (ta);
+#if defined(DEBUG)
+            printf ("core %zu thread @0x%08X '%s'\n", core,
+                    current_addrs_[core], (th != nullptr) ? th->name : "");
+#endif /* defined(DEBUG) */
 
-        while (it != end)
-          {
-            // Get the pointer to the thread from the iterator.
-            thread_addr_t thread_addr = children_threads_iter_get (it);
+            threads_.current (core, th);
+          }
 
-            thread_type* th = threads_.new_thread ();
+        threads_.current (threads_.current (static_cast<std::size_t> (0)));
+      }
 
-            // Remember the thread address, it is used to determine the
-            // current thread.
-            // This will also set the ID.
-            th->addr (thread_addr);
+      /**
+       * @brief Check, with two transactions, if the snapshot is
+       * still current, for example after a single step.
+       *
+       * @details
+       * The addresses of the running threads and the links of
+       * the top threads list are compared with those seen when the
+       * snapshot was built. Threads added or removed deeper in the
+       * tree, without a context switch, are seen only at the next
+       * full update. If the target provides the thread lists
+       * generation, it is compared instead of the top list, and
+       * all changes are seen; otherwise, if the threads table was
+       * used, the number of its entries and a hash of the entries
+       * already enumerated are compared, so a thread replaced by
+       * another one, with the same count, is also seen; this needs
+       * one more transaction for each chunk of the table.
+       *
+       * @retval true Nothing changed.
+       * @retval false Changed, or could not be checked.
+       */
+      bool
+      is_unchanged (void)
+      {
+        int ret;
 
-            // Get the address of the name string.
-            int ret;
-            addr_t name_addr = 0;
-            ret = backend_.read_long (
-                thread_addr + metadata_.thread.name_offset, &name_addr);
+        // The running threads; a context switch needs a full update.
+        std::size_t cores = threads_.cores_count ();
+        if (cores > 1)
+          {
+            uint8_t buf[DRTM_CORES_MAX_COUNT * thread_type::register_size_bytes];
+            ret = read_byte_array (
+                metadata_.scheduler.current_threads_addr, &buf[0],
+                cores * thread_type::register_size_bytes);
             if (ret < 0)
               {
-                backend_.output_error ("Could not read 'thread.name*'.\n");
+                return false;
               }
 
-            addr_t addr;
-            uint8_t b = 0;
-
-            // Copy the name, byte by byte. A large array copy is risky, since the
-            // thread might be allocated right at the end of RAM, and
-            // the copy might try to access past the limit.
-            if (name_addr != 0)
+            for (std::size_t core = 0; core < cores; ++core)
               {
-                addr = name_addr;
-                char* p = &th->name[0];
-                std::size_t count = 0;
-                while (count < thread_type::name_max_size_bytes - 1)
+                if (backend_.load_long (
+                    &buf[core * thread_type::register_size_bytes])
+                    != current_addrs_[core])
                   {
-                    ret = backend_.read_byte (addr, &b);
-                    if (ret < 0)
-                      {
-                        backend_.output_error (
-                            "Could not read 'thread.name'.\n");
-                        break;
-                      }
-                    *p = static_cast<char> (b);
-                    ++p;
-                    ++addr;
-                    ++count;
-                    if (b == '\0')
-                      {
-                        break;
-                      }
+                    return false;
                   }
-                *p = '\0'; // Be sure the string is terminated.
               }
-
-            addr = thread_addr + metadata_.thread.prio_assigned_offset;
-            ret = backend_.read_byte (addr, &b);
-            if (ret < 0)
+          }
+        else
+          {
+            thread_addr_t current_thread_addr;
+            ret = read_long (metadata_.scheduler.current_thread_addr,
+                             &current_thread_addr);
+            if (ret < 0 || current_thread_addr != current_addrs_[0])
               {
-                backend_.output_error (
-                    "Could not read 'thread.prio_assigned'.\n");
+                return false;
               }
-            th->prio_assigned = b;
+          }
 
-            addr = thread_addr + metadata_.thread.prio_inherited_offset;
-            ret = backend_.read_byte (addr, &b);
-            if (ret < 0)
-              {
-                backend_.output_error (
-                    "Could not read 'thread.prio_inherited'.\n");
-              }
-            th->prio_inherited = b;
+        if (is_generation_known_)
+          {
+            uint32_t generation;
+            return (read_threads_generation (&generation)
+                && generation == threads_generation_);
+          }
 
-            addr = thread_addr + metadata_.thread.state_offset;
-            ret = backend_.read_byte (addr, &b);
-            if (ret < 0)
-              {
-                backend_.output_error ("Could not read 'thread.state'.\n");
-              }
-            th->state = b;
+        return is_enumeration_unchanged ();
+      }
 
-            addr = thread_addr + metadata_.thread.stack_offset;
-            ret = backend_.read_byte_array (addr, &th->stack.sp_addr[0],
-                                            thread_type::register_size_bytes);
-            if (ret < 0)
+      /**
+       * @brief Check, before reusing the tree for an unchanged
+       * generation, that it still matches the target.
+       *
+       * @details
+       * The generation counter is in the target RAM, and restarts
+       * after a reset; it may reach the same value with other
+       * threads. The threads running on each core must be in the
+       * tree, and the top list links, or the threads table, must be
+       * unchanged. The running threads are read again, for the
+       * update.
+       *
+       * @retval true The tree can be reused.
+       * @retval false Changed, or could not be checked.
+       */
+      bool
+      is_tree_valid (void)
+      {
+        if (!read_running_addrs ())
+          {
+            return false;
+          }
+
+        for (std::size_t core = 0; core < cores_count_; ++core)
+          {
+            if (current_addrs_[core] != 0
+                && find_thread (current_addrs_[core]) == nullptr)
               {
-                backend_.output_error ("Could not read 'thread.stack_ptr'.\n");
+#if defined(DEBUG)
+                printf ("%s() running thread @0x%08X not known\n", __func__,
+                        current_addrs_[core]);
+#endif /* defined(DEBUG) */
+                return false;
               }
+          }
 
-            th->stack.addr = backend_.load_long (&th->stack.sp_addr[0]);
+        return is_enumeration_unchanged ();
+      }
 
-            uint32_t exc_return = 0;
-            ret = backend_.read_long (
-                static_cast<addr_t> (th->stack.addr
-                    + (metadata_.thread.stack_exc_offset_words
-                        * thread_type::register_size_bytes)),
-                &exc_return);
-            if (ret < 0)
+      /**
+       * @brief Compare the number of entries and the hash of the
+       * threads table, if used, or the links of the top threads
+       * list, with those seen when the threads were enumerated.
+       *
+       * @retval true Nothing changed.
+       * @retval false Changed, or could not be checked.
+       */
+      bool
+      is_enumeration_unchanged (void)
+      {
+        int ret;
+
+        if (is_table_used_)
+          {
+            uint32_t count;
+            ret = read_long (metadata_.scheduler.threads_count_addr,
+                             &count);
+            if (ret < 0 || count != threads_table_count_)
               {
-                backend_.output_error ("Could not read 'thread.stack_ptr'.\n");
+                return false;
               }
 
-#if defined(DEBUG)
-            printf ("thread EXC_RETURN 0x%08X\n", exc_return);
-#endif /* defined(DEBUG) */
+            uint32_t hash;
+            return (read_threads_table_hash (threads_table_hashed_count_,
+                                             &hash)
+                && hash == threads_table_hash_);
+          }
 
-            if (((exc_return & 0xFFFFFFE3) == 0xFFFFFFE1)
-                && ((exc_return & 0x10) == 0))
-              {
-                th->stack.info = &cortex_m4_vfp_stack_info;
-                th->stack.is_floating_point = true;
-              }
-            else
+        iterator prev;
+        iterator next;
+        return (read_top_list_links (&prev, &next) && prev == top_list_prev_
+            && next == top_list_next_);
+      }
+
+      /**
+       * @brief Read the first entries of the threads table, in
+       * chunks, and hash them.
+       *
+       * @retval true The entries were read.
+       * @retval false The entries could not be read.
+       */
+      bool
+      read_threads_table_hash (uint32_t count, uint32_t* hash)
+      {
+        constexpr std::size_t rsb = thread_type::register_size_bytes;
+
+        uint8_t buf[DRTM_THREADS_TABLE_CHUNK_COUNT * rsb];
+        *hash = table_hash_basis;
+        for (std::size_t i = 0; i < count; i += DRTM_THREADS_TABLE_CHUNK_COUNT)
+          {
+            std::size_t n = std::min<std::size_t> (
+                count - i, DRTM_THREADS_TABLE_CHUNK_COUNT);
+            int ret;
+            ret = read_byte_array (
+                static_cast<addr_t> (metadata_.scheduler.threads_table_addr
+                    + i * rsb),
+                &buf[0], n * rsb);
+            if (ret < 0)
               {
-                th->stack.info = &cortex_m4_stack_info;
-                th->stack.is_floating_point = false;
+                return false;
               }
+            *hash = hash_table_entries (*hash, &buf[0], n * rsb);
+          }
 
-#if defined(DEBUG)
-            printf ("thread @0x%08X '%s' S:%u P:%u(%u) %s\n", thread_addr,
-                    th->name, th->state, th->prio_inherited, th->prio_assigned,
-                    (th->stack.is_floating_point ? "FP" : ""));
-#endif /* defined(DEBUG) */
-
-            // Go down one level.
-            iterate_threads (thread_addr, depth + 1);
+        return true;
+      }
 
-            // Increment the iterator to the next element in the list.
-            it = children_threads_iter_next (it);
+      /**
+       * @brief Continue the FNV-1a hash of the threads table with
+       * the bytes of a chunk.
+       */
+      static uint32_t
+      hash_table_entries (uint32_t hash, const uint8_t* buf, std::size_t size)
+      {
+        for (std::size_t i = 0; i < size; ++i)
+          {
+            hash ^= buf[i];
+            hash *= 16777619u;
           }
+        return hash;
       }
 
       /**
-       * @brief Read the address of the current thread and cache
-       * its details and ID.
+       * @brief Read both links of the top list node, in a single
+       * transaction.
        */
-      void
-      update_current_thread (void)
+      bool
+      read_top_list_links (iterator* prev, iterator* next)
       {
-        thread_addr_t current_thread_addr;
+        std::size_t prev_offset = metadata_.list_links.prev_offset;
+        std::size_t next_offset = metadata_.list_links.next_offset;
+        std::size_t first = std::min (prev_offset, next_offset);
+        std::size_t size = std::max (prev_offset, next_offset) - first
+            + thread_type::register_size_bytes;
+
+        uint8_t node[4 * thread_type::register_size_bytes];
+        if (size > sizeof(node))
+          {
+            return false;
+          }
+
         int ret;
-        ret = backend_.read_long (metadata_.scheduler.current_thread_addr,
-                                  &current_thread_addr);
+        ret = read_byte_array (
+            static_cast<addr_t> (metadata_.scheduler.top_threads_list_addr
+                + first),
+            &node[0], size);
         if (ret < 0)
           {
-            backend_.output_error (
-                "Could not read 'scheduler.current_thread_addr'.\n");
-            return;
+            return false;
           }
 
-        thread_type* current_th = nullptr;
+        *prev = backend_.load_long (&node[prev_offset - first]);
+        *next = backend_.load_long (&node[next_offset - first]);
+        return true;
+      }
 
+      /**
+       * @brief Find a thread by its target address.
+       */
+      thread_type*
+      find_thread (thread_addr_t addr)
+      {
         for (auto* th : threads_)
           {
-            if (th->addr () == current_thread_addr)
+            if (th->addr () == addr)
               {
-                current_th = th;
-                break;
+                return th;
               }
           }
-
-#if defined(DEBUG)
-        if (current_th != nullptr)
-          {
-            printf ("current thread @0x%08X '%s'\n", current_thread_addr,
-                    current_th->name);
-          }
-        else
-          {
-            printf ("current thread @0x%08X\n", current_thread_addr);
-          }
-#endif /* defined(DEBUG) */
-
-        threads_.current (current_th);
+        return nullptr;
       }
 
     private:
@@ -383,7 +1883,7 @@ namespace drtm
         list_node_addr_t list_node_addr = children_threads_get_list (ta);
         iterator it = 0;
         int ret;
-        ret = backend_.read_long (
+        ret = read_long (
             list_node_addr + metadata_.list_links.next_offset, &it);
         if (ret < 0)
           {
@@ -470,7 +1970,7 @@ namespace drtm
 
         iterator next = 0;
         int ret;
-        ret = backend_.read_long (it + metadata_.list_links.next_offset, &next);
+        ret = read_long (it + metadata_.list_links.next_offset, &next);
         if (ret < 0)
           {
             backend_.output_error (
@@ -484,6 +1984,63 @@ namespace drtm
         return next;
       }
 
+    public:
+
+      /**
+       * @brief Set the lock taken for each target transaction,
+       * shared with the lazy reads of the published snapshot.
+       */
+      inline void
+      transactions_lock (spin_lock* lock)
+      {
+        transactions_lock_ = lock;
+      }
+
+      /**
+       * @brief Get the number of target transactions issued so far.
+       */
+      inline uint32_t
+      transactions_count (void)
+      {
+        return transactions_count_;
+      }
+
+    private:
+
+      // ----------------------------------------------------------------------
+      // The target reads, counted for the update budget, and
+      // serialised, one at a time, with the lazy reads.
+
+      inline int
+      read_byte_array (addr_t addr, uint8_t* out, std::size_t size)
+      {
+        ++transactions_count_;
+        spin_lock_guard guard
+          { transactions_lock_ };
+
+        return backend_.read_byte_array (addr, out, size);
+      }
+
+      inline int
+      read_byte (addr_t addr, uint8_t* out)
+      {
+        ++transactions_count_;
+        spin_lock_guard guard
+          { transactions_lock_ };
+
+        return backend_.read_byte (addr, out);
+      }
+
+      inline int
+      read_long (addr_t addr, uint32_t* out)
+      {
+        ++transactions_count_;
+        spin_lock_guard guard
+          { transactions_lock_ };
+
+        return backend_.read_long (addr, out);
+      }
+
     private:
 
       backend_type& backend_;
@@ -492,311 +2049,44 @@ namespace drtm
 
       allocator_type& allocator_;
 
-    public:
+      bool speculative_frame_read_ = frame_type::has_variable_frames;
 
-      static const register_offset_t cortex_m4_stack_offsets[];
-      static const stack_info_t cortex_m4_stack_info;
-      static const register_offset_t cortex_m4_vfp_stack_offsets[];
-      static const stack_info_t cortex_m4_vfp_stack_info;
-    };
+      bool is_capacity_reported_ = false;
+      bool is_depth_reported_ = false;
 
-  // ---------------------------------------------------------------------------
-  // Local data structures.
-
-  // Non FP stack context, 17 words.
-  // Offsets in words, from SP up.
-
-  // Saved always by ARM.
-  // (17 optional padding/aligner)
-  // 16 xPSR (xPSR bit 9 = 1 if padded)
-  // 15 return address (PC, R15)
-  // 14 LR (R14)
-  // 13 R12
-  // 12 R3
-  // 11 R2
-  // 10 R1
-  //  9 R0
-
-  // Saved always by context switch handler.
-  // "stmdb %[r]!, {r4-r9,sl,fp,lr}"
-  //  8 EXC_RETURN (R14)
-  //  7 FP (R11)
-  //  6 SL (R10)
-  //  5 R9
-  //  4 R8
-  //  3 R7
-  //  2 R6
-  //  1 R5
-  //  0 R4 <-- new SP value
-
-  /*
-   <!DOCTYPE feature SYSTEM "gdb-target.dtd">
-   <target version="1.0">
-   <architecture>arm</architecture>
-   <feature name="org.gnu.gdb.arm.m-profile">
-   <reg name="r0" bitsize="32" regnum="0" type="uint32" group="general"/>
-   <reg name="r1" bitsize="32" regnum="1" type="uint32" group="general"/>
-   <reg name="r2" bitsize="32" regnum="2" type="uint32" group="general"/>
-   <reg name="r3" bitsize="32" regnum="3" type="uint32" group="general"/>
-   <reg name="r4" bitsize="32" regnum="4" type="uint32" group="general"/>
-   <reg name="r5" bitsize="32" regnum="5" type="uint32" group="general"/>
-   <reg name="r6" bitsize="32" regnum="6" type="uint32" group="general"/>
-   <reg name="r7" bitsize="32" regnum="7" type="uint32" group="general"/>
-   <reg name="r8" bitsize="32" regnum="8" type="uint32" group="general"/>
-   <reg name="r9" bitsize="32" regnum="9" type="uint32" group="general"/>
-   <reg name="r10" bitsize="32" regnum="10" type="uint32" group="general"/>
-   <reg name="r11" bitsize="32" regnum="11" type="uint32" group="general"/>
-   <reg name="r12" bitsize="32" regnum="12" type="uint32" group="general"/>
-   <reg name="sp" bitsize="32" regnum="13" type="data_ptr" group="general"/>
-   <reg name="lr" bitsize="32" regnum="14" type="uint32" group="general"/>
-   <reg name="pc" bitsize="32" regnum="15" type="code_ptr" group="general"/>
-   <reg name="xpsr" bitsize="32" regnum="25" type="uint32" group="general"/>
-   </feature>
-   <feature name="org.gnu.gdb.arm.m-system">
-   <reg name="msp" bitsize="32" regnum="26" type="uint32" group="general"/>
-   <reg name="psp" bitsize="32" regnum="27" type="uint32" group="general"/>
-   <reg name="primask" bitsize="32" regnum="28" type="uint32" group="general"/>
-   <reg name="basepri" bitsize="32" regnum="29" type="uint32" group="general"/>
-   <reg name="faultmask" bitsize="32" regnum="30" type="uint32" group="general"/>
-   <reg name="control" bitsize="32" regnum="31" type="uint32" group="general"/>
-   </feature>
-   </target>
-   */
+      // The raw addresses of the running threads, and the links of
+      // the top list, as seen by the last update.
+      thread_addr_t current_addrs_[DRTM_CORES_MAX_COUNT] =
+        { 0 };
+      std::size_t cores_count_ = 1;
+      iterator top_list_prev_ = 0;
+      iterator top_list_next_ = 0;
 
-  // This table encodes the offsets in the µOS++ non-VFP stack frame for the
-  // registers defined in the previous XML.
-  // Offsets are from the saved SP to each register, in 32-bits words.
-  //
-  // Special cases:
-  // -1 return as 0x00000000
-  // -2 SP should be taken from TCB, not from the context.
-  template<typename B, typename A>
-    const register_offset_t run_time_data<B, A>::cortex_m4_stack_offsets[] =
-      {
-      //
-          9,// R0
-          10, // R1
-          11, // R2
-          12, // R3
-          0, // R4
-          1, // R5
-          2, // R6
-          3, // R7
-          4, // R8
-          5, // R9
-          6, // R10
-          7, // R11
-          13, // R12
-          -2, // SP
-          14, // LR
-          15, // PC
-          16, // XPSR
-
-          -1, // MSP
-          -1, // PSP
-          -1, // PRIMASK
-          -1, // BASEPRI
-          -1, // FAULTMASK
-          -1, // CONTROL
-        };
+      // The thread lists generation when the threads were collected,
+      // and the metadata used to collect them.
+      bool is_generation_known_ = false;
+      uint32_t threads_generation_ = 0;
+      uint32_t metadata_generation_ = 0;
 
-  template<typename B, typename A>
-    const stack_info_t run_time_data<B, A>::cortex_m4_stack_info =
-      {
-      //
-          .in_registers = 16 + 1 + 1, // R0-R15 + EXC_RETURN, +XPSR
-          .out_registers = 16 + 1, // R0-R15 + xPSR
-          .offsets = cortex_m4_stack_offsets, //
-          .offsets_size = sizeof(cortex_m4_stack_offsets)
-              / sizeof(cortex_m4_stack_offsets[0]),
-      /**/
-      };
+      // The last consistent read could not read the sequence counter.
+      bool is_sequence_read_failed_ = false;
 
-  // FP stack context, 50 words.
-  // Offsets in words, from SP up.
-
-  // Saved always by ARM.
-  // (50 optional padding/aligner)
-  // 49 FPSCR
-  // 48 S15
-  // ...
-  // 34 S1
-  // 33 S0
-  // 32 xPSR (xPSR bit 9 = 1 if padded)
-  // 31 return address (PC, R15)
-  // 30 LR (R14)
-  // 29 R12
-  // 28 R3
-  // 27 R2
-  // 26 R1
-  // 25 R0
-
-  // Saved conditionally if EXC_RETURN, bit 4 is 0 (zero).
-  // "vldmiaeq %[r]!, {s16-s31}"
-  // 24 S31
-  // 23 S30
-  // ...
-  // 10 S17
-  //  9 S16
-
-  // Saved always by context switch handler.
-  // "stmdb %[r]!, {r4-r9,sl,fp,lr}"
-  //  8 EXC_RETURN (R14)
-  //  7 FP (R11)
-  //  6 SL (R10)
-  //  5 R9
-  //  4 R8
-  //  3 R7
-  //  2 R6
-  //  1 R5
-  //  0 R4 <-- new SP value
-
-  /*
-   <!DOCTYPE feature SYSTEM "gdb-target.dtd">
-   <target version="1.0">
-   <architecture>arm</architecture>
-   <feature name="org.gnu.gdb.arm.m-profile">
-   <reg name="r0" bitsize="32" regnum="0" type="uint32" group="general"/>
-   <reg name="r1" bitsize="32" regnum="1" type="uint32" group="general"/>
-   <reg name="r2" bitsize="32" regnum="2" type="uint32" group="general"/>
-   <reg name="r3" bitsize="32" regnum="3" type="uint32" group="general"/>
-   <reg name="r4" bitsize="32" regnum="4" type="uint32" group="general"/>
-   <reg name="r5" bitsize="32" regnum="5" type="uint32" group="general"/>
-   <reg name="r6" bitsize="32" regnum="6" type="uint32" group="general"/>
-   <reg name="r7" bitsize="32" regnum="7" type="uint32" group="general"/>
-   <reg name="r8" bitsize="32" regnum="8" type="uint32" group="general"/>
-   <reg name="r9" bitsize="32" regnum="9" type="uint32" group="general"/>
-   <reg name="r10" bitsize="32" regnum="10" type="uint32" group="general"/>
-   <reg name="r11" bitsize="32" regnum="11" type="uint32" group="general"/>
-   <reg name="r12" bitsize="32" regnum="12" type="uint32" group="general"/>
-   <reg name="sp" bitsize="32" regnum="13" type="data_ptr" group="general"/>
-   <reg name="lr" bitsize="32" regnum="14" type="uint32" group="general"/>
-   <reg name="pc" bitsize="32" regnum="15" type="code_ptr" group="general"/>
-   <reg name="xpsr" bitsize="32" regnum="25" type="uint32" group="general"/>
-   </feature>
-   <feature name="org.gnu.gdb.arm.m-system">
-   <reg name="msp" bitsize="32" regnum="26" type="uint32" group="general"/>
-   <reg name="psp" bitsize="32" regnum="27" type="uint32" group="general"/>
-   <reg name="primask" bitsize="32" regnum="28" type="uint32" group="general"/>
-   <reg name="basepri" bitsize="32" regnum="29" type="uint32" group="general"/>
-   <reg name="faultmask" bitsize="32" regnum="30" type="uint32" group="general"/>
-   <reg name="control" bitsize="32" regnum="31" type="uint32" group="general"/>
-   </feature>
-   <feature name="org.gnu.gdb.arm.m-float">
-   <reg name="fpscr" bitsize="32" regnum="32" type="uint32" group="float"/>
-   <reg name="s0" bitsize="32" regnum="33" type="float" group="float"/>
-   <reg name="s1" bitsize="32" regnum="34" type="float" group="float"/>
-   <reg name="s2" bitsize="32" regnum="35" type="float" group="float"/>
-   <reg name="s3" bitsize="32" regnum="36" type="float" group="float"/>
-   <reg name="s4" bitsize="32" regnum="37" type="float" group="float"/>
-   <reg name="s5" bitsize="32" regnum="38" type="float" group="float"/>
-   <reg name="s6" bitsize="32" regnum="39" type="float" group="float"/>
-   <reg name="s7" bitsize="32" regnum="40" type="float" group="float"/>
-   <reg name="s8" bitsize="32" regnum="41" type="float" group="float"/>
-   <reg name="s9" bitsize="32" regnum="42" type="float" group="float"/>
-   <reg name="s10" bitsize="32" regnum="43" type="float" group="float"/>
-   <reg name="s11" bitsize="32" regnum="44" type="float" group="float"/>
-   <reg name="s12" bitsize="32" regnum="45" type="float" group="float"/>
-   <reg name="s13" bitsize="32" regnum="46" type="float" group="float"/>
-   <reg name="s14" bitsize="32" regnum="47" type="float" group="float"/>
-   <reg name="s15" bitsize="32" regnum="48" type="float" group="float"/>
-   <reg name="s16" bitsize="32" regnum="49" type="float" group="float"/>
-   <reg name="s17" bitsize="32" regnum="50" type="float" group="float"/>
-   <reg name="s18" bitsize="32" regnum="51" type="float" group="float"/>
-   <reg name="s19" bitsize="32" regnum="52" type="float" group="float"/>
-   <reg name="s20" bitsize="32" regnum="53" type="float" group="float"/>
-   <reg name="s21" bitsize="32" regnum="54" type="float" group="float"/>
-   <reg name="s22" bitsize="32" regnum="55" type="float" group="float"/>
-   <reg name="s23" bitsize="32" regnum="56" type="float" group="float"/>
-   <reg name="s24" bitsize="32" regnum="57" type="float" group="float"/>
-   <reg name="s25" bitsize="32" regnum="58" type="float" group="float"/>
-   <reg name="s26" bitsize="32" regnum="59" type="float" group="float"/>
-   <reg name="s27" bitsize="32" regnum="60" type="float" group="float"/>
-   <reg name="s28" bitsize="32" regnum="61" type="float" group="float"/>
-   <reg name="s29" bitsize="32" regnum="62" type="float" group="float"/>
-   <reg name="s30" bitsize="32" regnum="63" type="float" group="float"/>
-   <reg name="s31" bitsize="32" regnum="64" type="float" group="float"/>
-   </feature>
-   </target>
-   */
+      // The threads were enumerated from the threads table; the
+      // hash of the first entries read, to see threads replaced.
+      bool is_table_used_ = false;
+      uint32_t threads_table_count_ = 0;
+      uint32_t threads_table_hashed_count_ = 0;
+      uint32_t threads_table_hash_ = table_hash_basis;
 
-  // This table encodes the offsets in the µOS++ VFP stack frame for the
-  // registers defined in the previous XML.
-  // Used conditionally if EXC_RETURN, bit 4 is 0 (zero).
-  template<typename B, typename A>
-    const register_offset_t run_time_data<B, A>::cortex_m4_vfp_stack_offsets[] =
-      {
-      //
-          25,//R0
-          26, // R1
-          27, // R2
-          28, // R3
-          0, // R4
-          1, // R5
-          2, // R6
-          3, // R7
-          4, // R8
-          5, // R9
-          6, // R10
-          7, // R11
-          29, // R12
-          -2, // SP
-          30, // LR
-          31, // PC
-          32, // XPSR
-
-          -1, // MSP
-          -1, // PSP
-          -1, // PRIMASK
-          -1, // BASEPRI
-          -1, // FAULTMASK
-          -1, // CONTROL
-          49, // FPSCR
-          33, // S0
-          34, // S1
-          35, // S2
-          36, // S3
-          37, // S4
-          38, // S5
-          39, // S6
-          40, // S7
-          41, // S8
-          42, // S9
-          43, // S10
-          44, // S11
-          45, // S12
-          46, // S13
-          47, // S14
-          48, // S15
-          9, // S16
-          10, // S17
-          11, // S18
-          12, // S19
-          13, // S20
-          14, // S21
-          15, // S22
-          16, // S23
-          17, // S24
-          18, // S25
-          19, // S26
-          20, // S27
-          21, // S28
-          22, // S29
-          23, // S30
-          24, // S31
-        };
+      uint32_t transactions_count_ = 0;
 
-  template<typename B, typename A>
-    const stack_info_t run_time_data<B, A>::cortex_m4_vfp_stack_info =
-      {
-      //
-          .in_registers = 16 + 1 + 1 + 32 + 1, // R0-R15 + EXC_RETURN +XPSR + S0-S31 + FPSCR
-          .out_registers = 16 + 1, // R0-R15 + xPSR
-          .offsets = cortex_m4_vfp_stack_offsets, //
-          .offsets_size = sizeof(cortex_m4_vfp_stack_offsets)
-              / sizeof(cortex_m4_vfp_stack_offsets[0]),
-      /**/
-      };
+      // Taken for each target transaction; nullptr if not shared.
+      spin_lock* transactions_lock_ = nullptr;
+
+    };
+
+  template<typename B, typename A, typename F, typename M>
+    constexpr uint32_t run_time_data<B, A, F, M>::table_hash_basis;
 
 // ---------------------------------------------------------------------------
 } /* namespace drtm */
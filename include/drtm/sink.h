@@ -0,0 +1,218 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef DRTM_SINK_H_
+#define DRTM_SINK_H_
+
+#if defined(__cplusplus)
+
+#include <cstdint>
+#include <cstddef>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief A bounded character sink, writing via an output iterator.
+   *
+   * @details
+   * The sink allows the GDB server to pass its own packet buffer
+   * (or any output iterator, like one computing the packet checksum),
+   * so replies are built in place, without intermediate copies.
+   *
+   * Characters are stored only while there is space, but the
+   * accounting continues past the capacity, so after a truncated
+   * output `required()` tells the exact size needed.
+   *
+   * No terminator is added; the caller decides if one is needed.
+   *
+   * @tparam O Type of the output iterator.
+   */
+  template<typename O = char*>
+    class sink
+    {
+    public:
+
+      using iterator_type = O;
+
+    public:
+
+      /**
+       * @brief Construct a sink over an output range.
+       *
+       * @param [in] out The output iterator.
+       * @param [in] capacity The max number of characters to store.
+       */
+      sink (iterator_type out, std::size_t capacity) :
+          out_ (out), // Parenthesis used to compile with 4.8
+          capacity_ (capacity)
+      {
+        ;
+      }
+
+      sink (const sink&) = default;
+      sink&
+      operator= (const sink&) = default;
+
+      ~sink () = default;
+
+    public:
+
+      /**
+       * @brief Store a single character.
+       */
+      inline void
+      put (char c)
+      {
+        if (length_ < capacity_)
+          {
+            *out_ = c;
+            ++out_;
+            ++length_;
+          }
+        ++required_;
+      }
+
+      /**
+       * @brief Store an array of characters.
+       */
+      void
+      write (const char* s, std::size_t n)
+      {
+        for (std::size_t i = 0; i < n; ++i)
+          {
+            put (s[i]);
+          }
+      }
+
+      /**
+       * @brief Store a null terminated string, without the terminator.
+       */
+      void
+      write (const char* s)
+      {
+        for (; *s != '\0'; ++s)
+          {
+            put (*s);
+          }
+      }
+
+      /**
+       * @brief Store an unsigned value, in decimal.
+       */
+      void
+      write_unsigned (unsigned int value)
+      {
+        char buf[3 * sizeof(value) + 1];
+        std::size_t n = 0;
+        do
+          {
+            buf[n++] = static_cast<char> ('0' + (value % 10));
+            value /= 10;
+          }
+        while (value != 0);
+
+        while (n > 0)
+          {
+            put (buf[--n]);
+          }
+      }
+
+      /**
+       * @brief Store a byte as two upper case hex digits.
+       */
+      inline void
+      write_hex_byte (uint8_t b)
+      {
+        put (hex_digit (static_cast<uint8_t> (b >> 4)));
+        put (hex_digit (static_cast<uint8_t> (b & 0xF)));
+      }
+
+      /**
+       * @brief Get the number of characters actually stored.
+       */
+      inline std::size_t
+      length (void) const
+      {
+        return length_;
+      }
+
+      /**
+       * @brief Get the number of characters that would have been
+       * stored if the capacity were large enough.
+       */
+      inline std::size_t
+      required (void) const
+      {
+        return required_;
+      }
+
+      /**
+       * @brief Tell if some characters were dropped.
+       */
+      inline bool
+      overflow (void) const
+      {
+        return required_ > length_;
+      }
+
+      /**
+       * @brief Get the position after the last stored character.
+       */
+      inline iterator_type
+      position (void) const
+      {
+        return out_;
+      }
+
+    private:
+
+      static inline char
+      hex_digit (uint8_t n)
+      {
+        return static_cast<char> (n < 10 ? '0' + n : 'A' + n - 10);
+      }
+
+      iterator_type out_;
+      std::size_t capacity_;
+
+      std::size_t length_ = 0;
+      std::size_t required_ = 0;
+    };
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_SINK_H_ */
@@ -0,0 +1,273 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_SNAPSHOT_H_
+#define DRTM_SNAPSHOT_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+#include <drtm/frames.h>
+#include <drtm/metadata.h>
+#include <drtm/threads.h>
+#include <drtm/run-time-data.h>
+#include <drtm/spin-lock.h>
+
+#include <atomic>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief A class template to manage the two thread snapshots,
+   * one published for the readers and one built by the next update.
+   *
+   * @details
+   * Readers pin the published snapshot, without locks; the update
+   * waits until the readers left the other snapshot, rebuilds it,
+   * then publishes it atomically. Only one host thread at a time
+   * may update.
+   *
+   * @tparam F The stack frame layout policy, from `frames.h`.
+   * @tparam M The metadata type.
+   */
+  template<typename B, typename A, typename F = default_frame_type,
+      typename M = metadata<B>>
+    class snapshots
+    {
+    public:
+
+      using backend_type = B;
+      using allocator_type = A;
+      using frame_type = F;
+
+      using metadata_type = M;
+      using threads_type = class threads<B, A, F>;
+      using rtd_type = class run_time_data<B, A, F, M>;
+
+      /**
+       * @brief The threads, as seen at one update.
+       */
+      struct snapshot_s
+      {
+        snapshot_s (backend_type& backend, metadata_type& metadata,
+                    allocator_type& allocator) :
+            threads
+              { backend, allocator }, //
+            rt
+              { backend, metadata, threads, allocator }
+        {
+        }
+
+        threads_type threads;
+        rtd_type rt;
+
+        bool is_scheduler_started = false;
+
+        // False if a budgeted update stopped before reading all threads.
+        bool is_complete = true;
+
+        // The number of readers using this snapshot.
+        std::atomic<unsigned int> pins
+          { 0 };
+      };
+
+      using snapshot_type = struct snapshot_s;
+
+      /**
+       * @brief Pin the published snapshot for the duration of a scope.
+       */
+      class reader
+      {
+      public:
+
+        reader (snapshots& s) :
+            snapshot_ (s.pin ()) // Parenthesis used to compile with 4.8
+        {
+        }
+
+        // The rule of five.
+        reader (const reader&) = delete;
+        reader (reader&&) = delete;
+        reader&
+        operator= (const reader&) = delete;
+        reader&
+        operator= (reader&&) = delete;
+
+        ~reader ()
+        {
+          snapshot_->pins.fetch_sub (1);
+        }
+
+        inline snapshot_type*
+        operator-> (void)
+        {
+          return snapshot_;
+        }
+
+      private:
+
+        snapshot_type* snapshot_;
+      };
+
+    public:
+
+      snapshots (backend_type& backend, metadata_type& metadata,
+                 allocator_type& allocator) :
+          snapshots_
+            {
+              { backend, metadata, allocator },
+              { backend, metadata, allocator } }
+      {
+#if defined(DEBUG)
+        printf ("%s(%p, %p, %p) @%p\n", __func__, &backend, &metadata,
+                &allocator, this);
+#endif /* defined(DEBUG) */
+
+        snapshots_[0].rt.transactions_lock (&lock_);
+        snapshots_[1].rt.transactions_lock (&lock_);
+      }
+
+      // The rule of five.
+      snapshots (const snapshots&) = delete;
+      snapshots (snapshots&&) = delete;
+      snapshots&
+      operator= (const snapshots&) = delete;
+      snapshots&
+      operator= (snapshots&&) = delete;
+
+      ~snapshots () = default;
+
+    public:
+
+      /**
+       * @brief Pin the published snapshot.
+       *
+       * @details
+       * The pin is valid only if the snapshot is still published
+       * after the counter was incremented; otherwise an update may
+       * already be rebuilding it, so try again.
+       */
+      snapshot_type*
+      pin (void)
+      {
+        for (;;)
+          {
+            snapshot_type* s = published_.load ();
+            s->pins.fetch_add (1);
+            if (published_.load () == s)
+              {
+                return s;
+              }
+            s->pins.fetch_sub (1);
+          }
+      }
+
+      /**
+       * @brief Get the snapshot to be rebuilt by the update.
+       *
+       * @details
+       * Wait until the readers that pinned it, while it was
+       * published, are done with it.
+       */
+      snapshot_type*
+      back (void)
+      {
+        snapshot_type* s =
+            (published_.load () == &snapshots_[0]) ?
+                &snapshots_[1] : &snapshots_[0];
+        while (s->pins.load () != 0)
+          {
+            DRTM_SPIN_PAUSE();
+          }
+        return s;
+      }
+
+      /**
+       * @brief Get the published snapshot, without pinning it; only
+       * for the updating host thread, which is the only one that
+       * may change it.
+       */
+      inline snapshot_type*
+      published (void)
+      {
+        return published_.load ();
+      }
+
+      /**
+       * @brief Make the rebuilt snapshot visible to the readers.
+       */
+      inline void
+      publish (snapshot_type* s)
+      {
+        published_.store (s);
+      }
+
+      /**
+       * @brief The lock for changes of a published snapshot, like
+       * the lazy register reads, and for the target transactions;
+       * the updates take it for each transaction, not for the
+       * whole update.
+       */
+      inline spin_lock&
+      lock (void)
+      {
+        return lock_;
+      }
+
+      /**
+       * @brief Enable/disable the speculative frame read in both
+       * snapshots.
+       */
+      void
+      speculative_frame_read (bool enabled)
+      {
+        snapshots_[0].rt.speculative_frame_read (enabled);
+        snapshots_[1].rt.speculative_frame_read (enabled);
+      }
+
+    private:
+
+      snapshot_type snapshots_[2];
+
+      std::atomic<snapshot_type*> published_
+        { &snapshots_[0] };
+
+      spin_lock lock_;
+    };
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_SNAPSHOT_H_ */
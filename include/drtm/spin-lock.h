@@ -0,0 +1,146 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_SPIN_LOCK_H_
+#define DRTM_SPIN_LOCK_H_
+
+#if defined(__cplusplus)
+
+#include <atomic>
+
+// Called in each iteration of the busy waits; may be redefined,
+// for example to yield to the host scheduler.
+#if !defined(DRTM_SPIN_PAUSE)
+#if defined(__i386__) || defined(__x86_64__)
+#define DRTM_SPIN_PAUSE()   __builtin_ia32_pause ()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && (__ARM_ARCH >= 7))
+#define DRTM_SPIN_PAUSE()   __asm__ __volatile__ ("yield")
+#else
+#define DRTM_SPIN_PAUSE()   do { } while (0)
+#endif
+#endif
+
+namespace drtm
+{
+
+  /**
+   * @brief A minimal lock, for the target transactions and for
+   * the rare paths that must modify a published snapshot.
+   *
+   * @details
+   * Built only on `std::atomic_flag`, so it does not need the
+   * threads support library. It is held only for short
+   * sections, like a single target transaction.
+   */
+  class spin_lock
+  {
+  public:
+
+    spin_lock () = default;
+
+    // The rule of five.
+    spin_lock (const spin_lock&) = delete;
+    spin_lock (spin_lock&&) = delete;
+    spin_lock&
+    operator= (const spin_lock&) = delete;
+    spin_lock&
+    operator= (spin_lock&&) = delete;
+
+    ~spin_lock () = default;
+
+  public:
+
+    void
+    lock (void)
+    {
+      while (flag_.test_and_set (std::memory_order_acquire))
+        {
+          DRTM_SPIN_PAUSE();
+        }
+    }
+
+    void
+    unlock (void)
+    {
+      flag_.clear (std::memory_order_release);
+    }
+
+  private:
+
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+  };
+
+  /**
+   * @brief Lock a `spin_lock` for the duration of a scope; a null
+   * pointer means there is nothing to lock.
+   */
+  class spin_lock_guard
+  {
+  public:
+
+    spin_lock_guard (spin_lock& lock) :
+        lock_ (&lock) // Parenthesis used to compile with 4.8
+    {
+      lock_->lock ();
+    }
+
+    spin_lock_guard (spin_lock* lock) :
+        lock_ (lock) // Parenthesis used to compile with 4.8
+    {
+      if (lock_ != nullptr)
+        {
+          lock_->lock ();
+        }
+    }
+
+    // The rule of five.
+    spin_lock_guard (const spin_lock_guard&) = delete;
+    spin_lock_guard (spin_lock_guard&&) = delete;
+    spin_lock_guard&
+    operator= (const spin_lock_guard&) = delete;
+    spin_lock_guard&
+    operator= (spin_lock_guard&&) = delete;
+
+    ~spin_lock_guard ()
+    {
+      if (lock_ != nullptr)
+        {
+          lock_->unlock ();
+        }
+    }
+
+  private:
+
+    spin_lock* lock_;
+  };
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_SPIN_LOCK_H_ */
@@ -0,0 +1,291 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef DRTM_STATIC_METADATA_H_
+#define DRTM_STATIC_METADATA_H_
+
+#if defined(__cplusplus)
+
+#include <drtm/types.h>
+#include <drtm/metadata.h>
+
+namespace drtm
+{
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief The metadata, with the offsets known at compile time.
+   *
+   * @details
+   * When the server is built for a single firmware family, the
+   * offsets in the thread and list links structures do not change,
+   * and can be given as a layout descriptor, so all field accesses
+   * in `run_time_data` fold into constants.
+   *
+   * The layout descriptor is a type with static constexpr members:
+   *
+   * - `thread_name_offset`, `thread_parent_offset`,
+   *   `thread_list_node_offset`, `thread_children_node_offset`,
+   *   `thread_state_offset`, `thread_stack_offset`,
+   *   `thread_prio_assigned_offset`, `thread_prio_inherited_offset`,
+   *   `thread_stack_selector_offset_words`,
+   *   `list_links_prev_offset`, `list_links_next_offset` - offsets;
+   * - `scheduler_is_started_symbol`, `scheduler_top_threads_list_symbol`,
+   *   `scheduler_current_thread_symbol` - the names of the scheduler
+   *   variables, resolved via the backend `get_symbol_address()`.
+   *
+   * The target header is not read at all.
+   *
+   * @tparam B type of the backend.
+   * @tparam L type of the layout descriptor.
+   */
+  template<typename B, typename L>
+    class static_metadata
+    {
+    public:
+
+      using backend_type = B;
+      using layout_type = L;
+
+      // These come from types.h
+      using addr_t = typename backend_type::target_addr_t;
+      using offset_t = ::drtm::target_offset_t;
+
+    public:
+
+      /**
+       * @brief Construct the metadata object instance.
+       */
+      static_metadata (backend_type& backend) :
+          backend_ (backend) // Parenthesis used to compile with 4.8
+      {
+#if defined(DEBUG)
+        printf ("%s(%p) @%p\n", __func__, &backend, this);
+#endif /* defined(DEBUG) */
+      }
+
+      // The rule of five.
+      static_metadata (const static_metadata&) = delete;
+      static_metadata (static_metadata&&) = delete;
+      static_metadata&
+      operator= (const static_metadata&) = delete;
+      static_metadata&
+      operator= (static_metadata&&) = delete;
+
+      /**
+       * @brief Destruct the metadata object instance.
+       */
+      ~static_metadata () = default;
+
+    public:
+
+      /**
+       * @brief Resolve the scheduler symbols; the offsets are
+       * already known.
+       *
+       * @retval true The symbols were resolved.
+       * @retval false A symbol was not found.
+       */
+      bool
+      parse (void)
+      {
+#if defined(DEBUG)
+        printf ("%s()\n", __func__);
+#endif /* defined(DEBUG) */
+
+        if (was_parsed)
+          {
+            return is_available;
+          }
+
+        // Set this early, to prevent useless checks if parsing fails.
+        was_parsed = true;
+
+        scheduler.is_started_addr = resolve (
+            layout_type::scheduler_is_started_symbol);
+        scheduler.top_threads_list_addr = resolve (
+            layout_type::scheduler_top_threads_list_symbol);
+        scheduler.current_thread_addr = resolve (
+            layout_type::scheduler_current_thread_symbol);
+
+        // Single core, no thread lists generation, no threads table,
+        // no sequence counter.
+        scheduler.current_threads_addr = 0;
+        scheduler.cores_count = 1;
+        scheduler.threads_generation_addr = 0;
+        scheduler.threads_table_addr = 0;
+        scheduler.threads_count_addr = 0;
+        scheduler.sequence_addr = 0;
+
+        is_available = (scheduler.is_started_addr != 0
+            && scheduler.top_threads_list_addr != 0
+            && scheduler.current_thread_addr != 0);
+
+        ++generation_;
+
+        return is_available;
+      }
+
+      /**
+       * @brief Resolve the symbols again at the next update.
+       */
+      inline void
+      invalidate (void)
+      {
+        was_parsed = false;
+        is_available = false;
+      }
+
+      /**
+       * @brief Tell if the last parse succeeded, without accessing
+       * the target.
+       */
+      inline bool
+      available (void)
+      {
+        return is_available;
+      }
+
+      /**
+       * @brief Get the number of times the symbols were resolved.
+       */
+      inline uint32_t
+      generation (void)
+      {
+        return generation_;
+      }
+
+    protected:
+
+      addr_t
+      resolve (const char* name)
+      {
+        addr_t addr = backend_.get_symbol_address (name);
+        if (addr == 0x0)
+          {
+            backend_.output_error ("The '%s' symbol was not resolved.\n",
+                                   name);
+          }
+        return addr;
+      }
+
+    private:
+
+      backend_type& backend_;
+
+      // Used to prevent resolving the symbols multiple times.
+      bool was_parsed = false;
+
+      // Once checked, tell if the symbols were resolved.
+      bool is_available = false;
+
+      uint32_t generation_ = 0;
+
+    public:
+
+      struct scheduler_s
+      {
+        addr_t is_started_addr;
+        addr_t top_threads_list_addr;
+        addr_t current_thread_addr;
+        addr_t current_threads_addr;
+        uint16_t cores_count;
+        addr_t threads_generation_addr;
+        addr_t threads_table_addr;
+        addr_t threads_count_addr;
+        addr_t sequence_addr;
+      } scheduler;
+
+      // The members are accessed with the same syntax as in
+      // `metadata`, but are constants.
+      struct thread_s
+      {
+        static constexpr offset_t name_offset = layout_type::thread_name_offset;
+        static constexpr offset_t parent_offset =
+            layout_type::thread_parent_offset;
+        static constexpr offset_t list_node_offset =
+            layout_type::thread_list_node_offset;
+        static constexpr offset_t children_node_offset =
+            layout_type::thread_children_node_offset;
+        static constexpr offset_t state_offset =
+            layout_type::thread_state_offset;
+        static constexpr offset_t stack_offset =
+            layout_type::thread_stack_offset;
+        static constexpr offset_t prio_assigned_offset =
+            layout_type::thread_prio_assigned_offset;
+        static constexpr offset_t prio_inherited_offset =
+            layout_type::thread_prio_inherited_offset;
+        static constexpr offset_t stack_selector_offset_words =
+            layout_type::thread_stack_selector_offset_words;
+      } thread;
+
+      struct list_links_s
+      {
+        static constexpr offset_t prev_offset =
+            layout_type::list_links_prev_offset;
+        static constexpr offset_t next_offset =
+            layout_type::list_links_next_offset;
+      } list_links;
+
+    };
+
+#pragma GCC diagnostic pop
+
+  // --------------------------------------------------------------------------
+
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::name_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::parent_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::list_node_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::children_node_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::state_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::stack_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::prio_assigned_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::prio_inherited_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::thread_s::stack_selector_offset_words;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::list_links_s::prev_offset;
+  template<typename B, typename L>
+    constexpr target_offset_t static_metadata<B, L>::list_links_s::next_offset;
+
+// ----------------------------------------------------------------------------
+} /* namespace drtm */
+
+#endif /* defined(__cplusplus) */
+
+#endif /* DRTM_STATIC_METADATA_H_ */
@@ -31,17 +31,25 @@
 #if defined(__cplusplus)
 
 #include <drtm/types.h>
+#include <drtm/sink.h>
+#include <drtm/frames.h>
+#include <drtm/fixed-capacity.h>
 
 #include <vector>
 #include <memory>
+#include <iterator>
+#include <limits>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 
 // Initial reservation for the threads collection.
 #define THREADS_ALLOCATED_SIZE_POINTERS   20
 
-// TODO: make this configurable
-#define STACK_CONTEXT_REGISTERS_SIZE_WORDS    50
+// The maximum number of cores of multi-core targets.
+#if !defined(DRTM_CORES_MAX_COUNT)
+#define DRTM_CORES_MAX_COUNT   8
+#endif
 
 namespace drtm
 {
@@ -58,14 +66,17 @@ namespace drtm
    *
    * The second purpose is to store a copy of the registers, retrieved
    * from the thread context.
+   *
+   * @tparam F The stack frame layout policy, from `frames.h`.
    */
-  template<typename B, typename A>
+  template<typename B, typename A, typename F = default_frame_type>
     class thread
     {
     public:
 
       using backend_type = B;
       using allocator_type = A;
+      using frame_type = F;
 
       // This comes from types.h
       using addr_t = typename backend_type::target_addr_t;
@@ -80,11 +91,13 @@ namespace drtm
       // Thread ID when the scheduler is not started.
       static constexpr thread_id_t id_none = 0;
 
-      static constexpr std::size_t name_max_size_bytes = 256;
+      static constexpr std::size_t name_max_size_bytes = capacity_traits<
+          allocator_type>::name_max_size_bytes;
 
       static constexpr const char* default_description = "none";
 
-      static constexpr std::size_t register_size_bytes = 4;
+      static constexpr std::size_t register_size_bytes =
+          frame_type::register_size_bytes;
 
     public:
 
@@ -185,14 +198,134 @@ namespace drtm
         id_ = 0;
 
         name[0] = '\0';
+
+        clear_state ();
+      }
+
+      /**
+       * @brief Clear the members that change while the thread runs;
+       * the address, the ID and the name are kept.
+       */
+      void
+      clear_state (void)
+      {
         prio_assigned = 0;
         prio_inherited = 0;
         state = 0;
 
         // Clearing the entire stack is ok, no references inside.
         std::memset (&stack, 0, sizeof(stack));
+
+        invalidate_registers_reply ();
+      }
+
+      /**
+       * @brief Copy the members read from the target from another
+       * thread object, like from another snapshot; the registers
+       * are read again, when requested.
+       */
+      void
+      copy_from (thread& other)
+      {
+        addr_ = other.addr_;
+        id_ = other.id_;
+
+        std::memcpy (&name[0], &other.name[0], sizeof(name));
+        prio_assigned = other.prio_assigned;
+        prio_inherited = other.prio_inherited;
+        state = other.state;
+
+        // Only the stack pointer and the layout.
+        std::memset (&stack, 0, sizeof(stack));
+        stack.addr = other.stack.addr;
+        stack.is_floating_point = other.stack.is_floating_point;
+        stack.info = other.stack.info;
+        std::memcpy (&stack.sp_addr[0], &other.stack.sp_addr[0],
+                     sizeof(stack.sp_addr));
+
+        invalidate_registers_reply ();
+      }
+
+      /**
+       * @brief Invalidate the cached registers reply.
+       *
+       * @details
+       * Must be called when the registers are written; a new snapshot
+       * invalidates it via `clear()`.
+       */
+      inline void
+      invalidate_registers_reply (void)
+      {
+        registers_reply.is_cached.store (false, std::memory_order_release);
+        registers_reply.length = 0;
+      }
+
+      /**
+       * @brief Tell if the thread was read from the target; the
+       * threads whose IDs were streamed before their details were
+       * read have only the address.
+       */
+      inline bool
+      is_read (void)
+      {
+        return stack.info != nullptr;
+      }
+
+      /**
+       * @brief Tell if the registers reply is rendered; once set,
+       * the reply does not change until the next snapshot.
+       */
+      inline bool
+      is_registers_reply_cached (void)
+      {
+        return registers_reply.is_cached.load (std::memory_order_acquire);
       }
 
+      /**
+       * @brief Read the registers, if needed, and render the reply
+       * in the thread cache.
+       */
+      void
+      prepare_registers_reply (void)
+      {
+        if (is_registers_reply_cached ())
+          {
+            return;
+          }
+
+        read_stack ();
+
+        assert(
+            stack.info->out_registers * register_size_bytes * 2
+                <= sizeof(registers_reply.text));
+
+        sink<char*> reply
+          { &registers_reply.text[0], sizeof(registers_reply.text) };
+        for (std::size_t i = 0; i < stack.info->out_registers; ++i)
+          {
+            output_register (i, reply);
+          }
+
+        registers_reply.length = reply.length ();
+        registers_reply.is_cached.store (true, std::memory_order_release);
+      }
+
+      /**
+       * @brief Output the general registers, as HEX string.
+       *
+       * @details
+       * The first request of a snapshot reads the registers and renders
+       * the reply in the thread cache; later requests only copy it.
+       */
+      template<typename O>
+        void
+        output_registers (sink<O>& out)
+        {
+          prepare_registers_reply ();
+
+          out.write (&registers_reply.text[0], registers_reply.length);
+        }
+
       /**
        * @brief Compose the thread description, from name, state and priority.
        *
@@ -200,52 +333,114 @@ namespace drtm
        * If inherited priority is different from assigned priority,
        * the later is shown in parenthesis.
        *
+       * @tparam O Type of the sink output iterator.
+       * @param [out] out The sink where the description is written.
+       */
+      template<typename O>
+        void
+        prepare_description (sink<O>& out)
+        {
+          const char* st;
+          if (state < sizeof(thread_states) / sizeof(thread_states[0]))
+            {
+              st = thread_states[state];
+            }
+          else
+            {
+              st = "?";
+            }
+
+          out.write (name);
+          out.write (" [S:");
+          out.write (st);
+          out.write (", P:");
+
+          if (prio_inherited > prio_assigned)
+            {
+              out.write_unsigned (prio_inherited);
+              out.put ('(');
+              out.write_unsigned (prio_assigned);
+              out.put (')');
+            }
+          else
+            {
+              out.write_unsigned (prio_assigned);
+            }
+
+          if (stack.is_floating_point)
+            {
+              out.write (", FP");
+            }
+
+          out.put (']');
+        }
+
+      /**
+       * @brief Compose the thread description in a string buffer.
+       *
        * @return Number of characters in description, excluding '\0'.
        */
       std::size_t
       prepare_description (char* out_description, std::size_t out_size_bytes)
       {
-        const char* st;
-        if (state < sizeof(thread_states) / sizeof(thread_states[0]))
-          {
-            st = thread_states[state];
-          }
-        else
-          {
-            st = "?";
-          }
+        assert(out_size_bytes > 0);
 
-        std::size_t count = 0;
-        char* out = out_description;
-        int ret;
+        sink<char*> out
+          { out_description, out_size_bytes - 1 };
+        prepare_description (out);
+        out_description[out.length ()] = '\0';
 
-        ret = snprintf (out + count, out_size_bytes - count, "%s [S:%s, P:",
-                        name, st);
-        count += static_cast<std::size_t> (ret);
+        return out.length ();
+      }
 
-        if (prio_inherited > prio_assigned)
-          {
-            ret = snprintf (out + count, out_size_bytes - count, "%u(%u)",
-                            prio_inherited, prio_assigned);
-            count += static_cast<std::size_t> (ret);
-          }
-        else
+      /**
+       * @brief Tell if the description cached in the arena is still valid.
+       *
+       * @details
+       * The description depends only on the name, state, priorities
+       * and FP flag. The cached text starts with the name, so comparing
+       * it with the current name is enough to detect a name change.
+       *
+       * @param [in] arena Pointer to the arena with the cached text.
+       * @param [in] arena_size_bytes The size of the arena.
+       */
+      bool
+      is_description_cached (const char* arena, std::size_t arena_size_bytes)
+      {
+        if (!description.is_cached
+            || description.offset + description.length > arena_size_bytes)
           {
-            ret = snprintf (out + count, out_size_bytes - count, "%u",
-                            prio_assigned);
-            count += static_cast<std::size_t> (ret);
+            return false;
           }
 
-        if (stack.is_floating_point)
+        if (description.state != state
+            || description.prio_assigned != prio_assigned
+            || description.prio_inherited != prio_inherited
+            || description.is_floating_point != stack.is_floating_point)
           {
-            ret = snprintf (out + count, out_size_bytes - count, ", FP");
-            count += static_cast<std::size_t> (ret);
+            return false;
           }
 
-        ret = snprintf (out + count, out_size_bytes - count, "]");
-        count += static_cast<std::size_t> (ret);
+        std::size_t name_length = std::strlen (name);
+        return (name_length == description.name_length
+            && std::memcmp (arena + description.offset, name, name_length) == 0);
+      }
 
-        return count;
+      /**
+       * @brief Remember where the description was stored in the arena,
+       * and the values it was rendered from.
+       */
+      void
+      cache_description (std::size_t offset, std::size_t length)
+      {
+        description.offset = offset;
+        description.length = length;
+        description.name_length = std::strlen (name);
+        description.state = state;
+        description.prio_assigned = prio_assigned;
+        description.prio_inherited = prio_inherited;
+        description.is_floating_point = stack.is_floating_point;
+        description.is_cached = true;
       }
 
       /**
@@ -253,52 +448,77 @@ namespace drtm
        * Endianness is ensured, registers were read-in also one byte at a time
        * and so the order is not changed.
        *
-       * @return The next free position in the output string.
+       * @tparam O Type of the sink output iterator.
+       * @param [in] reg_index Index of the register.
+       * @param [out] out The sink where the hex digits are written.
+       */
+      template<typename O>
+        void
+        output_register (std::size_t reg_index, sink<O>& out)
+        {
+          assert(stack.info != nullptr);
+          assert(reg_index < stack.info->offsets_size);
+
+          if (reg_index < stack.info->out_registers
+              && is_registers_reply_cached ())
+            {
+              // Already rendered for the full reply, copy it.
+              out.write (
+                  &registers_reply.text[reg_index * register_size_bytes * 2],
+                  register_size_bytes * 2);
+              return;
+            }
+
+          register_offset_t offset = stack.info->offsets[reg_index];
+          for (std::size_t j = 0; j < register_size_bytes; ++j)
+            {
+              if (offset == -1)
+                {
+                  out.write_hex_byte (0);
+                }
+              else if (offset == -2)
+                {
+                  // SP is displayed separately, not from the thread context,
+                  // but from the TCB, it is fetched for each thread.
+                  out.write_hex_byte (stack.sp_addr[j]);
+                }
+              else
+                {
+                  out.write_hex_byte (
+                      stack.context[static_cast<std::size_t> (offset)
+                          * register_size_bytes + j]);
+                }
+            }
+        }
+
+      /**
+       * Serialize a register in a string buffer.
+       *
+       * @return The number of characters written, excluding '\0'.
        */
       std::size_t
       output_register (std::size_t reg_index, char* out,
                        std::size_t out_size_bytes)
       {
-        assert(stack.info != nullptr);
-        std::size_t count = 0;
-        int ret;
-        for (std::size_t j = 0; j < 4; ++j)
-          {
-            if (count + 3 >= out_size_bytes)
-              {
-                break;
-              }
-            register_offset_t offset = stack.info->offsets[reg_index];
-            if (offset == -1)
-              {
-                ret = snprintf (out, 3, "%02X", 0);
-              }
-            else if (offset == -2)
-              {
-                // SP is displayed separately, not from the thread context,
-                // but from the TCB, it is fetched for each thread.
-                ret = snprintf (out, 3, "%02X", stack.sp_addr[j]);
-              }
-            else
-              {
-                ret = snprintf (
-                    out,
-                    3,
-                    "%02X",
-                    stack.context[static_cast<std::size_t> (offset)
-                        * register_size_bytes + j]);
-              }
-            count += static_cast<std::size_t> (ret);
-            out += ret;
-          }
+        assert(out_size_bytes > 0);
 
-        return count;
+        sink<char*> s
+          { out, out_size_bytes - 1 };
+        output_register (reg_index, s);
+        out[s.length ()] = '\0';
+
+        return s.length ();
       }
 
       // ----------------------------------------------------------------------
 
       /**
-       * @brief Read registers from the stack context to a byte array.
+       * @brief Read the core registers from the stack context
+       * to a byte array.
+       *
+       * @details
+       * The FP bank, if present above the core registers, is not read;
+       * use `read_stack_fp()` when a FP register is needed.
        */
       void
       read_stack (void)
@@ -314,32 +534,149 @@ namespace drtm
 
         const stack_info_t* si = stack.info;
 
-        assert(sizeof(stack.context) >= si->in_registers * register_size_bytes);
+        assert(
+            sizeof(stack.context) >= si->core_in_registers * register_size_bytes);
 
         // Registers are read one byte at a time, in ascending memory order.
         backend_.read_byte_array (stack.addr, &stack.context[0],
-                                  si->in_registers * register_size_bytes);
+                                  si->core_in_registers * register_size_bytes);
 
 #if defined(DEBUG)
-        printf ("in ");
-        for (std::size_t i = 0; i < si->in_registers * register_size_bytes; i++)
+        dump_context (0, si->core_in_registers);
+#endif /* defined(DEBUG) */
+
+        stack.has_registers = true;
+      }
+
+      /**
+       * @brief Read the largest possible frame in a single transaction,
+       * and decide the layout from it.
+       *
+       * @details
+       * The layout selector (like EXC_RETURN) is taken from the buffer,
+       * so there is no need to read it separately; all registers,
+       * including the FP bank, are then available without further
+       * reads.
+       *
+       * The read may fail if the stack is close to the end of the
+       * memory, or the selector may be outside the buffer; in
+       * these cases the caller should use the lazy path.
+       *
+       * @param selector_offset_words The offset, from SP, of the selector.
+       * @retval true The context was read and the layout decided.
+       * @retval false The read failed, nothing was changed.
+       */
+      bool
+      read_stack_speculative (std::size_t selector_offset_words =
+                                  frame_type::selector_offset_words)
+      {
+        if ((selector_offset_words + 1) * register_size_bytes
+            > sizeof(stack.context))
           {
-            if (i % 4 == 0)
-              {
-                printf (" ");
-              }
-            printf ("%02X", stack.context[i]);
+            return false;
           }
-        printf ("\n");
+
+        int ret = backend_.read_byte_array (stack.addr, &stack.context[0],
+                                            sizeof(stack.context));
+        if (ret < 0)
+          {
+            return false;
+          }
+
+        uint32_t selector = backend_.load_long (
+            &stack.context[selector_offset_words * register_size_bytes]);
+
+#if defined(DEBUG)
+        printf ("thread EXC_RETURN 0x%08X (speculative)\n", selector);
 #endif /* defined(DEBUG) */
 
+        stack.info = frame_type::frame_info (selector);
+        stack.is_floating_point = stack.info->is_floating_point;
+
         stack.has_registers = true;
+        stack.has_fp_registers = true;
+
+        return true;
+      }
+
+      /**
+       * @brief Read the FP bank from the stack context to a byte array.
+       *
+       * @details
+       * These are the words above the core registers; they are
+       * read only when GDB asks for a FP register.
+       */
+      void
+      read_stack_fp (void)
+      {
+        if (stack.has_fp_registers)
+          {
+            return;
+          }
+
+        const stack_info_t* si = stack.info;
+
+        if (si->in_registers > si->core_in_registers)
+          {
+#if defined(DEBUG)
+            printf ("%s() @%p\n", __func__, this);
+#endif /* defined(DEBUG) */
+
+            assert(
+                sizeof(stack.context) >= si->in_registers * register_size_bytes);
+
+            std::size_t offset = si->core_in_registers * register_size_bytes;
+            backend_.read_byte_array (
+                static_cast<addr_t> (stack.addr + offset),
+                &stack.context[offset],
+                (si->in_registers - si->core_in_registers)
+                    * register_size_bytes);
+
+#if defined(DEBUG)
+            dump_context (si->core_in_registers, si->in_registers);
+#endif /* defined(DEBUG) */
+          }
+
+        stack.has_fp_registers = true;
+      }
+
+      /**
+       * @brief Tell if the register is saved in the FP bank, which
+       * must be read with `read_stack_fp()` before output.
+       */
+      bool
+      is_in_fp_bank (std::size_t reg_index)
+      {
+        assert(stack.info != nullptr);
+        assert(reg_index < stack.info->offsets_size);
+
+        register_offset_t offset = stack.info->offsets[reg_index];
+        return (offset >= 0
+            && static_cast<uint32_t> (offset) >= stack.info->core_in_registers);
       }
 
       // ----------------------------------------------------------------------
 
     private:
 
+#if defined(DEBUG)
+      void
+      dump_context (std::size_t first_word, std::size_t end_word)
+      {
+        printf ("in ");
+        for (std::size_t i = first_word * register_size_bytes;
+            i < end_word * register_size_bytes; i++)
+          {
+            if (i % 4 == 0)
+              {
+                printf (" ");
+              }
+            printf ("%02X", stack.context[i]);
+          }
+        printf ("\n");
+      }
+#endif /* defined(DEBUG) */
+
       backend_type& backend_;
       allocator_type& allocator_;
 
@@ -357,12 +694,39 @@ namespace drtm
       {
         addr_t addr;
         bool has_registers;
+        bool has_fp_registers;
         bool is_floating_point;
         const stack_info_t* info;
-        uint8_t context[STACK_CONTEXT_REGISTERS_SIZE_WORDS * register_size_bytes];
+        uint8_t context[frame_type::context_size_words * register_size_bytes];
         uint8_t sp_addr[register_size_bytes];
       } stack;
 
+      // The rendered `g` reply; valid until the next snapshot or
+      // a register write. Once `is_cached` is set, concurrent readers
+      // may copy the text without locks.
+      struct registers_reply_s
+      {
+        char text[frame_type::out_registers_size_words * register_size_bytes
+            * 2];
+        std::size_t length;
+        std::atomic<bool> is_cached;
+      } registers_reply;
+
+      // The location of the rendered description in the threads
+      // collection arena; not cleared by `clear()`, it must survive
+      // between snapshots.
+      struct description_s
+      {
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        std::size_t name_length = 0;
+        uint8_t state = 0;
+        uint8_t prio_assigned = 0;
+        uint8_t prio_inherited = 0;
+        bool is_floating_point = false;
+        bool is_cached = false;
+      } description;
+
     public:
 
       static const char* thread_states[];
@@ -375,7 +739,7 @@ namespace drtm
    * @brief A class template to manage a collection (an array)
    * of pointers o threads.
    */
-  template<typename B, typename A>
+  template<typename B, typename A, typename F = default_frame_type>
     class threads
     {
 
@@ -383,8 +747,16 @@ namespace drtm
 
       using backend_type = B;
       using allocator_type = A;
+      using frame_type = F;
+
+      using thread_type = class thread<B, A, F>;
 
-      using thread_type = class thread<B, A>;
+      // Dynamic, or, for allocators like `fixed_capacity_allocator`,
+      // with static arrays.
+      using capacity_type = capacity_traits<allocator_type>;
+
+      // The longest description, after the name.
+      static constexpr std::size_t description_max_extra_size_bytes = 32;
 
       // Make a new allocator, for threads.
       using thread_allocator_type =
@@ -394,7 +766,21 @@ namespace drtm
       using vector_allocator_type =
       typename std::allocator_traits<allocator_type>::template rebind_alloc<thread_type*>;
 
-      using collection_type = class std::vector<thread_type*, vector_allocator_type>;
+      using collection_type = typename std::conditional<capacity_type::is_fixed,
+      fixed_vector<thread_type*, capacity_type::threads_max_count>,
+      std::vector<thread_type*, vector_allocator_type>>::type;
+
+      // Make a new allocator, for characters.
+      using char_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<char>;
+
+      // A compact storage for the descriptions of all threads.
+      using arena_type = typename std::conditional<capacity_type::is_fixed,
+      fixed_vector<char,
+      capacity_type::threads_max_count
+      * (capacity_type::name_max_size_bytes
+          + description_max_extra_size_bytes)>,
+      std::vector<char, char_allocator_type>>::type;
 
       using thread_id_t = typename thread_type::thread_id_t;
       using thread_addr_t = typename thread_type::thread_addr_t;
@@ -473,6 +859,10 @@ namespace drtm
       {
         count_ = 0;
         current_ = nullptr;
+        for (auto& th : current_per_core_)
+          {
+            th = nullptr;
+          }
       }
 
       /**
@@ -502,7 +892,8 @@ namespace drtm
       inline iterator
       end ()
       {
-        return threads_.end ();
+        // Threads past the count are kept for reuse, but are not valid.
+        return threads_.begin () + static_cast<difference_type> (count_);
       }
 
       // ----------------------------------------------------------------------
@@ -510,6 +901,9 @@ namespace drtm
 
       /**
        * @brief Allocate and construct a new thread object instance.
+       *
+       * @return The thread, or nullptr if the fixed capacity
+       *  is exhausted.
        */
       thread_type*
       new_thread (void)
@@ -524,8 +918,20 @@ namespace drtm
             return th;
           }
 
-        auto* th = std::allocator_traits<thread_allocator_type>::allocate (
-            reinterpret_cast<thread_allocator_type&> (allocator_), 1);
+        thread_type* th;
+        if (capacity_type::is_fixed)
+          {
+            th = static_cast<thread_type*> (slots_.allocate ());
+            if (th == nullptr)
+              {
+                return nullptr;
+              }
+          }
+        else
+          {
+            th = std::allocator_traits<thread_allocator_type>::allocate (
+                reinterpret_cast<thread_allocator_type&> (allocator_), 1);
+          }
 
         // Call the constructor.
         new (th) thread_type (backend_, allocator_);
@@ -545,8 +951,11 @@ namespace drtm
         // Call the destructor.
         th->~thread_type ();
 
-        std::allocator_traits<thread_allocator_type>::deallocate (
-            reinterpret_cast<thread_allocator_type&> (allocator_), th, 1);
+        if (!capacity_type::is_fixed)
+          {
+            std::allocator_traits<thread_allocator_type>::deallocate (
+                reinterpret_cast<thread_allocator_type&> (allocator_), th, 1);
+          }
       }
 
       /**
@@ -565,17 +974,58 @@ namespace drtm
       }
 
       /**
-       * @brief Check if a given thread is the current thread.
+       * @brief Get the thread running on a core.
+       */
+      inline thread_type*
+      current (std::size_t core)
+      {
+        return (core < cores_count_) ? current_per_core_[core] : nullptr;
+      }
+
+      inline void
+      current (std::size_t core, thread_type* th)
+      {
+        current_per_core_[core] = th;
+      }
+
+      /**
+       * @brief Get the number of cores, at least 1.
+       */
+      inline std::size_t
+      cores_count (void)
+      {
+        return cores_count_;
+      }
+
+      inline void
+      cores_count (std::size_t count)
+      {
+        cores_count_ = count;
+      }
+
+      /**
+       * @brief Check if a given thread is the current thread, or,
+       * on multi-core targets, is running on any core; its registers
+       * are in the core, not on the stack.
        */
       bool
       is_current (thread_id_t tid)
       {
-        if (current_ == nullptr)
+        if (current_ != nullptr && current_->id () == tid)
           {
-            return false;
+            return true;
+          }
+
+        for (std::size_t core = 0; core < cores_count_; ++core)
+          {
+            thread_type* th = current_per_core_[core];
+            if (th != nullptr && th->id () == tid)
+              {
+                return true;
+              }
           }
 
-        return (current_->id () == tid);
+        return false;
       }
 
       /**
@@ -584,7 +1034,7 @@ namespace drtm
       thread_type*
       thread (thread_id_t tid)
       {
-        for (auto* th : threads_)
+        for (auto* th : *this)
           {
             if (th->id () == tid)
               {
@@ -595,13 +1045,106 @@ namespace drtm
         return nullptr;
       }
 
+      // ----------------------------------------------------------------------
+      // Descriptions.
+
+      /**
+       * @brief Render the descriptions of all threads in the arena.
+       *
+       * @details
+       * Called once per snapshot, after the threads were updated.
+       * The arenas are double buffered; descriptions of threads
+       * whose name, state, priorities and FP flag did not change
+       * are copied from the previous arena, the others are rendered.
+       */
+      void
+      prepare_descriptions (void)
+      {
+        arena_type& previous = descriptions_[descriptions_index_];
+        arena_type& next = descriptions_[descriptions_index_ ^ 1];
+
+        next.clear ();
+
+        for (std::size_t i = 0; i < count_; ++i)
+          {
+            thread_type* th = threads_[i];
+            if (!th->is_read ())
+              {
+                // Only the ID was streamed, nothing to describe.
+                th->description.is_cached = false;
+                continue;
+              }
+
+            std::size_t offset = next.size ();
+            // Only fixed capacity arenas may be exhausted.
+            std::size_t available = next.max_size () - offset;
+
+            if (th->is_description_cached (previous.data (), previous.size ())
+                && th->description.length <= available)
+              {
+                const char* p = previous.data () + th->description.offset;
+                next.insert (next.end (), p, p + th->description.length);
+              }
+            else
+              {
+                sink<std::back_insert_iterator<arena_type>> out
+                  { std::back_inserter (next), available };
+                th->prepare_description (out);
+                if (out.overflow ())
+                  {
+                    // Not cached, it will be rendered when requested.
+                    next.resize (offset);
+                    th->description.is_cached = false;
+                    continue;
+                  }
+              }
+
+            th->cache_description (offset, next.size () - offset);
+          }
+
+        // Threads kept for reuse refer to an arena that will be cleared.
+        for (std::size_t i = count_; i < threads_.size (); ++i)
+          {
+            threads_[i]->description.is_cached = false;
+          }
+
+        descriptions_index_ ^= 1;
+      }
+
+      /**
+       * @brief Output the thread description, from the arena if available.
+       */
+      template<typename O>
+        void
+        output_description (thread_type* th, sink<O>& out)
+        {
+          arena_type& arena = descriptions_[descriptions_index_];
+
+          if (th->is_description_cached (arena.data (), arena.size ()))
+            {
+              out.write (arena.data () + th->description.offset,
+                         th->description.length);
+            }
+          else
+            {
+              th->prepare_description (out);
+            }
+        }
+
     private:
 
       backend_type& backend_;
       allocator_type& allocator_;
 
+      // The storage of the thread objects, for fixed capacity.
+      fixed_slots<thread_type, capacity_type::threads_max_count> slots_;
+
       thread_type* current_ = nullptr;
 
+      // The threads running on each core.
+      thread_type* current_per_core_[DRTM_CORES_MAX_COUNT];
+      std::size_t cores_count_ = 1;
+
       std::size_t count_ = 0;
 
       // A collection (vector) of pointers to
@@ -609,14 +1152,27 @@ namespace drtm
       collection_type threads_
         { reinterpret_cast<vector_allocator_type&> (allocator_) };
 
+      // Double buffered descriptions arenas; one is used by the current
+      // snapshot, the other one is rebuilt at the next snapshot.
+      arena_type descriptions_[2]
+        {
+          arena_type
+            { reinterpret_cast<char_allocator_type&> (allocator_) },
+          arena_type
+            { reinterpret_cast<char_allocator_type&> (allocator_) } };
+      std::size_t descriptions_index_ = 0;
+
     };
 
 #pragma GCC diagnostic pop
 
 // --------------------------------------------------------------------------
 
-  template<typename B, typename A>
-    const char* thread<B, A>::thread_states[6] =
+  template<typename B, typename A, typename F>
+    constexpr std::size_t threads<B, A, F>::description_max_extra_size_bytes;
+
+  template<typename B, typename A, typename F>
+    const char* thread<B, A, F>::thread_states[6] =
       {
       //
           "Undefined",//
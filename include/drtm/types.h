@@ -48,14 +48,85 @@ namespace drtm
 
   typedef struct stack_info_s
   {
+    // Number of words in the saved context, from SP up.
     uint32_t in_registers;
+    // Number of words, from SP up, that hold all core registers;
+    // the rest of the context (the FP bank) is read only on demand.
+    uint32_t core_in_registers;
     uint32_t out_registers;
     const register_offset_t* offsets;
     uint32_t offsets_size;
+    // True if the frame includes a FP context.
+    bool is_floating_point;
   } stack_info_t;
 
+  /**
+   * @brief The metadata computed on the host, without reading
+   * the DRTM header from the target (like from the DWARF
+   * debug information).
+   */
+  typedef struct offline_metadata_s
+  {
+    uint64_t scheduler_is_started_addr;
+    uint64_t scheduler_top_threads_list_addr;
+    uint64_t scheduler_current_thread_addr;
+
+    target_offset_t thread_name_offset;
+    target_offset_t thread_parent_offset;
+    target_offset_t thread_list_node_offset;
+    target_offset_t thread_children_node_offset;
+    target_offset_t thread_state_offset;
+    target_offset_t thread_stack_offset;
+    target_offset_t thread_prio_assigned_offset;
+    target_offset_t thread_prio_inherited_offset;
+
+    target_offset_t list_links_prev_offset;
+    target_offset_t list_links_next_offset;
+  } offline_metadata_t;
+
+  /**
+   * @brief The statistics of the updates checked with the target
+   * sequence counter, while the target runs.
+   */
+  typedef struct consistency_statistics_s
+  {
+    // Updates checked with the sequence counter.
+    uint64_t updates_count;
+    // Updates read again because the threads changed meanwhile.
+    uint64_t retries_count;
+    // Updates published inconsistent, after all retries.
+    uint64_t failures_count;
+    // The most retries needed by an update.
+    uint32_t retries_max_count;
+  } consistency_statistics_t;
+
+  /**
+   * @brief The limits of a single call of a budgeted update;
+   * zero means no limit.
+   */
+  typedef struct update_budget_s
+  {
+    // Target transactions.
+    uint32_t transactions_max_count;
+    // Duration, in microseconds.
+    uint32_t duration_max_us;
+  } update_budget_t;
+
 #pragma GCC diagnostic pop
 
+  /**
+   * @brief How much is read from the target by an update.
+   */
+  enum class update_mode
+    : uint8_t
+      {
+        // Walk all thread lists.
+        full,
+        // While single stepping; if the running thread and the top
+        // threads list did not change, keep the current snapshot.
+        step
+  };
+
 // ----------------------------------------------------------------------------
 } /* namespace drtm */
 
@@ -46,6 +46,10 @@
 #include <cassert>
 #include <cstdarg>
 
+#if defined(DRTM_USE_ELF_SYMBOLS)
+#include <drtm/elf-symbols.h>
+#endif /* defined(DRTM_USE_ELF_SYMBOLS) */
+
 namespace your_namespace
 {
   namespace drtm
@@ -98,12 +102,37 @@ namespace your_namespace
 
       public:
 
+#if defined(DRTM_USE_ELF_SYMBOLS)
+
+        /**
+         * @brief Use the indexed ELF symbols, if the server
+         * has access to the application file.
+         */
+        void
+        elf_symbols (const ::drtm::elf_symbols<>* elf)
+        {
+          elf_symbols_ = elf;
+        }
+
+#endif /* defined(DRTM_USE_ELF_SYMBOLS) */
+
         // TODO: adjust it ot match the members in your symbols table.
         target_addr_t
         get_symbol_address (const char* name)
         {
           assert(name != nullptr);
 
+#if defined(DRTM_USE_ELF_SYMBOLS)
+          if (elf_symbols_ != nullptr)
+            {
+              ::drtm::elf_symbols<>::address_t address;
+              if (elf_symbols_->lookup (name, &address))
+                {
+                  return static_cast<target_addr_t> (address);
+                }
+            }
+#endif /* defined(DRTM_USE_ELF_SYMBOLS) */
+
           const symbols_type* p = symbols_;
           for (; p->name; ++p)
             {
@@ -616,6 +645,10 @@ namespace your_namespace
       private:
 
         const symbols_type* symbols_;
+
+#if defined(DRTM_USE_ELF_SYMBOLS)
+        const ::drtm::elf_symbols<>* elf_symbols_ = nullptr;
+#endif /* defined(DRTM_USE_ELF_SYMBOLS) */
       };
 
 #pragma GCC diagnostic pop
@@ -116,8 +116,12 @@ namespace your_namespace
 
           if (objects > max_size ())
             {
+#if defined(__EXCEPTIONS)
               throw std::system_error (
                   std::error_code (EINVAL, std::system_category ()));
+#else
+              return nullptr;
+#endif /* defined(__EXCEPTIONS) */
             }
 
           value_type*p = static_cast<value_type*> (yapp_malloc (
@@ -164,6 +168,50 @@ namespace your_namespace
         // None.
       };
 
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief A memory resource that allocates memory via
+     * the backend memory management functions.
+     *
+     * @details
+     * Use it as the upstream of the `::drtm::pool_resource` and
+     * `::drtm::monotonic_buffer_resource`, with a
+     * `::drtm::polymorphic_allocator`.
+     */
+    class memory_resource : public ::drtm::memory_resource
+    {
+    protected:
+
+      virtual void*
+      do_allocate (std::size_t bytes,
+                   std::size_t align __attribute__((unused))) override
+      {
+        void* p = yapp_malloc (bytes);
+#if defined(__EXCEPTIONS)
+        if (p == nullptr)
+          {
+            throw std::system_error (
+                std::error_code (ENOMEM, std::system_category ()));
+          }
+#endif /* defined(__EXCEPTIONS) */
+        return p;
+      }
+
+      virtual void
+      do_deallocate (void* p, std::size_t bytes __attribute__((unused)),
+                     std::size_t align __attribute__((unused))) override
+      {
+        yapp_free (p);
+      }
+
+      virtual bool
+      do_is_equal (::drtm::memory_resource const & other) const noexcept override
+      {
+        return this == &other;
+      }
+    };
+
     ;
   // Avoid formatter bug
   // ==========================================================================
@@ -0,0 +1,460 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * This sample file provides a backend and an allocator that
+ * forward all calls to a table of function pointers (`drtm_ops_t`),
+ * each called with the user data pointer of the session.
+ *
+ * They are used by the handle based C API, where each session
+ * (`drtm_context_t`) owns its backend, allocator and frontend,
+ * so multiple targets can be served by the same process, from
+ * different host threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <your-application.h>
+#include <drtm/c-api.h>
+
+#if defined(__cplusplus)
+
+#include <cstring>
+#include <cassert>
+#include <cstdarg>
+#include <limits>
+#include <system_error>
+
+namespace your_namespace
+{
+  namespace drtm
+  {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief A backend that forwards calls to a table of functions.
+     */
+    class ops_backend
+    {
+    public:
+
+      constexpr static std::size_t tmp_buf_size_bytes = 256;
+
+      // Common types; will be propagated where needed.
+      using target_addr_t = drtm_target_addr_t;
+      using thread_id_t = drtm_thread_id_t;
+
+    public:
+
+      /**
+       * @brief Construct a backend for a session.
+       *
+       * @param ops Pointer to the session functions; must be valid
+       *  during the life of the backend.
+       */
+      ops_backend (const drtm_ops_t* ops) :
+          ops_ (ops) // Parenthesis used to compile with 4.8
+      {
+#if defined(DEBUG)
+        printf ("%s(%p) @%p\n", __func__, ops, this);
+#endif /* defined(DEBUG) */
+      }
+
+      // The rule of five.
+      ops_backend (const ops_backend&) = delete;
+      ops_backend (ops_backend&&) = delete;
+      ops_backend&
+      operator= (const ops_backend&) = delete;
+      ops_backend&
+      operator= (ops_backend&&) = delete;
+
+      ~ops_backend () = default;
+
+    public:
+
+      target_addr_t
+      get_symbol_address (const char* name)
+      {
+        assert(name != nullptr);
+        return ops_->get_symbol_address (ops_->user_data, name);
+      }
+
+      int
+      output (const char* fmt, ...)
+      {
+        std::va_list args;
+        va_start(args, fmt);
+
+        int ret = ops_->voutput (ops_->user_data, fmt, args);
+
+        va_end(args);
+        return ret;
+      }
+
+      int
+      output_warning (const char* fmt, ...)
+      {
+        std::va_list args;
+        va_start(args, fmt);
+
+        int ret = ops_->voutput_warning (ops_->user_data, fmt, args);
+
+        va_end(args);
+        return ret;
+      }
+
+      int
+      output_error (const char* fmt, ...)
+      {
+        std::va_list args;
+        va_start(args, fmt);
+
+        int ret = ops_->voutput_error (ops_->user_data, fmt, args);
+
+        va_end(args);
+        return ret;
+      }
+
+      /**
+       * @brief Tell the target endianness; little endian if the
+       * session does not provide a function.
+       */
+      inline bool
+      is_target_little_endian (void)
+      {
+        if (ops_->is_target_little_endian == nullptr)
+          {
+            return true;
+          }
+        return ops_->is_target_little_endian (ops_->user_data);
+      }
+
+      /**
+       * @brief Wait before reading the threads again; no delay if
+       * the session does not provide a function.
+       */
+      inline void
+      delay_us (uint32_t us)
+      {
+        if (ops_->delay_us != nullptr)
+          {
+            ops_->delay_us (ops_->user_data, us);
+          }
+      }
+
+      inline int
+      read_byte_array (target_addr_t addr, uint8_t* out_array,
+                       std::size_t bytes)
+      {
+        return ops_->read_byte_array (ops_->user_data, addr, out_array, bytes);
+      }
+
+      inline int
+      read_byte (target_addr_t addr, uint8_t* out_value)
+      {
+        return read_byte_array (addr, out_value, 1);
+      }
+
+      int
+      read_short (target_addr_t addr, uint16_t* out_value)
+      {
+        uint8_t buf[2];
+        int ret = read_byte_array (addr, &buf[0], sizeof(buf));
+        if (ret >= 0)
+          {
+            *out_value = load_short (&buf[0]);
+          }
+        return ret;
+      }
+
+      int
+      read_long (target_addr_t addr, uint32_t* out_value)
+      {
+        uint8_t buf[4];
+        int ret = read_byte_array (addr, &buf[0], sizeof(buf));
+        if (ret >= 0)
+          {
+            *out_value = load_long (&buf[0]);
+          }
+        return ret;
+      }
+
+      int
+      read_long_long (target_addr_t addr, uint64_t* out_value)
+      {
+        uint8_t buf[8];
+        int ret = read_byte_array (addr, &buf[0], sizeof(buf));
+        if (ret >= 0)
+          {
+            *out_value = load_long_long (&buf[0]);
+          }
+        return ret;
+      }
+
+      inline int
+      write_byte_array (target_addr_t addr, const uint8_t* array,
+                        std::size_t bytes)
+      {
+        return ops_->write_byte_array (ops_->user_data, addr, array, bytes);
+      }
+
+      void
+      write_byte (target_addr_t addr, uint8_t value)
+      {
+        write_byte_array (addr, &value, 1);
+      }
+
+      void
+      write_short (target_addr_t addr, uint16_t value)
+      {
+        uint8_t array[2];
+        store (&array[0], value, sizeof(array));
+        write_byte_array (addr, &array[0], sizeof(array));
+      }
+
+      void
+      write_long (target_addr_t addr, uint32_t value)
+      {
+        uint8_t array[4];
+        store (&array[0], value, sizeof(array));
+        write_byte_array (addr, &array[0], sizeof(array));
+      }
+
+      void
+      write_long_long (target_addr_t addr, uint64_t value)
+      {
+        uint8_t array[8];
+        store (&array[0], value, sizeof(array));
+        write_byte_array (addr, &array[0], sizeof(array));
+      }
+
+      inline uint16_t
+      load_short (const uint8_t* p)
+      {
+        return static_cast<uint16_t> (load (p, 2));
+      }
+
+      inline uint32_t
+      load_long (const uint8_t* p)
+      {
+        return static_cast<uint32_t> (load (p, 4));
+      }
+
+      inline uint64_t
+      load_long_long (const uint8_t* p)
+      {
+        return load (p, 8);
+      }
+
+    protected:
+
+      /**
+       * @brief Load a value from a buffer, according to the
+       * target endianness.
+       */
+      uint64_t
+      load (const uint8_t* p, std::size_t bytes)
+      {
+        bool is_le = is_target_little_endian ();
+        uint64_t val = 0;
+        for (std::size_t i = 0; i < bytes; ++i)
+          {
+            val <<= 8;
+            val |= p[is_le ? (bytes - 1 - i) : i];
+          }
+        return val;
+      }
+
+      /**
+       * @brief Store a value to a buffer, according to the
+       * target endianness.
+       */
+      void
+      store (uint8_t* p, uint64_t value, std::size_t bytes)
+      {
+        bool is_le = is_target_little_endian ();
+        for (std::size_t i = 0; i < bytes; ++i)
+          {
+            p[is_le ? i : (bytes - 1 - i)] =
+                static_cast<uint8_t> (value & 0xFF);
+            value >>= 8;
+          }
+      }
+
+    private:
+
+      const drtm_ops_t* ops_;
+    };
+
+    /**
+     * @brief A standard allocator that allocates memory via
+     * the session functions, or via `malloc()`/`free()` if the
+     * session does not provide them.
+     *
+     * @details
+     * The allocator is stateful, it keeps a pointer to the
+     * session functions.
+     *
+     * @tparam T type of allocator values
+     */
+    template<typename T>
+      class ops_allocator
+      {
+      public:
+
+        // Standard types.
+        using value_type = T;
+
+      public:
+
+        /**
+         * @brief Construct an allocator object instance.
+         */
+        ops_allocator (const drtm_ops_t* ops) noexcept :
+            ops_ (ops) // Parenthesis used to compile with 4.8
+        {
+#if defined(DEBUG)
+          printf ("%s(%p) @%p\n", __func__, ops, this);
+#endif /* defined(DEBUG) */
+        }
+
+        /**
+         * @brief Copy construct an allocator object instance.
+         */
+        ops_allocator (ops_allocator const & a) = default;
+
+        /**
+         * @brief Construct a sibling allocator object instance,
+         * for a different type.
+         */
+        template<typename U>
+          ops_allocator (ops_allocator<U> const & other) noexcept :
+              ops_ (other.ops ())
+          {
+            ;
+          }
+
+        /**
+         * @brief Assign an allocator object instance.
+         */
+        ops_allocator&
+        operator= (ops_allocator const & a) = default;
+
+        /**
+         * @brief Allocate a number of objects of the allocator type.
+         */
+        value_type*
+        allocate (std::size_t objects)
+        {
+          if (objects > max_size ())
+            {
+              throw std::system_error (
+                  std::error_code (EINVAL, std::system_category ()));
+            }
+
+          std::size_t bytes = objects * sizeof(value_type);
+          void* p;
+          if (ops_->malloc != nullptr)
+            {
+              p = ops_->malloc (ops_->user_data, bytes);
+            }
+          else
+            {
+              p = ::malloc (bytes);
+            }
+
+          if (p == nullptr)
+            {
+              throw std::system_error (
+                  std::error_code (ENOMEM, std::system_category ()));
+            }
+
+          return static_cast<value_type*> (p);
+        }
+
+        /**
+         * @brief Deallocate the number of objects.
+         */
+        void
+        deallocate (value_type* p, std::size_t objects) noexcept
+        {
+          assert(objects <= max_size ());
+          if (ops_->free != nullptr)
+            {
+              ops_->free (ops_->user_data, p);
+            }
+          else
+            {
+              ::free (p);
+            }
+        }
+
+        /**
+         * @brief Get the maximum number of objects that can be allocated.
+         */
+        std::size_t
+        max_size (void) const noexcept
+        {
+          return std::numeric_limits<std::size_t>::max () / sizeof(value_type);
+        }
+
+        inline const drtm_ops_t*
+        ops (void) const noexcept
+        {
+          return ops_;
+        }
+
+      private:
+
+        const drtm_ops_t* ops_;
+      };
+
+    template<typename T, typename U>
+      inline bool
+      operator== (const ops_allocator<T>& lhs, const ops_allocator<U>& rhs)
+      {
+        return lhs.ops () == rhs.ops ();
+      }
+
+    template<typename T, typename U>
+      inline bool
+      operator!= (const ops_allocator<T>& lhs, const ops_allocator<U>& rhs)
+      {
+        return lhs.ops () != rhs.ops ();
+      }
+
+#pragma GCC diagnostic pop
+
+  // ==========================================================================
+  } /* namespace drtm */
+} /* namespace your_namespace */
+
+#endif /* defined(__cplusplus) */
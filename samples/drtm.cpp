@@ -31,6 +31,7 @@
 
 #include <drtm-backend.h>
 #include <drtm-memory.h>
+#include <drtm-ops.h>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
@@ -75,130 +76,375 @@ template class drtm::frontend<backend_type, backend_allocator_type>;
 // Define a type alias.
 using frontend_type = class drtm::frontend<backend_type, backend_allocator_type>;
 
+// ---------------------------------------------------------------------------
+// Templates for the handle based API.
+
+// Template explicit instantiation.
+template class your_namespace::drtm::ops_allocator<void*>;
+// Define a type alias.
+using ops_allocator_type = class your_namespace::drtm::ops_allocator<void*>;
+
+// Define a type alias.
+using ops_backend_type = class your_namespace::drtm::ops_backend;
+
+// Template explicit instantiation.
+template class drtm::frontend<ops_backend_type, ops_allocator_type>;
+// Define a type alias.
+using ops_frontend_type = class drtm::frontend<ops_backend_type, ops_allocator_type>;
+
 #pragma GCC diagnostic pop
 
 // ---------------------------------------------------------------------------
-// The C API.
+// The handle based C API.
 
-static struct
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+/**
+ * A session, with its own allocator, backend and frontend; sessions
+ * share no state, so they can be used from different host threads.
+ */
+struct drtm_context_s
+{
+  drtm_context_s (const drtm_ops_t* ops) :
+      allocator
+        { ops }, //
+      backend
+        { ops }, //
+      frontend
+        { backend, allocator }
+  {
+  }
+
+  ops_allocator_type allocator;
+  ops_backend_type backend;
+  ops_frontend_type frontend;
+};
+
+#pragma GCC diagnostic pop
+
+drtm_context_t*
+drtm_create (const drtm_ops_t* ops)
 {
-  backend_allocator_type* allocator;
-  backend_type* backend;
+  assert(ops != nullptr);
+
+  // Allocate space for the session, with the session allocator.
+  void* p;
+  if (ops->malloc != nullptr)
+    {
+      p = ops->malloc (ops->user_data, sizeof(drtm_context_t));
+    }
+  else
+    {
+      p = malloc (sizeof(drtm_context_t));
+    }
+
+  if (p == nullptr)
+    {
+      return nullptr;
+    }
+
+  // Construct the already allocated session object instance.
+  return new (p) drtm_context_t
+    { ops };
+}
 
-  frontend_type* frontend;
-} drtm_;
+void
+drtm_destroy (drtm_context_t* ctx)
+{
+  if (ctx == nullptr)
+    {
+      return;
+    }
+
+  const drtm_ops_t* ops = ctx->allocator.ops ();
+  ctx->~drtm_context_t ();
+
+  if (ops->free != nullptr)
+    {
+      ops->free (ops->user_data, ctx);
+    }
+  else
+    {
+      free (ctx);
+    }
+}
 
 int
-drtm_init (void)
+drtm_ctx_update_thread_list (drtm_context_t* ctx)
 {
-  // Allocate space for the DRTM allocator object instance.
-  drtm_.allocator = reinterpret_cast<backend_allocator_type*> (yapp_malloc (
-      sizeof(backend_allocator_type)));
+  assert(ctx != nullptr);
+  return ctx->frontend.update_thread_list ();
+}
 
-  // Construct the already allocated DRTM allocator object instance.
-  new (drtm_.allocator) backend_allocator_type
-    { };
+size_t
+drtm_ctx_get_threads_count (drtm_context_t* ctx)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_threads_count ();
+}
 
+drtm_thread_id_t
+drtm_ctx_get_thread_id (drtm_context_t* ctx, size_t index)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_thread_id (index);
+}
+
+drtm_thread_id_t
+drtm_ctx_get_current_thread_id (drtm_context_t* ctx)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_current_thread_id ();
+}
+
+size_t
+drtm_ctx_get_cores_count (drtm_context_t* ctx)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_cores_count ();
+}
+
+drtm_thread_id_t
+drtm_ctx_get_core_current_thread_id (drtm_context_t* ctx, size_t core)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_current_thread_id (core);
+}
+
+size_t
+drtm_ctx_get_thread_description (drtm_context_t* ctx, drtm_thread_id_t tid,
+                                 char* out_description, size_t out_size_bytes)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_thread_description (tid, out_description,
+                                               out_size_bytes);
+}
+
+int
+drtm_ctx_get_thread_register (drtm_context_t* ctx, drtm_thread_id_t tid,
+                              size_t reg_index, char* out_hex_value,
+                              size_t out_size_bytes)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_thread_register (tid, reg_index, out_hex_value,
+                                            out_size_bytes);
+}
+
+int
+drtm_ctx_get_thread_registers (drtm_context_t* ctx, drtm_thread_id_t tid,
+                               char* out_hex_values, size_t out_size_bytes)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.get_thread_registers (tid, out_hex_values,
+                                             out_size_bytes);
+}
+
+int
+drtm_ctx_set_thread_register (drtm_context_t* ctx, drtm_thread_id_t tid,
+                              size_t reg_index, const char* hex_value)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.set_thread_register (tid, reg_index, hex_value);
+}
+
+int
+drtm_ctx_set_thread_registers (drtm_context_t* ctx, drtm_thread_id_t tid,
+                               const char* hex_values)
+{
+  assert(ctx != nullptr);
+  return ctx->frontend.set_thread_registers (tid, hex_values);
+}
+
+// ---------------------------------------------------------------------------
+// The global C API, on top of a default session, which forwards
+// the calls to the <your application> backend.
+
+namespace
+{
+  backend_type*
+  yapp_backend (void* user_data)
+  {
+    return static_cast<backend_type*> (user_data);
+  }
+
+  drtm_target_addr_t
+  yapp_ops_get_symbol_address (void* user_data, const char* name)
+  {
+    return yapp_backend (user_data)->get_symbol_address (name);
+  }
+
+  int
+  yapp_ops_read_byte_array (void* user_data, drtm_target_addr_t addr,
+                            uint8_t* out_array, size_t bytes)
+  {
+    return yapp_backend (user_data)->read_byte_array (addr, out_array, bytes);
+  }
+
+  int
+  yapp_ops_write_byte_array (void* user_data, drtm_target_addr_t addr,
+                             const uint8_t* array, size_t bytes)
+  {
+    return yapp_backend (user_data)->write_byte_array (addr, array, bytes);
+  }
+
+  int
+  yapp_ops_voutput (void* user_data, const char* fmt, va_list args)
+  {
+    return yapp_backend (user_data)->voutput (fmt, args);
+  }
+
+  int
+  yapp_ops_voutput_warning (void* user_data, const char* fmt, va_list args)
+  {
+    return yapp_backend (user_data)->voutput_warning (fmt, args);
+  }
+
+  int
+  yapp_ops_voutput_error (void* user_data, const char* fmt, va_list args)
+  {
+    return yapp_backend (user_data)->voutput_error (fmt, args);
+  }
+
+  bool
+  yapp_ops_is_target_little_endian (void* user_data)
+  {
+    return yapp_backend (user_data)->is_target_little_endian ();
+  }
+
+  void*
+  yapp_ops_malloc (void* user_data __attribute__((unused)), size_t bytes)
+  {
+    return yapp_malloc (bytes);
+  }
+
+  void
+  yapp_ops_free (void* user_data __attribute__((unused)), void* p)
+  {
+    yapp_free (p);
+  }
+
+  drtm_ops_t default_ops_ =
+    {
+    //
+        .user_data = nullptr, //
+        .get_symbol_address = yapp_ops_get_symbol_address, //
+        .read_byte_array = yapp_ops_read_byte_array, //
+        .write_byte_array = yapp_ops_write_byte_array, //
+        .voutput = yapp_ops_voutput, //
+        .voutput_warning = yapp_ops_voutput_warning, //
+        .voutput_error = yapp_ops_voutput_error, //
+        .is_target_little_endian = yapp_ops_is_target_little_endian, //
+        .malloc = yapp_ops_malloc, //
+        .free = yapp_ops_free, //
+        .delay_us = nullptr, //
+    /**/
+    };
+
+  drtm_context_t* default_context_;
+}
+
+int
+drtm_init (void)
+{
   // Allocate space for the DRTM backend object instance.
-  drtm_.backend = reinterpret_cast<backend_type*> (yapp_malloc (
+  backend_type* backend = reinterpret_cast<backend_type*> (yapp_malloc (
       sizeof(backend_type)));
 
   // Construct the already allocated DRTM backend object instance.
-  new (drtm_.backend) backend_type
+  new (backend) backend_type
     { yapp_symbols };
 
-  // Allocate space for the DRTM frontend object instance.
-  drtm_.frontend = reinterpret_cast<frontend_type*> (yapp_malloc (
-      sizeof(frontend_type)));
-
-  // Construct the already allocated DRTM frontend object instance.
-  new (drtm_.frontend) frontend_type
-    { *drtm_.backend, *drtm_.allocator };
+  default_ops_.user_data = backend;
+  default_context_ = drtm_create (&default_ops_);
 
-  return 0;
+  return (default_context_ != nullptr) ? 0 : -1;
 }
 
 void
 drtm_shutdown (void)
 {
-  drtm_.frontend->~frontend_type ();
-  yapp_free (drtm_.frontend);
+  drtm_destroy (default_context_);
+  default_context_ = nullptr;
 
-  drtm_.backend->~backend_type ();
-  yapp_free (drtm_.backend);
-
-  drtm_.allocator->~backend_allocator_type ();
-  yapp_free (drtm_.allocator);
+  backend_type* backend = yapp_backend (default_ops_.user_data);
+  backend->~backend_type ();
+  yapp_free (backend);
+  default_ops_.user_data = nullptr;
 }
 
 int
 drtm_update_thread_list (void)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->update_thread_list ();
+  return drtm_ctx_update_thread_list (default_context_);
 }
 
 size_t
 drtm_get_threads_count (void)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_threads_count ();
+  return drtm_ctx_get_threads_count (default_context_);
 }
 
 drtm_thread_id_t
 drtm_get_thread_id (size_t index)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_thread_id (index);
+  return drtm_ctx_get_thread_id (default_context_, index);
 }
 
 drtm_thread_id_t
 drtm_get_current_thread_id (void)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_current_thread_id ();
+  return drtm_ctx_get_current_thread_id (default_context_);
+}
+
+size_t
+drtm_get_cores_count (void)
+{
+  return drtm_ctx_get_cores_count (default_context_);
+}
+
+drtm_thread_id_t
+drtm_get_core_current_thread_id (size_t core)
+{
+  return drtm_ctx_get_core_current_thread_id (default_context_, core);
 }
 
 size_t
 drtm_get_thread_description (drtm_thread_id_t tid, char* out_description,
                              size_t out_size_bytes)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_thread_description (tid, out_description,
-                                                 out_size_bytes);
+  return drtm_ctx_get_thread_description (default_context_, tid,
+                                          out_description, out_size_bytes);
 }
 
 int
 drtm_get_thread_register (drtm_thread_id_t tid, size_t reg_index,
                           char* out_hex_value, size_t out_size_bytes)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_thread_register (tid, reg_index, out_hex_value,
-                                              out_size_bytes);
+  return drtm_ctx_get_thread_register (default_context_, tid, reg_index,
+                                       out_hex_value, out_size_bytes);
 }
 
 int
 drtm_get_thread_registers (drtm_thread_id_t tid, char* out_hex_values,
                            size_t out_size_bytes)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->get_thread_registers (tid, out_hex_values,
-                                               out_size_bytes);
+  return drtm_ctx_get_thread_registers (default_context_, tid, out_hex_values,
+                                        out_size_bytes);
 }
 
 int
 drtm_set_thread_register (drtm_thread_id_t tid, size_t reg_index,
                           const char* hex_value)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->set_thread_register (tid, reg_index, hex_value);
+  return drtm_ctx_set_thread_register (default_context_, tid, reg_index,
+                                       hex_value);
 }
 
 int
 drtm_set_thread_registers (drtm_thread_id_t tid, const char* hex_values)
 {
-  assert(drtm_.frontend != nullptr);
-  return drtm_.frontend->set_thread_registers (tid, hex_values);
+  return drtm_ctx_set_thread_registers (default_context_, tid, hex_values);
 }
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the multi-core targets, with one current thread per core.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  void
+  check_cores (void)
+  {
+    build_os ();
+    set_header_version (1, 0);
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    uint32_t idle = add_thread ("idle", 0, 2, 1, 1, false);
+    uint32_t other = add_thread ("other", 0, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    allocator_type allocator;
+
+    // Before v1.1, a single core.
+    {
+      backend be;
+      frontend_type fe
+        { be, allocator };
+      check (fe.update_thread_list () == 0, "single core update");
+      check (fe.get_cores_count () == 1, "single core count");
+      check (fe.get_current_thread_id (0) == (main_thread >> 2),
+             "single core current thread");
+    }
+
+    set_header_version (1, 1);
+    uint32_t current_threads = ram_alloc (2 * 4);
+    ram_write_long (current_threads, main_thread);
+    ram_write_long (current_threads + 4, idle);
+    header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREADS_ADDR,
+                       current_threads);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 2);
+
+    backend be;
+    frontend_type fe
+      { be, allocator };
+    check (fe.update_thread_list () == 0, "cores update");
+    check (fe.get_cores_count () == 2, "cores count");
+    check (fe.get_current_thread_id () == (main_thread >> 2),
+           "current thread of the first core");
+    check (fe.get_current_thread_id (0) == (main_thread >> 2),
+           "core 0 current thread");
+    check (fe.get_current_thread_id (1) == (idle >> 2),
+           "core 1 current thread");
+    check (fe.get_current_thread_id (2) == 0, "no core 2");
+
+    // The registers of the running threads are in the cores.
+    char registers[256];
+    check (fe.get_thread_registers (idle >> 2, registers, sizeof(registers))
+               < 0,
+           "registers of a running thread");
+    check (fe.get_thread_registers (other >> 2, registers, sizeof(registers))
+               == 0,
+           "registers of a stacked thread");
+
+    // A change of the current threads is seen at the next update.
+    ram_write_long (current_threads + 4, other);
+    check (fe.get_current_thread_id (1) == (idle >> 2),
+           "core 1 current thread kept");
+    check (fe.update_thread_list () == 0, "cores update again");
+    check (fe.get_current_thread_id (1) == (other >> 2),
+           "core 1 new current thread");
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the driver, updating several sessions on the same
+ * simulated target, in parallel.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <drtm/driver.h>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  void
+  check_driver (void)
+  {
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    uint32_t worker = add_thread ("worker", 0, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    constexpr std::size_t sessions_count = 5;
+
+    allocator_type allocator;
+    backend backends[sessions_count];
+    frontend_type* sessions[sessions_count];
+    for (std::size_t i = 0; i < sessions_count; ++i)
+      {
+        sessions[i] = new frontend_type
+          { backends[i], allocator };
+      }
+
+    using driver_type = drtm::driver<frontend_type>;
+    driver_type::result_type results[sessions_count];
+    {
+      driver_type driver
+        { 2, allocator };
+      check (driver.workers_count () == 2, "driver workers");
+
+      driver.update (sessions, sessions_count, results);
+      for (std::size_t i = 0; i < sessions_count; ++i)
+        {
+          check (results[i].status == 0 && results[i].worker < 2,
+                 "driver result");
+          check (backends[i].reads > 0, "driver session reads");
+          check (sessions[i]->get_threads_count () == 2,
+                 "driver threads count");
+        }
+
+      // The next batch sees the changes of the target.
+      add_thread ("child", worker, 3, 10, 10, false);
+      driver.update (sessions, sessions_count, nullptr);
+      for (std::size_t i = 0; i < sessions_count; ++i)
+        {
+          check (sessions[i]->get_threads_count () == 3,
+                 "driver next threads count");
+        }
+
+      // An empty batch returns at once.
+      check (driver.update (sessions, 0, results).count () == 0,
+             "driver empty batch");
+    }
+
+    for (std::size_t i = 0; i < sessions_count; ++i)
+      {
+        delete sessions[i];
+      }
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,244 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the metadata computed from the DWARF debug information,
+ * on the types of this executable, which mirror the simulated
+ * thread control block.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+#include <cstddef>
+
+#if defined(__ELF__)
+#include <drtm/dwarf-metadata.h>
+#endif /* defined(__ELF__) */
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace types
+  {
+    // The host types, with the layout of the simulated target;
+    // the pointers are 32-bits words.
+    struct list_links
+    {
+      uint32_t prev;
+      uint32_t next;
+    };
+
+    struct list
+    {
+      list_links head;
+    };
+
+    struct context
+    {
+      uint32_t stack_ptr;
+    };
+
+    struct thread
+    {
+      uint32_t reserved[2];
+      uint32_t name;
+      uint32_t reserved_name;
+      uint32_t parent;
+      list_links child_links;
+      list children;
+      uint8_t state;
+      uint8_t reserved_state[3];
+      context ctx;
+      uint8_t prio_assigned;
+      uint8_t prio_inherited;
+      uint8_t reserved_prio[18];
+    };
+
+    static_assert(offsetof(thread, name) == tcb_name_offset, "name");
+    static_assert(offsetof(thread, parent) == tcb_parent_offset, "parent");
+    static_assert(offsetof(thread, child_links) == tcb_list_node_offset,
+        "list node");
+    static_assert(offsetof(thread, children) == tcb_children_node_offset,
+        "children");
+    static_assert(offsetof(thread, state) == tcb_state_offset, "state");
+    static_assert(offsetof(thread, ctx) == tcb_stack_offset, "stack");
+    static_assert(offsetof(thread, prio_assigned) == tcb_prio_assigned_offset,
+        "prio assigned");
+    static_assert(offsetof(thread, prio_inherited)
+        == tcb_prio_inherited_offset, "prio inherited");
+    static_assert(sizeof(thread) == tcb_size_bytes, "size");
+
+    // Instances, so the types are in the debug information.
+    thread a_thread;
+    list a_list;
+  } /* namespace types */
+} /* namespace sim */
+
+// The scheduler variables, with plain names.
+extern "C"
+{
+  bool sim_scheduler_is_started;
+  sim::types::list sim_scheduler_top_threads_list;
+  sim::types::thread* sim_scheduler_current_thread;
+}
+
+namespace sim
+{
+#if defined(__ELF__)
+
+  namespace
+  {
+    const drtm::dwarf_names_t names =
+      {
+      //
+          .thread_type = "sim::types::thread", //
+          .thread_name = "name", //
+          .thread_parent = "parent", //
+          .thread_list_node = "child_links", //
+          .thread_children_node = "children", //
+          .thread_state = "state", //
+          .thread_stack = "ctx.stack_ptr", //
+          .thread_prio_assigned = "prio_assigned", //
+          .thread_prio_inherited = "prio_inherited", //
+
+          .list_links_type = "sim::types::list_links", //
+          .list_links_prev = "prev", //
+          .list_links_next = "next", //
+
+          .scheduler_is_started_symbol = "sim_scheduler_is_started", //
+          .scheduler_top_threads_list_symbol =
+              "sim_scheduler_top_threads_list", //
+          .scheduler_current_thread_symbol = "sim_scheduler_current_thread", //
+      /**/
+      };
+  }
+
+  void
+  check_dwarf (const char* path)
+  {
+    allocator_type allocator;
+    drtm::elf_symbols<allocator_type> elf
+      { allocator };
+    if (!elf.open (path))
+      {
+        // Not a path, like when started via PATH.
+        check (elf.open ("/proc/self/exe"), "dwarf executable open");
+      }
+
+    drtm::dwarf_metadata<allocator_type> dwarf
+      { allocator };
+    drtm::offline_metadata_t om;
+    if (!dwarf.compute (elf, names, &om))
+      {
+        // Like when built without debug information.
+        check (false, "dwarf compute");
+        return;
+      }
+
+    check (om.thread_name_offset == tcb_name_offset, "dwarf name offset");
+    check (om.thread_parent_offset == tcb_parent_offset,
+           "dwarf parent offset");
+    check (om.thread_list_node_offset == tcb_list_node_offset,
+           "dwarf list node offset");
+    check (om.thread_children_node_offset == tcb_children_node_offset,
+           "dwarf children offset");
+    check (om.thread_state_offset == tcb_state_offset, "dwarf state offset");
+    // Via a nested member.
+    check (om.thread_stack_offset == tcb_stack_offset, "dwarf stack offset");
+    check (om.thread_prio_assigned_offset == tcb_prio_assigned_offset,
+           "dwarf prio assigned offset");
+    check (om.thread_prio_inherited_offset == tcb_prio_inherited_offset,
+           "dwarf prio inherited offset");
+    check (om.list_links_prev_offset == 0 && om.list_links_next_offset == 4,
+           "dwarf list links offsets");
+    // The executable may be relocated; check only the distance.
+    uint64_t distance = reinterpret_cast<uintptr_t> (
+        &sim_scheduler_current_thread)
+        - reinterpret_cast<uintptr_t> (&sim_scheduler_is_started);
+    check (elf.is_mapped (om.scheduler_current_thread_addr, 4)
+               && om.scheduler_current_thread_addr
+                   - om.scheduler_is_started_addr == distance,
+           "dwarf scheduler symbols");
+
+    // Some names not in the debug information.
+    drtm::dwarf_names_t wrong_names = names;
+    wrong_names.thread_state = "missing";
+    drtm::offline_metadata_t wrong_om;
+    check (!dwarf.compute (elf, wrong_names, &wrong_om),
+           "dwarf missing member");
+
+    // The offsets, with the addresses of the simulated target,
+    // replace the header, which is no longer needed.
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    uint32_t thread = add_thread ("thread", 0, 3, 10, 10, false);
+    add_thread ("child", thread, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    backend header_be;
+    frontend_type header_fe
+      { header_be, allocator };
+    check (header_fe.update_thread_list () == 0, "header update");
+
+    std::memset (ram_ptr (drtm_addr), 0, 0x80);
+    om.scheduler_is_started_addr = is_started_addr;
+    om.scheduler_top_threads_list_addr = top_threads_list_addr;
+    om.scheduler_current_thread_addr = current_thread_addr;
+
+    backend be;
+    frontend_type fe
+      { be, allocator };
+    fe.use_offline_metadata (&om);
+    check (fe.update_thread_list () == 0, "dwarf update");
+    check (be.header_reads == 0, "dwarf update without the header");
+    check (fe.get_threads_count () == header_fe.get_threads_count (),
+           "dwarf threads count");
+    for (std::size_t i = 0; i < fe.get_threads_count (); ++i)
+      {
+        check (fe.get_thread_id (i) == header_fe.get_thread_id (i),
+               "dwarf thread id");
+      }
+  }
+
+#else
+
+  void
+  check_dwarf (const char* path __attribute__((unused)))
+  {
+    // The DWARF reader needs an ELF executable.
+  }
+
+#endif /* defined(__ELF__) */
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,214 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Check that the run-time data, instantiated with the offsets
+ * known at compile time (`static_metadata`), produces the same
+ * results as when instantiated with the offsets parsed from the
+ * target header (`metadata`).
+ *
+ * The target is simulated in memory, with a µOS++ like tree of
+ * threads (`target.h`); the other features are checked on the
+ * same target, one group in each source file.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+
+using namespace sim;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  /**
+   * The layout descriptor, with the same offsets as those
+   * written in the simulated header.
+   */
+  struct layout
+  {
+    static constexpr drtm::target_offset_t thread_name_offset =
+        tcb_name_offset;
+    static constexpr drtm::target_offset_t thread_parent_offset =
+        tcb_parent_offset;
+    static constexpr drtm::target_offset_t thread_list_node_offset =
+        tcb_list_node_offset;
+    static constexpr drtm::target_offset_t thread_children_node_offset =
+        tcb_children_node_offset;
+    static constexpr drtm::target_offset_t thread_state_offset =
+        tcb_state_offset;
+    static constexpr drtm::target_offset_t thread_stack_offset =
+        tcb_stack_offset;
+    static constexpr drtm::target_offset_t thread_prio_assigned_offset =
+        tcb_prio_assigned_offset;
+    static constexpr drtm::target_offset_t thread_prio_inherited_offset =
+        tcb_prio_inherited_offset;
+    static constexpr drtm::target_offset_t thread_stack_selector_offset_words =
+        0;
+
+    static constexpr drtm::target_offset_t list_links_prev_offset = 0;
+    static constexpr drtm::target_offset_t list_links_next_offset = 4;
+
+    static constexpr const char* scheduler_is_started_symbol =
+        "scheduler_is_started";
+    static constexpr const char* scheduler_top_threads_list_symbol =
+        "scheduler_top_threads_list";
+    static constexpr const char* scheduler_current_thread_symbol =
+        "scheduler_current_thread";
+  };
+
+  constexpr const char* layout::scheduler_is_started_symbol;
+  constexpr const char* layout::scheduler_top_threads_list_symbol;
+  constexpr const char* layout::scheduler_current_thread_symbol;
+
+  using dynamic_frontend_type = drtm::frontend<backend, allocator_type>;
+
+  using static_metadata_type = drtm::static_metadata<backend, layout>;
+  using static_frontend_type = drtm::frontend<backend, allocator_type,
+  drtm::default_frame_type, static_metadata_type>;
+
+  // The offsets are constant expressions.
+  static_assert(static_metadata_type::thread_s::stack_offset == tcb_stack_offset,
+      "Offsets must be known at compile time");
+  static_assert(static_metadata_type::list_links_s::next_offset == 4,
+      "Offsets must be known at compile time");
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * Update both and compare everything the GDB server may ask for.
+   */
+  void
+  compare (dynamic_frontend_type& dfe, static_frontend_type& sfe)
+  {
+    check (dfe.update_thread_list () == 0, "dynamic update");
+    check (sfe.update_thread_list () == 0, "static update");
+
+    std::size_t count = dfe.get_threads_count ();
+    check (count == sfe.get_threads_count (), "threads count");
+    check (dfe.get_current_thread_id () == sfe.get_current_thread_id (),
+           "current thread");
+
+    char dbuf[512];
+    char sbuf[512];
+
+    for (std::size_t i = 0; i < count; ++i)
+      {
+        auto tid = dfe.get_thread_id (i);
+        check (tid == sfe.get_thread_id (i), "thread id");
+
+        check (
+            dfe.get_thread_description (tid, dbuf, sizeof(dbuf))
+                == sfe.get_thread_description (tid, sbuf, sizeof(sbuf)),
+            "description result");
+        check (std::strcmp (dbuf, sbuf) == 0, "description");
+
+        check (
+            dfe.get_thread_registers (tid, dbuf, sizeof(dbuf))
+                == sfe.get_thread_registers (tid, sbuf, sizeof(sbuf)),
+            "registers result");
+        check (std::strcmp (dbuf, sbuf) == 0, "registers");
+
+        for (std::size_t r = 0; r < 56; ++r)
+          {
+            int dret = dfe.get_thread_register (tid, r, dbuf, sizeof(dbuf));
+            int sret = sfe.get_thread_register (tid, r, sbuf, sizeof(sbuf));
+            check (dret == sret, "register result");
+            check (dret != 0 || std::strcmp (dbuf, sbuf) == 0, "register");
+          }
+      }
+  }
+
+  void
+  check_layout (void)
+  {
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    add_thread ("idle", 0, 1, 1, 1, false);
+    uint32_t child = add_thread ("child", main_thread, 3, 100, 120, true);
+    add_thread ("grandchild", child, 1, 50, 50, false);
+    add_thread ("sibling", main_thread, 4, 10, 10, true);
+    ram_write_long (current_thread_addr, main_thread);
+
+    allocator_type allocator;
+
+    backend dynamic_backend;
+    dynamic_frontend_type dfe
+      { dynamic_backend, allocator };
+
+    backend static_backend;
+    static_frontend_type sfe
+      { static_backend, allocator };
+
+    compare (dfe, sfe);
+    check (dfe.get_threads_count () == 5, "all threads found");
+
+    // Change the state and the current thread, and compare again.
+    *ram_ptr (main_thread + tcb_state_offset) = 3;
+    *ram_ptr (child + tcb_state_offset) = 2;
+    ram_write_long (current_thread_addr, child);
+    compare (dfe, sfe);
+
+    // The static path does not read the header.
+    check (static_backend.reads < dynamic_backend.reads, "fewer reads");
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+int
+main (int argc __attribute__((unused)), char* argv[])
+{
+  printf ("DRTM library, compile-time layout test\n");
+
+  check_layout ();
+  check_registers ();
+  check_output ();
+  check_metadata ();
+  check_symbols ();
+  check_dwarf (argv[0]);
+  check_cores ();
+  check_snapshots ();
+  check_poller ();
+  check_driver ();
+  check_memory ();
+  check_updates ();
+
+  if (errors != 0)
+    {
+      printf ("%d errors.\n", errors);
+      return 1;
+    }
+
+  printf ("Done.\n");
+  return 0;
+}
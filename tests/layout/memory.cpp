@@ -0,0 +1,358 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the memory resources, and a front end using them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "target.h"
+
+#include <drtm/memory.h>
+
+#include <cstdint>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    /**
+     * An upstream resource that counts the requests, and
+     * may be exhausted.
+     */
+    class upstream_resource : public drtm::memory_resource
+    {
+    public:
+
+      bool is_exhausted = false;
+      unsigned int allocations = 0;
+      unsigned int deallocations = 0;
+
+    protected:
+
+      virtual void*
+      do_allocate (std::size_t bytes,
+                   std::size_t align __attribute__((unused))) override
+      {
+        if (is_exhausted)
+          {
+            return nullptr;
+          }
+        ++allocations;
+        return malloc (bytes);
+      }
+
+      virtual void
+      do_deallocate (void* p, std::size_t bytes __attribute__((unused)),
+                     std::size_t align __attribute__((unused))) override
+      {
+        ++deallocations;
+        free (p);
+      }
+
+      virtual bool
+      do_is_equal (memory_resource const & other) const noexcept override
+      {
+        return this == &other;
+      }
+    };
+
+    using polymorphic_allocator_type = drtm::polymorphic_allocator<void*>;
+    using polymorphic_frontend_type = drtm::frontend<backend,
+    polymorphic_allocator_type>;
+
+    /**
+     * The monotonic resource grows the chunks geometrically, and
+     * reuses them after a reset; the pool reuses the blocks; both
+     * return nullptr when the upstream is exhausted.
+     */
+    void
+    check_resources (void)
+    {
+      upstream_resource upstream;
+
+      {
+        alignas(8) char buffer[64];
+        drtm::monotonic_buffer_resource monotonic
+          { buffer, sizeof(buffer), &upstream };
+
+        for (int i = 0; i < 100; ++i)
+          {
+            void* p = monotonic.allocate (24, 8);
+            check (
+                p != nullptr && reinterpret_cast<uintptr_t> (p) % 8 == 0,
+                "monotonic allocation");
+          }
+        unsigned int chunks = upstream.allocations;
+        check (chunks > 0 && chunks < 10, "monotonic chunks");
+
+        monotonic.reset ();
+        for (int i = 0; i < 100; ++i)
+          {
+            monotonic.allocate (24, 8);
+          }
+        check (upstream.allocations == chunks, "monotonic chunks reused");
+
+        // Past the kept chunks, with the upstream exhausted.
+        upstream.is_exhausted = true;
+        void* p = nullptr;
+        for (int i = 0; i < 1000 && (p = monotonic.allocate (24, 8)); ++i)
+          {
+            ;
+          }
+        check (p == nullptr, "monotonic upstream exhausted");
+        check (monotonic.statistics ().failed_allocations_count == 1,
+               "monotonic failed allocation");
+        upstream.is_exhausted = false;
+
+        monotonic.release ();
+        check (upstream.deallocations == upstream.allocations,
+               "monotonic chunks released");
+      }
+
+      {
+        drtm::pool_resource pool
+          { 24, 4, &upstream };
+        check (pool.block_size_bytes () % alignof(max_align_t) == 0,
+               "pool block size");
+
+        unsigned int allocations = upstream.allocations;
+        void* blocks[10];
+        for (void*& b : blocks)
+          {
+            b = pool.allocate (24);
+          }
+        check (upstream.allocations == allocations + 3, "pool chunks");
+
+        for (void* b : blocks)
+          {
+            pool.deallocate (b, 24);
+          }
+        for (void*& b : blocks)
+          {
+            b = pool.allocate (16);
+          }
+        check (upstream.allocations == allocations + 3, "pool blocks reused");
+
+        // The larger requests go to the upstream.
+        void* large = pool.allocate (100);
+        check (upstream.allocations == allocations + 4, "pool large request");
+        pool.deallocate (large, 100);
+
+        // The 3 chunks are kept, with 12 blocks.
+        pool.reset ();
+        upstream.is_exhausted = true;
+        int count = 0;
+        while (pool.allocate (24) != nullptr && count < 100)
+          {
+            ++count;
+          }
+        check (count == 12, "pool blocks after reset");
+        check (pool.statistics ().failed_allocations_count == 1,
+               "pool upstream exhausted");
+        upstream.is_exhausted = false;
+      }
+      check (upstream.deallocations == upstream.allocations,
+             "pool chunks released");
+
+      // A front end with the threads in a pool.
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      for (int i = 0; i < 10; ++i)
+        {
+          add_thread ("thread", main_thread, 3, 10, 10, (i & 1) != 0);
+        }
+      ram_write_long (current_thread_addr, main_thread);
+
+      {
+        drtm::pool_resource pool
+          { sizeof(polymorphic_frontend_type::thread_type), 4, &upstream };
+        polymorphic_allocator_type allocator
+          { &pool };
+        backend be;
+        polymorphic_frontend_type fe
+          { be, allocator };
+
+        // Once both snapshots are built, the threads are reused.
+        check (fe.update_thread_list () == 0, "pool update");
+        check (fe.update_thread_list () == 0, "pool update again");
+        unsigned int allocations = upstream.allocations;
+        check (fe.update_thread_list () == 0, "pool update third");
+        check (fe.get_threads_count () == 11, "pool threads count");
+        check (upstream.allocations == allocations,
+               "pool update without upstream allocations");
+      }
+      check (upstream.deallocations == upstream.allocations,
+             "pool front end released");
+    }
+
+    /**
+     * The statistics of a session are those of its resource; the
+     * histogram has one entry for each allocation.
+     */
+    void
+    check_statistics (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("worker", main_thread, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      backend be;
+
+      // Without a resource, there are no statistics.
+      allocator_type std_allocator;
+      frontend_type std_fe
+        { be, std_allocator };
+      check (std_fe.get_memory_statistics () == nullptr,
+             "no statistics with std::allocator");
+
+      upstream_resource upstream;
+      {
+        drtm::monotonic_buffer_resource monotonic
+          { 1024, &upstream };
+        polymorphic_allocator_type allocator
+          { &monotonic };
+        polymorphic_frontend_type fe
+          { be, allocator };
+
+        const drtm::memory_statistics_t* st = fe.get_memory_statistics ();
+        check (st == &monotonic.statistics (), "session statistics");
+
+        check (fe.update_thread_list () == 0, "statistics update");
+        check (st->allocations_count > 0, "statistics allocations");
+        check (st->current_bytes > 0 && st->peak_bytes >= st->current_bytes,
+               "statistics bytes");
+        check (st->failed_allocations_count == 0, "statistics no failures");
+
+        std::size_t histogram = 0;
+        for (std::size_t i = 0; i < drtm::memory_resource::size_classes; ++i)
+          {
+            histogram += st->size_classes[i];
+          }
+        check (histogram == st->allocations_count, "statistics histogram");
+
+        // The classes are powers of two, from 16 bytes.
+        check (drtm::memory_resource::size_class (16) == 0
+                   && drtm::memory_resource::size_class (17) == 1
+                   && drtm::memory_resource::size_class (0x100000)
+                       == drtm::memory_resource::size_classes - 1,
+               "statistics size classes");
+
+        std::size_t current_bytes = st->current_bytes;
+        monotonic.reset_statistics ();
+        check (st->allocations_count == 0 && st->deallocations_count == 0
+                   && st->current_bytes == current_bytes
+                   && st->peak_bytes == current_bytes,
+               "statistics reset");
+
+        // The upstream has its own statistics, for the chunks.
+        check (upstream.statistics ().allocations_count == upstream.allocations,
+               "upstream statistics");
+      }
+      check (upstream.statistics ().current_bytes == 0,
+             "upstream statistics released");
+    }
+
+    /**
+     * With the fixed capacity allocator, the extra threads are not
+     * shown and the names are truncated; the threads shown are the
+     * same as with a dynamic allocator.
+     */
+    void
+    check_fixed_capacity (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main-thread-with-a-long-name", 0, 2,
+                                         127, 127, false);
+      for (int i = 0; i < 5; ++i)
+        {
+          add_thread ("thread", main_thread, 3, 10, 10, (i & 1) != 0);
+        }
+      ram_write_long (current_thread_addr, main_thread);
+
+      using fixed_allocator_type = drtm::fixed_capacity_allocator<4, 16>;
+      using fixed_frontend_type = drtm::frontend<backend, fixed_allocator_type>;
+
+      fixed_allocator_type fixed_allocator;
+      backend fixed_be;
+      fixed_frontend_type fixed_fe
+        { fixed_be, fixed_allocator };
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (fixed_fe.update_thread_list () == 0, "fixed update");
+      check (fe.update_thread_list () == 0, "dynamic update");
+      check (fixed_fe.get_threads_count () == 4, "fixed threads count");
+      check (fe.get_threads_count () == 6, "dynamic threads count");
+      check (fixed_be.warnings_count == 1, "fixed too many threads");
+
+      char description[64];
+      fixed_fe.get_thread_description (main_thread >> 2, description,
+                                       sizeof(description));
+      check (std::strncmp (description, "main-thread-wit ", 16) == 0,
+             "fixed name truncated");
+
+      char fixed_registers[256];
+      char registers[256];
+      for (std::size_t i = 1; i < fixed_fe.get_threads_count (); ++i)
+        {
+          uint32_t id = fixed_fe.get_thread_id (i);
+          check (id == fe.get_thread_id (i), "fixed thread id");
+          check (
+              fixed_fe.get_thread_registers (id, fixed_registers,
+                                             sizeof(fixed_registers)) == 0
+                  && fe.get_thread_registers (id, registers,
+                                              sizeof(registers)) == 0
+                  && std::strcmp (fixed_registers, registers) == 0,
+              "fixed registers");
+        }
+    }
+  }
+
+  void
+  check_memory (void)
+  {
+    check_resources ();
+    check_statistics ();
+    check_fixed_capacity ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
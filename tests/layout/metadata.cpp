@@ -0,0 +1,216 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the parsing of the DRTM header.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    /**
+     * Get the IDs of the threads, in the order found.
+     */
+    std::size_t
+    thread_ids (frontend_type& fe, uint32_t* ids, std::size_t size)
+    {
+      std::size_t count = fe.get_threads_count ();
+      for (std::size_t i = 0; i < count && i < size; ++i)
+        {
+          ids[i] = fe.get_thread_id (i);
+        }
+      return count;
+    }
+
+    /**
+     * Each header version is read in a single transaction and
+     * decoded via its schema; the fields added by the newer
+     * versions are used.
+     */
+    void
+    check_schemas (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("idle", 0, 1, 1, 1, false);
+      add_thread ("other", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+
+      uint32_t ids[3];
+      {
+        backend be;
+        frontend_type fe
+          { be, allocator };
+
+        check (fe.update_thread_list () == 0, "v0 update");
+        check (be.header_reads == 1, "v0 header in one read");
+        check (thread_ids (fe, ids, 3) == 3, "v0 threads");
+      }
+
+      // The list links offsets, swapped, walk the lists backwards.
+      set_header_version (1, 0);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_PREV_OFFSET, 4);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_NEXT_OFFSET, 0);
+      {
+        backend be;
+        frontend_type fe
+          { be, allocator };
+
+        check (fe.update_thread_list () == 0, "v1.0 update");
+        check (be.header_reads == 1, "v1.0 header in one read");
+        uint32_t v1_ids[3];
+        check (thread_ids (fe, v1_ids, 3) == 3, "v1.0 threads");
+        check (v1_ids[0] == ids[2] && v1_ids[2] == ids[0],
+               "v1.0 list links offsets");
+      }
+
+      // A newer minor version is decoded with the latest known
+      // schema; the cores count comes from v1.1.
+      set_header_version (1, 9);
+      uint32_t current_threads_addr = ram_alloc (8);
+      ram_write_long (current_threads_addr, main_thread);
+      header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREADS_ADDR,
+                         current_threads_addr);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 2);
+      {
+        backend be;
+        frontend_type fe
+          { be, allocator };
+
+        check (fe.update_thread_list () == 0, "v1.9 update");
+        check (be.header_reads == 1, "v1.9 header in one read");
+        check (fe.get_threads_count () == 3, "v1.9 threads");
+        check (fe.get_cores_count () == 2, "v1.9 cores count");
+      }
+
+      // An unknown major version is not decoded.
+      set_header_version (2, 0);
+      {
+        backend be;
+        frontend_type fe
+          { be, allocator };
+
+        check (fe.update_thread_list () < 0, "v2.0 update");
+        check (be.errors_count == 1, "v2.0 error");
+      }
+
+      // An older header at the end of the memory, where the
+      // largest header cannot be read.
+      set_header_version (0, 1);
+      uint32_t end_addr = static_cast<uint32_t> (ram_base + ram_size_bytes
+          - OS_RTOS_DRTM_V0_SIZEOF);
+      std::memcpy (ram_ptr (end_addr), ram_ptr (drtm_addr),
+                   OS_RTOS_DRTM_V0_SIZEOF);
+      drtm_addr = end_addr;
+      {
+        backend be;
+        frontend_type fe
+          { be, allocator };
+
+        check (fe.update_thread_list () == 0, "short header update");
+        check (fe.get_threads_count () == 3, "short header threads");
+        check (be.header_reads > 1, "short header retried");
+
+        unsigned int header_reads = be.header_reads;
+        check (fe.update_thread_list () == 0, "short header again");
+        check (be.header_reads == header_reads + 1,
+               "short header size remembered");
+      }
+    }
+
+    /**
+     * The header is checked at each update, reading only the bytes
+     * of the parsed version; when it changes, like after the
+     * firmware is flashed again, it is read in full and parsed again,
+     * without the need to invalidate the metadata.
+     */
+    void
+    check_reflash (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t thread = add_thread ("thread", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (fe.update_thread_list () == 0, "reflash update");
+      check (fe.update_thread_list () == 0, "reflash update again");
+      check (be.header_reads == 2, "unchanged header read once");
+
+      // The bytes after the v0 header are not checked.
+      ram_write_long (drtm_addr + OS_RTOS_DRTM_V0_SIZEOF, 0x12345678);
+      check (fe.update_thread_list () == 0, "reflash update after header");
+      check (be.header_reads == 3, "bytes after the header ignored");
+
+      // A new firmware, with the state at another offset.
+      *ram_ptr (thread + 0x30) = 1;
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_STATE_OFFSET, 0x30);
+      check (fe.update_thread_list () == 0, "reflash update new layout");
+      check (be.header_reads == 5, "changed header read in full");
+
+      char description[64];
+      fe.get_thread_description (thread >> 2, description,
+                                 sizeof(description));
+      check (std::strcmp (description, "thread [S:Ready, P:10]") == 0,
+             "new layout used");
+
+      // A newer version, with a larger header.
+      set_header_version (1, 4);
+      check (fe.update_thread_list () == 0, "reflash update new version");
+      check (be.header_reads == 7, "new version read in full");
+      check (fe.update_thread_list () == 0, "reflash update newer again");
+      check (be.header_reads == 8, "new version read once");
+    }
+  }
+
+  void
+  check_metadata (void)
+  {
+    check_schemas ();
+    check_reflash ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
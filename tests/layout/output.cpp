@@ -0,0 +1,251 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the output of the descriptions and of the registers.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    /**
+     * An output iterator computing the GDB packet checksum, to
+     * check that the sink is not limited to character arrays.
+     */
+    class checksum_iterator
+    {
+    public:
+
+      checksum_iterator (uint8_t* sum) :
+          sum_ (sum)
+      {
+        ;
+      }
+
+      checksum_iterator&
+      operator* (void)
+      {
+        return *this;
+      }
+
+      checksum_iterator&
+      operator= (char c)
+      {
+        *sum_ = static_cast<uint8_t> (*sum_ + c);
+        return *this;
+      }
+
+      checksum_iterator&
+      operator++ (void)
+      {
+        return *this;
+      }
+
+    private:
+
+      uint8_t* sum_;
+    };
+
+    uint8_t
+    checksum (const char* s)
+    {
+      uint8_t sum = 0;
+      for (; *s != '\0'; ++s)
+        {
+          sum = static_cast<uint8_t> (sum + *s);
+        }
+      return sum;
+    }
+
+    /**
+     * The replies are written in place, to any output iterator,
+     * and the sink tells the size needed when truncated.
+     */
+    void
+    check_sinks (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t child = add_thread ("child", main_thread, 3, 100, 120, true);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (fe.update_thread_list () == 0, "sink update");
+
+      char description[64];
+      std::size_t length = fe.get_thread_description (child >> 2, description,
+                                                      sizeof(description));
+      check (std::strcmp (description, "child [S:Suspended, P:120(100), FP]")
+                 == 0,
+             "description");
+
+      // In place, after the packet prefix, with room for the terminator.
+      char packet[64];
+      std::strcpy (packet, "$");
+      drtm::sink<char*> out
+        { &packet[1], sizeof(packet) - 2 };
+      check (fe.get_thread_description (child >> 2, out) == length,
+             "sink description length");
+      packet[1 + out.length ()] = '\0';
+      check (std::strcmp (&packet[1], description) == 0,
+             "sink description");
+      check (!out.overflow (), "sink description overflow");
+
+      // Any output iterator.
+      uint8_t sum = 0;
+      drtm::sink<checksum_iterator> sums
+        { checksum_iterator
+          { &sum }, 1000 };
+      fe.get_thread_description (child >> 2, sums);
+      check (sum == checksum (description), "description checksum");
+
+      // Truncated, with the exact size needed.
+      drtm::sink<char*> small
+        { &packet[0], 8 };
+      check (fe.get_thread_description (child >> 2, small) == 8,
+             "truncated description length");
+      check (small.overflow (), "truncated description overflow");
+      check (small.required () == length, "truncated description required");
+
+      char registers[256];
+      check (fe.get_thread_registers (child >> 2, registers, sizeof(registers))
+                 == 0,
+             "registers");
+      // R0-R15 and xPSR, as hex.
+      check (std::strlen (registers) == 17 * 8, "registers length");
+
+      unsigned int errors_count = be.errors_count;
+      drtm::sink<char*> short_registers
+        { &packet[0], 10 };
+      check (fe.get_thread_registers (child >> 2, short_registers) < 0,
+             "truncated registers");
+      check (short_registers.length () == 10, "truncated registers length");
+      check (short_registers.required () == std::strlen (registers),
+             "truncated registers required");
+      check (std::strncmp (packet, registers, 10) == 0,
+             "truncated registers content");
+      check (be.errors_count == errors_count + 1, "truncated registers error");
+    }
+
+    /**
+     * Check the description of a thread.
+     */
+    void
+    check_description (frontend_type& fe, uint32_t tcb, const char* expected,
+                       const char* what)
+    {
+      char description[64];
+      fe.get_thread_description (tcb >> 2, description, sizeof(description));
+      check (std::strcmp (description, expected) == 0, what);
+    }
+
+    /**
+     * The descriptions are rendered once per snapshot, and served
+     * without target reads; they change only with the thread name,
+     * state, priorities and FP flag.
+     */
+    void
+    check_descriptions (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t idle = add_thread ("idle", 0, 1, 1, 1, false);
+      uint32_t child = add_thread ("child", main_thread, 3, 100, 120, true);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (fe.update_thread_list () == 0, "descriptions update");
+
+      unsigned int reads = be.reads;
+      check_description (fe, main_thread, "main [S:Running, P:127]",
+                         "running description");
+      check_description (fe, idle, "idle [S:Ready, P:1]", "idle description");
+      check_description (fe, child, "child [S:Suspended, P:120(100), FP]",
+                         "child description");
+      check (be.reads == reads, "descriptions without reads");
+
+      // The snapshot is kept until the next update.
+      *ram_ptr (child + tcb_state_offset) = 1;
+      *ram_ptr (idle + tcb_prio_inherited_offset) = 9;
+      check_description (fe, child, "child [S:Suspended, P:120(100), FP]",
+                         "description of the snapshot");
+
+      check (fe.update_thread_list () == 0, "descriptions update changed");
+      check_description (fe, main_thread, "main [S:Running, P:127]",
+                         "unchanged description");
+      check_description (fe, idle, "idle [S:Ready, P:9(1)]",
+                         "priority description");
+      check_description (fe, child, "child [S:Ready, P:120(100), FP]",
+                         "state description");
+
+      // Names sharing the prefix, and of the same length.
+      uint32_t name = ram_alloc (8);
+      std::memcpy (ram_ptr (name), "idle2", 6);
+      ram_write_long (idle + tcb_name_offset, name);
+      std::memcpy (ram_ptr (ram_read_long (child + tcb_name_offset)), "CHILD",
+                   5);
+
+      check (fe.update_thread_list () == 0, "descriptions update names");
+      check_description (fe, idle, "idle2 [S:Ready, P:9(1)]",
+                         "longer name description");
+      check_description (fe, child, "CHILD [S:Ready, P:120(100), FP]",
+                         "same length name description");
+      check (fe.update_thread_list () == 0, "descriptions update again");
+      check_description (fe, idle, "idle2 [S:Ready, P:9(1)]",
+                         "reused description");
+    }
+  }
+
+  void
+  check_output (void)
+  {
+    check_sinks ();
+    check_descriptions ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
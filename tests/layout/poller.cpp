@@ -0,0 +1,107 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the views of the poller, polled on the caller thread.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <drtm/poller.h>
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  void
+  check_poller (void)
+  {
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    uint32_t worker = add_thread ("a-worker-with-a-name-longer-than-the-view",
+                                  0, 3, 10, 8, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    allocator_type allocator;
+    backend be;
+    frontend_type fe
+      { be, allocator };
+
+    using poller_type = drtm::poller<frontend_type, 2>;
+    poller_type poller
+      { fe, allocator };
+    poller_type::view_type view
+      { allocator };
+
+    check (!poller.try_pop (view), "no views yet");
+
+    poller.poll ();
+    check (poller.try_pop (view), "first view");
+    check (view.sequence == 1 && view.status == 0, "first view sequence");
+    check (view.threads.size () == 2, "first view threads");
+    if (view.threads.size () == 2)
+      {
+        const poller_type::thread_view_type& m = view.threads[0];
+        check (m.id == (main_thread >> 2) && m.is_running
+                   && std::strcmp (m.name, "main") == 0,
+               "running thread view");
+
+        const poller_type::thread_view_type& w = view.threads[1];
+        check (w.id == (worker >> 2) && !w.is_running && w.state == 3
+                   && w.prio_assigned == 10 && w.prio_inherited == 8,
+               "thread view");
+        check (std::strlen (w.name) == poller_type::name_size_bytes - 1
+                   && std::strncmp (w.name, "a-worker-with", 13) == 0,
+               "thread view name truncated");
+      }
+
+    // The consumer is late; the newest view is dropped.
+    *ram_ptr (worker + tcb_state_offset) = 1;
+    poller.poll ();
+    poller.poll ();
+    poller.poll ();
+    check (poller.polls_count () == 4, "polls count");
+    check (poller.dropped_count () == 1, "dropped count");
+
+    check (poller.try_pop (view) && view.sequence == 2, "second view");
+    check (view.threads.size () == 2 && view.threads[1].state == 1,
+           "second view state");
+    check (poller.try_pop (view) && view.sequence == 3, "third view");
+    check (!poller.try_pop (view), "no more views");
+
+    poller.poll ();
+    check (poller.try_pop (view) && view.sequence == 5, "view after drop");
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,332 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the registers of the threads, as saved in the stack frames.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    // The register indices, as in the `m-float` feature.
+    constexpr std::size_t reg_fpscr = 23;
+    constexpr std::size_t reg_s0 = 24;
+    constexpr std::size_t reg_s16 = reg_s0 + 16;
+
+    /**
+     * Format a register value as hex digits, in target order.
+     */
+    void
+    format_register (uint32_t value, char* out, std::size_t size)
+    {
+      snprintf (out, size, "%02X%02X%02X%02X", value & 0xFF,
+                (value >> 8) & 0xFF, (value >> 16) & 0xFF,
+                (value >> 24) & 0xFF);
+    }
+
+    /**
+     * Check a register value.
+     */
+    void
+    check_register (frontend_type& fe, uint32_t tcb, std::size_t reg_index,
+                    uint32_t value, const char* what)
+    {
+      char expected[16];
+      format_register (value, expected, sizeof(expected));
+
+      char buf[16];
+      check (fe.get_thread_register (tcb >> 2, reg_index, buf, sizeof(buf))
+                 == 0,
+             what);
+      check (std::strcmp (buf, expected) == 0, what);
+    }
+
+    /**
+     * The FP registers are served from the extended frames; with the
+     * speculative frame reads, they come with the update; otherwise
+     * S0-S15 and FPSCR, above the core registers, are read only when
+     * one of them is requested, once per thread.
+     */
+    void
+    check_fp_registers (bool is_speculative)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t fp_thread = add_thread ("fp", 0, 3, 10, 10, true);
+      uint32_t int_thread = add_thread ("int", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+      fe.speculative_frame_read (is_speculative);
+
+      check (fe.update_thread_list () == 0, "fp update");
+
+      // S16-S31 are saved with the core registers.
+      check_register (fe, fp_thread, reg_s16, context_word (2, 9), "S16");
+      check_register (fe, fp_thread, 15, context_word (2, 31), "fp PC");
+      unsigned int reads = be.reads;
+
+      // The first of S0-S15, FPSCR reads the FP bank, if not
+      // already read.
+      check_register (fe, fp_thread, reg_s0, context_word (2, 33), "S0");
+      check (be.reads == reads + (is_speculative ? 0 : 1), "FP bank read");
+      check_register (fe, fp_thread, reg_s0 + 15, context_word (2, 48),
+                      "S15");
+      check_register (fe, fp_thread, reg_fpscr, context_word (2, 49),
+                      "FPSCR");
+      check (be.reads == reads + (is_speculative ? 0 : 1),
+             "FP bank not read again");
+
+      // Threads without a FP context have the FP registers zero.
+      check_register (fe, int_thread, 15, context_word (3, 15), "int PC");
+      reads = be.reads;
+      check_register (fe, int_thread, reg_s0, 0, "no FP S0");
+      check_register (fe, int_thread, reg_fpscr, 0, "no FP FPSCR");
+      check (be.reads == reads, "no FP bank for basic frames");
+    }
+
+    /**
+     * The `g` reply is rendered once per thread per halt; the
+     * repeated requests, and the single registers, are served
+     * from it, without target reads.
+     */
+    void
+    check_registers_cache (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t thread = add_thread ("thread", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+      // Read the frames only when requested.
+      fe.speculative_frame_read (false);
+
+      check (fe.update_thread_list () == 0, "cache update");
+
+      char first[256];
+      char again[256];
+      unsigned int reads = be.reads;
+      check (fe.get_thread_registers (thread >> 2, first, sizeof(first)) == 0,
+             "cache registers");
+      check (be.reads > reads, "registers read once");
+
+      reads = be.reads;
+      check (fe.get_thread_registers (thread >> 2, again, sizeof(again)) == 0,
+             "cached registers");
+      check (std::strcmp (first, again) == 0, "cached registers content");
+      check_register (fe, thread, 15, context_word (2, 15), "cached PC");
+      check (be.reads == reads, "cached registers without reads");
+
+      // Until the next update, the reply of this halt is kept.
+      uint32_t pc = ram_read_long (thread + tcb_stack_offset) + 15 * 4;
+      ram_write_long (pc, 0x08001234);
+      check (fe.get_thread_registers (thread >> 2, again, sizeof(again)) == 0,
+             "registers of the halt");
+      check (std::strcmp (first, again) == 0, "registers of the halt content");
+
+      check (fe.update_thread_list () == 0, "cache update again");
+      check (fe.get_thread_registers (thread >> 2, again, sizeof(again)) == 0,
+             "registers of the next halt");
+      check (std::strncmp (&again[15 * 8], "34120008", 8) == 0,
+             "registers of the next halt PC");
+      check_register (fe, thread, 15, 0x08001234, "next halt PC");
+    }
+
+    /**
+     * The frame layout is a policy; fixed frames are decoded
+     * without reading the selector.
+     */
+    void
+    check_frame_policies (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t thread = add_thread ("thread", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+
+      backend m0_be;
+      drtm::frontend<backend, allocator_type, drtm::frames::cortex_m0> m0_fe
+        { m0_be, allocator };
+      backend m4f_be;
+      frontend_type m4f_fe
+        { m4f_be, allocator };
+
+      check (m0_fe.update_thread_list () == 0, "m0 update");
+      check (m4f_fe.update_thread_list () == 0, "m4f update");
+
+      char m0_registers[256];
+      char m4f_registers[256];
+      unsigned int reads = m0_be.reads;
+      check (
+          m0_fe.get_thread_registers (thread >> 2, m0_registers,
+                                      sizeof(m0_registers)) == 0,
+          "m0 registers");
+      check (m0_be.reads == reads + 1, "m0 registers in one read");
+      check (
+          m4f_fe.get_thread_registers (thread >> 2, m4f_registers,
+                                       sizeof(m4f_registers)) == 0,
+          "m4f registers");
+      check (std::strcmp (m0_registers, m4f_registers) == 0,
+             "same basic frame");
+
+      // A RISC-V context, 31 words, over the same threads.
+      uint32_t stack = ram_read_long (thread + tcb_stack_offset);
+      for (uint32_t i = 0; i < 31; ++i)
+        {
+          ram_write_long (stack + i * 4, context_word (2, i));
+        }
+
+      backend rv_be;
+      drtm::frontend<backend, allocator_type, drtm::frames::riscv_rv32> rv_fe
+        { rv_be, allocator };
+
+      check (rv_fe.update_thread_list () == 0, "rv32 update");
+
+      char rv_registers[512];
+      check (
+          rv_fe.get_thread_registers (thread >> 2, rv_registers,
+                                      sizeof(rv_registers)) == 0,
+          "rv32 registers");
+      // x0-x31, pc.
+      check (std::strlen (rv_registers) == 33 * 8, "rv32 registers length");
+
+      char buf[16];
+      check (rv_fe.get_thread_register (thread >> 2, 0, buf, sizeof(buf)) == 0
+                 && std::strcmp (buf, "00000000") == 0,
+             "rv32 x0");
+      char expected[16];
+      format_register (context_word (2, 30), expected, sizeof(expected));
+      check (std::strncmp (&rv_registers[32 * 8], expected, 8) == 0,
+             "rv32 pc");
+      format_register (context_word (2, 0), expected, sizeof(expected));
+      check (std::strncmp (&rv_registers[1 * 8], expected, 8) == 0,
+             "rv32 ra");
+    }
+
+    /**
+     * With the speculative frame reads, the frame of each thread is
+     * read with the update, in the transaction that also decides the
+     * layout, so the registers are served without further reads; a
+     * frame close to the end of the memory falls back to the lazy
+     * reads.
+     */
+    void
+    check_speculative_reads (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t basic = add_thread ("basic", 0, 3, 10, 10, false);
+      uint32_t extended = add_thread ("extended", 0, 3, 10, 10, true);
+      uint32_t last = add_thread ("last", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      // Move the last frame at the end of the memory, where the
+      // largest frame does not fit.
+      uint32_t stack = static_cast<uint32_t> (ram_base + ram_size_bytes
+          - context_size_words * 4);
+      std::memcpy (ram_ptr (stack),
+                   ram_ptr (ram_read_long (last + tcb_stack_offset)),
+                   context_size_words * 4);
+      ram_write_long (last + tcb_stack_offset, stack);
+
+      allocator_type allocator;
+
+      backend lazy_be;
+      frontend_type lazy_fe
+        { lazy_be, allocator };
+      lazy_fe.speculative_frame_read (false);
+
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (lazy_fe.update_thread_list () == 0, "lazy update");
+      check (fe.update_thread_list () == 0, "speculative update");
+      // One transaction per frame, either way, plus the failed
+      // speculative read of the last frame.
+      check (be.reads == lazy_be.reads + 1, "speculative update reads");
+
+      char lazy_registers[256];
+      char registers[256];
+      for (uint32_t tcb : { basic, extended, last })
+        {
+          unsigned int lazy_reads = lazy_be.reads;
+          unsigned int reads = be.reads;
+          check (
+              lazy_fe.get_thread_registers (tcb >> 2, lazy_registers,
+                                            sizeof(lazy_registers)) == 0,
+              "lazy registers");
+          check (
+              fe.get_thread_registers (tcb >> 2, registers, sizeof(registers))
+                  == 0,
+              "speculative registers");
+          check (std::strcmp (lazy_registers, registers) == 0,
+                 "speculative registers content");
+          check (lazy_be.reads == lazy_reads + 1, "lazy registers reads");
+          check (be.reads == reads + (tcb == last ? 1 : 0),
+                 "speculative registers reads");
+        }
+
+      check_register (fe, last, 15, context_word (4, 15), "fallback PC");
+    }
+  }
+
+  void
+  check_registers (void)
+  {
+    check_fp_registers (true);
+    check_fp_registers (false);
+    check_registers_cache ();
+    check_frame_policies ();
+    check_speculative_reads ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check that the readers see the published snapshot while the
+ * next one is built.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    // The state seen by the queries issued during the update.
+    frontend_type* updating_frontend;
+    uint32_t published_ids[4];
+    std::size_t published_count;
+    uint32_t published_current_id;
+    unsigned int queries_count;
+
+    /**
+     * Called before each target transaction of the update, like
+     * a reader on another host thread would; only the queries
+     * that do not read the target are used, since the hook runs
+     * with the transactions lock held.
+     */
+    void
+    query_during_update (void)
+    {
+      frontend_type& fe = *updating_frontend;
+      ++queries_count;
+
+      std::size_t count = fe.get_threads_count ();
+      check (count == published_count, "published threads count");
+      for (std::size_t i = 0; i < count && i < 4; ++i)
+        {
+          check (fe.get_thread_id (i) == published_ids[i],
+                 "published thread id");
+        }
+      check (fe.get_current_thread_id () == published_current_id,
+             "published current thread");
+    }
+
+    /**
+     * A reader may keep the ID of a thread from an older snapshot;
+     * the queries for a thread gone in the published snapshot fail,
+     * without output.
+     */
+    void
+    check_stale_ids (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("worker", 0, 3, 10, 10, false);
+      uint32_t child = add_thread ("child", main_thread, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      check (fe.update_thread_list () == 0, "stale first update");
+      char buf[256];
+      check (fe.get_thread_registers (child >> 2, buf, sizeof(buf)) == 0,
+             "registers before exit");
+
+      // The child exits.
+      build_os ();
+      main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("worker", 0, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      check (fe.update_thread_list () == 0, "stale next update");
+      check (fe.get_threads_count () == 2, "stale threads count");
+
+      std::strcpy (buf, "x");
+      check (fe.get_thread_registers (child >> 2, buf, sizeof(buf)) < 0,
+             "stale registers");
+      check (buf[0] == '\0', "stale registers output");
+      std::strcpy (buf, "x");
+      check (fe.get_thread_register (child >> 2, 15, buf, sizeof(buf)) < 0,
+             "stale register");
+      check (buf[0] == '\0', "stale register output");
+      fe.get_thread_description (child >> 2, buf, sizeof(buf));
+      check (std::strcmp (buf, "none") == 0, "stale description");
+    }
+  }
+
+  void
+  check_snapshots (void)
+  {
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    uint32_t worker = add_thread ("worker", 0, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    allocator_type allocator;
+    backend be;
+    frontend_type fe
+      { be, allocator };
+    updating_frontend = &fe;
+
+    // Before the first update, nothing is published.
+    published_count = 0;
+    published_current_id = 0;
+    queries_count = 0;
+    be.on_read = query_during_update;
+    check (fe.update_thread_list () == 0, "first update");
+    check (queries_count > 0, "queries during the first update");
+
+    published_count = fe.get_threads_count ();
+    check (published_count == 2, "first threads count");
+    for (std::size_t i = 0; i < published_count; ++i)
+      {
+        published_ids[i] = fe.get_thread_id (i);
+      }
+    published_current_id = main_thread >> 2;
+
+    // The target changes; the queries still see the previous
+    // snapshot until the new one is published.
+    add_thread ("child", worker, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, worker);
+
+    queries_count = 0;
+    check (fe.update_thread_list () == 0, "next update");
+    check (queries_count > 0, "queries during the next update");
+    be.on_read = nullptr;
+
+    check (fe.get_threads_count () == 3, "next threads count");
+    check (fe.get_current_thread_id () == (worker >> 2),
+           "next current thread");
+
+    check_stale_ids ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
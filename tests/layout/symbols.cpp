@@ -0,0 +1,327 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the ELF reader, on a small image built with the symbols
+ * of the simulated target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "target.h"
+
+#include <drtm/elf-symbols.h>
+
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    using elf_type = drtm::elf_symbols<allocator_type>;
+
+    constexpr uint32_t flash_base = 0x08000000;
+    constexpr uint32_t flash_size_bytes = 0x1000;
+
+    /**
+     * A minimal ELF32 little endian image, built in memory.
+     */
+    class elf_image
+    {
+    public:
+
+      void
+      put_short (uint32_t offset, uint16_t value)
+      {
+        bytes[offset] = static_cast<uint8_t> (value);
+        bytes[offset + 1] = static_cast<uint8_t> (value >> 8);
+      }
+
+      void
+      put_long (uint32_t offset, uint32_t value)
+      {
+        put_short (offset, static_cast<uint16_t> (value));
+        put_short (offset + 2, static_cast<uint16_t> (value >> 16));
+      }
+
+      uint32_t
+      append (const void* data, std::size_t size_bytes)
+      {
+        uint32_t offset = static_cast<uint32_t> ((bytes.size () + 3) & ~3u);
+        bytes.resize (offset + size_bytes);
+        std::memcpy (&bytes[offset], data, size_bytes);
+        return offset;
+      }
+
+      uint32_t
+      reserve (std::size_t size_bytes)
+      {
+        uint32_t offset = static_cast<uint32_t> ((bytes.size () + 3) & ~3u);
+        bytes.resize (offset + size_bytes);
+        return offset;
+      }
+
+    public:
+
+      std::vector<uint8_t> bytes;
+    };
+
+    /**
+     * Add a name to a string table; return its offset.
+     */
+    uint32_t
+    add_string (std::vector<char>& table, const char* name)
+    {
+      uint32_t offset = static_cast<uint32_t> (table.size ());
+      table.insert (table.end (), name, name + std::strlen (name) + 1);
+      return offset;
+    }
+
+    /**
+     * Build the image, with a flash and a RAM segment, and with
+     * the symbols of the scheduler; a local symbol with the same
+     * name as a global one, an undefined symbol and a section
+     * symbol are added, to be ignored.
+     */
+    void
+    build_elf (elf_image& elf)
+    {
+      std::vector<char> strtab (1, '\0');
+
+      struct
+      {
+        const char* name;
+        uint32_t value;
+        uint32_t size;
+        uint8_t info;
+        uint16_t shndx;
+      } symbols[] =
+        {
+          { "", 0, 0, 0, 0 }, // The undefined symbol.
+          { "", flash_base, 0, 0x03, 1 }, // STT_SECTION
+          { "scheduler_current_thread", 0x1234, 4, 0x01, 1 }, // Local.
+          { DRTM_SYMBOL_NAME, drtm_addr, 0x80, 0x11, 1 },
+          { "scheduler_is_started", is_started_addr, 1, 0x11, 1 },
+          { "scheduler_top_threads_list", top_threads_list_addr, 8, 0x11, 1 },
+          { "scheduler_current_thread", current_thread_addr, 4, 0x11, 1 },
+          { "undefined", 0, 0, 0x10, 0 }, };
+
+      // The headers are filled in when the sections are known.
+      elf.reserve (0x34 + 2 * 0x20);
+
+      std::vector<uint8_t> symtab;
+      for (auto& s : symbols)
+        {
+          uint8_t sym[16] =
+            { };
+          uint32_t name = *s.name != '\0' ? add_string (strtab, s.name) : 0;
+          std::memcpy (&sym[0], &name, 4);
+          std::memcpy (&sym[4], &s.value, 4);
+          std::memcpy (&sym[8], &s.size, 4);
+          sym[12] = s.info;
+          std::memcpy (&sym[14], &s.shndx, 2);
+          symtab.insert (symtab.end (), sym, sym + sizeof(sym));
+        }
+
+      std::vector<char> shstrtab (1, '\0');
+      uint32_t symtab_name = add_string (shstrtab, ".symtab");
+      uint32_t strtab_name = add_string (shstrtab, ".strtab");
+      uint32_t shstrtab_name = add_string (shstrtab, ".shstrtab");
+
+      uint32_t symtab_offset = elf.append (symtab.data (), symtab.size ());
+      uint32_t strtab_offset = elf.append (strtab.data (), strtab.size ());
+      uint32_t shstrtab_offset = elf.append (shstrtab.data (),
+                                             shstrtab.size ());
+      uint32_t shoff = elf.reserve (4 * 0x28);
+
+      // The ELF header.
+      std::memcpy (&elf.bytes[0], "\177ELF\x01\x01\x01", 7);
+      elf.put_short (0x10, 2); // ET_EXEC
+      elf.put_short (0x12, 40); // EM_ARM
+      elf.put_long (0x14, 1);
+      elf.put_long (0x1C, 0x34);
+      elf.put_long (0x20, shoff);
+      elf.put_short (0x28, 0x34);
+      elf.put_short (0x2A, 0x20);
+      elf.put_short (0x2C, 2);
+      elf.put_short (0x2E, 0x28);
+      elf.put_short (0x30, 4);
+      elf.put_short (0x32, 3);
+
+      // The program headers, RAM first, to check the regions are
+      // ordered by address.
+      uint32_t ph = 0x34;
+      elf.put_long (ph, 1); // PT_LOAD
+      elf.put_long (ph + 0x08, ram_base);
+      elf.put_long (ph + 0x0C, flash_base + flash_size_bytes);
+      elf.put_long (ph + 0x10, 0x100);
+      elf.put_long (ph + 0x14, ram_size_bytes);
+      elf.put_long (ph + 0x18, 0x6); // RW
+
+      ph += 0x20;
+      elf.put_long (ph, 1);
+      elf.put_long (ph + 0x08, flash_base);
+      elf.put_long (ph + 0x0C, flash_base);
+      elf.put_long (ph + 0x10, flash_size_bytes);
+      elf.put_long (ph + 0x14, flash_size_bytes);
+      elf.put_long (ph + 0x18, 0x5); // RX
+
+      // The section headers; the first one is null.
+      uint32_t sh = shoff + 0x28;
+      elf.put_long (sh, symtab_name);
+      elf.put_long (sh + 0x04, 2); // SHT_SYMTAB
+      elf.put_long (sh + 0x10, symtab_offset);
+      elf.put_long (sh + 0x14, static_cast<uint32_t> (symtab.size ()));
+      elf.put_long (sh + 0x18, 2); // The string table.
+      elf.put_long (sh + 0x24, 16);
+
+      sh += 0x28;
+      elf.put_long (sh, strtab_name);
+      elf.put_long (sh + 0x04, 3); // SHT_STRTAB
+      elf.put_long (sh + 0x10, strtab_offset);
+      elf.put_long (sh + 0x14, static_cast<uint32_t> (strtab.size ()));
+
+      sh += 0x28;
+      elf.put_long (sh, shstrtab_name);
+      elf.put_long (sh + 0x04, 3);
+      elf.put_long (sh + 0x10, shstrtab_offset);
+      elf.put_long (sh + 0x14, static_cast<uint32_t> (shstrtab.size ()));
+    }
+
+    /**
+     * A backend that takes the symbols from the ELF image,
+     * without asking the debugger.
+     */
+    class elf_backend : public backend
+    {
+    public:
+
+      elf_backend (const elf_type& elf) :
+          elf_ (elf)
+      {
+      }
+
+      target_addr_t
+      get_symbol_address (const char* name)
+      {
+        return static_cast<target_addr_t> (elf_.get_symbol_address (name));
+      }
+
+    protected:
+
+      const elf_type& elf_;
+    };
+  }
+
+  void
+  check_symbols (void)
+  {
+    build_os ();
+
+    uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+    add_thread ("thread", 0, 3, 10, 10, false);
+    ram_write_long (current_thread_addr, main_thread);
+
+    elf_image image;
+    build_elf (image);
+
+    char path[] = "/tmp/drtm-layout-XXXXXX";
+    int fd = mkstemp (path);
+    check (fd >= 0, "elf temporary file");
+    if (fd < 0)
+      {
+        return;
+      }
+    bool is_written = write (fd, image.bytes.data (), image.bytes.size ())
+        == static_cast<ssize_t> (image.bytes.size ());
+    close (fd);
+    check (is_written, "elf written");
+
+    allocator_type allocator;
+    elf_type elf
+      { allocator };
+    check (elf.open (path), "elf open");
+    unlink (path);
+
+    check (!elf.is_class64 (), "elf class");
+    // The section symbol and the undefined symbol are not indexed.
+    check (elf.symbols_count () == 4, "elf symbols count");
+
+    uint64_t address = 0;
+    uint64_t size = 0;
+    check (elf.lookup (DRTM_SYMBOL_NAME, &address, &size)
+               && address == drtm_addr && size == 0x80,
+           "elf header symbol");
+    check (elf.get_symbol_address ("scheduler_current_thread")
+               == current_thread_addr,
+           "elf global symbol preferred");
+    check (!elf.lookup ("undefined", &address), "elf undefined symbol");
+    check (elf.get_symbol_address ("missing") == 0, "elf missing symbol");
+
+    check (elf.regions ().size () == 2, "elf regions");
+    check (elf.regions ()[0].address == flash_base, "elf regions order");
+    const elf_type::region_t* ram = elf.region (drtm_addr);
+    check (ram != nullptr && ram->address == ram_base
+               && ram->load_address == flash_base + flash_size_bytes
+               && ram->flags
+                   == (elf_type::region_flag_read
+                       | elf_type::region_flag_write),
+           "elf RAM region");
+    check (elf.is_mapped (drtm_addr, 0x80), "elf header mapped");
+    check (!elf.is_mapped (ram_base + ram_size_bytes - 4, 8),
+           "elf range past the region");
+    check (elf.region (flash_base + flash_size_bytes) == nullptr,
+           "elf gap between regions");
+
+    const uint8_t* data;
+    std::size_t data_size;
+    check (elf.section (".strtab", &data, &data_size)
+               && std::memcmp (data + 1, "scheduler_current_thread", 25) == 0,
+           "elf section");
+    check (!elf.section (".debug_info", &data, &data_size),
+           "elf missing section");
+
+    // The front end finds the header and the scheduler via the ELF.
+    elf_backend be
+      { elf };
+    drtm::frontend<elf_backend, allocator_type> fe
+      { be, allocator };
+    check (fe.update_thread_list () == 0, "elf update");
+    check (fe.get_threads_count () == 2, "elf threads count");
+    check (fe.get_current_thread_id () == (main_thread >> 2),
+           "elf current thread");
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,314 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "target.h"
+
+#include <cstring>
+#include <cstdarg>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    uint8_t ram[ram_size_bytes];
+    uint32_t ram_brk;
+
+    // The number of threads added since the target was built.
+    uint32_t threads_count;
+  }
+
+  uint32_t drtm_addr;
+  uint32_t is_started_addr;
+  uint32_t top_threads_list_addr;
+  uint32_t current_thread_addr;
+
+  int errors;
+
+  uint8_t*
+  ram_ptr (uint32_t addr)
+  {
+    return &ram[addr - ram_base];
+  }
+
+  uint32_t
+  ram_alloc (uint32_t size_bytes)
+  {
+    uint32_t addr = (ram_brk + 7) & ~7u;
+    ram_brk = addr + size_bytes;
+    if (ram_brk > ram_base + ram_size_bytes)
+      {
+        printf ("Simulated RAM exhausted.\n");
+        exit (1);
+      }
+    return addr;
+  }
+
+  void
+  ram_write_long (uint32_t addr, uint32_t value)
+  {
+    std::memcpy (ram_ptr (addr), &value, sizeof(value));
+  }
+
+  void
+  ram_write_short (uint32_t addr, uint16_t value)
+  {
+    std::memcpy (ram_ptr (addr), &value, sizeof(value));
+  }
+
+  uint32_t
+  ram_read_long (uint32_t addr)
+  {
+    uint32_t value;
+    std::memcpy (&value, ram_ptr (addr), sizeof(value));
+    return value;
+  }
+
+  // --------------------------------------------------------------------------
+
+  backend::target_addr_t
+  backend::get_symbol_address (const char* name)
+  {
+    if (std::strcmp (name, DRTM_SYMBOL_NAME) == 0)
+      {
+        return drtm_addr;
+      }
+    else if (std::strcmp (name, "scheduler_is_started") == 0)
+      {
+        return is_started_addr;
+      }
+    else if (std::strcmp (name, "scheduler_top_threads_list") == 0)
+      {
+        return top_threads_list_addr;
+      }
+    else if (std::strcmp (name, "scheduler_current_thread") == 0)
+      {
+        return current_thread_addr;
+      }
+    return 0;
+  }
+
+  int
+  backend::output (const char* fmt, ...)
+  {
+    va_list args;
+    va_start(args, fmt);
+    int ret = vprintf (fmt, args);
+    va_end(args);
+    return ret;
+  }
+
+  int
+  backend::output_warning (const char* fmt, ...)
+  {
+    ++warnings_count;
+    printf ("WARNING: ");
+    va_list args;
+    va_start(args, fmt);
+    int ret = vprintf (fmt, args);
+    va_end(args);
+    return ret;
+  }
+
+  int
+  backend::output_error (const char* fmt, ...)
+  {
+    ++errors_count;
+    printf ("ERROR: ");
+    va_list args;
+    va_start(args, fmt);
+    int ret = vprintf (fmt, args);
+    va_end(args);
+    return ret;
+  }
+
+  int
+  backend::read_byte_array (target_addr_t addr, uint8_t* out_array,
+                            std::size_t bytes)
+  {
+    ++reads;
+    if (addr == drtm_addr)
+      {
+        ++header_reads;
+      }
+    if (on_read != nullptr)
+      {
+        on_read ();
+      }
+    if (addr < ram_base || addr + bytes > ram_base + ram_size_bytes)
+      {
+        return -1;
+      }
+    std::memcpy (out_array, ram_ptr (addr), bytes);
+    return 0;
+  }
+
+  // --------------------------------------------------------------------------
+
+  namespace
+  {
+    void
+    list_init (uint32_t node)
+    {
+      ram_write_long (node, node);
+      ram_write_long (node + 4, node);
+    }
+
+    void
+    list_add (uint32_t head, uint32_t node)
+    {
+      uint32_t last = ram_read_long (head);
+      ram_write_long (node, last);
+      ram_write_long (node + 4, head);
+      ram_write_long (last + 4, node);
+      ram_write_long (head, node);
+    }
+  }
+
+  void
+  build_os (void)
+  {
+    std::memset (ram, 0, sizeof(ram));
+    ram_brk = ram_base + 0x100;
+    threads_count = 0;
+
+    drtm_addr = ram_alloc (0x80);
+    is_started_addr = ram_alloc (4);
+    top_threads_list_addr = ram_alloc (8);
+    current_thread_addr = ram_alloc (4);
+
+    list_init (top_threads_list_addr);
+
+    // A v0.1.0 header.
+    std::memcpy (ram_ptr (drtm_addr), "DRTMv\x00\x01\x00", 8);
+    header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_IS_STARTED_ADDR,
+                       is_started_addr);
+    header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_TOP_THREADS_LIST_ADDR,
+                       top_threads_list_addr);
+    header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CURRENT_THREAD_ADDR,
+                       current_thread_addr);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_NAME_OFFSET,
+                        tcb_name_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_PARENT_OFFSET,
+                        tcb_parent_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_LIST_NODE_OFFSET,
+                        tcb_list_node_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_CHILDREN_NODE_OFFSET,
+                        tcb_children_node_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_STATE_OFFSET,
+                        tcb_state_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_OFFSET,
+                        tcb_stack_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_ASSIGNED,
+                        tcb_prio_assigned_offset);
+    header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_PRIO_INHERITED,
+                        tcb_prio_inherited_offset);
+
+    *ram_ptr (is_started_addr) = 1;
+  }
+
+  void
+  set_header_version (uint8_t major, uint8_t minor)
+  {
+    *ram_ptr (drtm_addr + OS_RTOS_DRTM_OFFSETOF_VERSION + 1) = major;
+    *ram_ptr (drtm_addr + OS_RTOS_DRTM_OFFSETOF_VERSION + 2) = minor;
+
+    if (major >= 1)
+      {
+        header_write_short (OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_PREV_OFFSET, 0);
+        header_write_short (OS_RTOS_DRTM_OFFSETOF_LIST_LINKS_NEXT_OFFSET, 4);
+        // EXC_RETURN is the 9th word of the context.
+        header_write_short (OS_RTOS_DRTM_OFFSETOF_THREAD_STACK_SELECTOR_OFFSET,
+                            8);
+      }
+  }
+
+  void
+  header_write_long (uint16_t offset, uint32_t value)
+  {
+    ram_write_long (drtm_addr + offset, value);
+  }
+
+  void
+  header_write_short (uint16_t offset, uint16_t value)
+  {
+    ram_write_short (drtm_addr + offset, value);
+  }
+
+  uint32_t
+  add_thread (const char* name, uint32_t parent, uint8_t state,
+              uint8_t prio_assigned, uint8_t prio_inherited, bool is_fp)
+  {
+    uint32_t n = ++threads_count;
+
+    uint32_t tcb = ram_alloc (tcb_size_bytes);
+    uint32_t name_addr = ram_alloc (
+        static_cast<uint32_t> (std::strlen (name) + 1));
+    std::memcpy (ram_ptr (name_addr), name, std::strlen (name) + 1);
+
+    ram_write_long (tcb + tcb_name_offset, name_addr);
+    ram_write_long (tcb + tcb_parent_offset, parent);
+    list_init (tcb + tcb_children_node_offset);
+    list_add (
+        parent != 0 ? parent + tcb_children_node_offset : top_threads_list_addr,
+        tcb + tcb_list_node_offset);
+    *ram_ptr (tcb + tcb_state_offset) = state;
+    *ram_ptr (tcb + tcb_prio_assigned_offset) = prio_assigned;
+    *ram_ptr (tcb + tcb_prio_inherited_offset) = prio_inherited;
+
+    // The saved context, with EXC_RETURN in the 9th word.
+    uint32_t words = is_fp ? fp_context_size_words : context_size_words;
+    uint32_t stack = ram_alloc (words * 4 + 64);
+    for (uint32_t i = 0; i < words; ++i)
+      {
+        ram_write_long (stack + i * 4, context_word (n, i));
+      }
+    ram_write_long (stack + 8 * 4, is_fp ? 0xFFFFFFED : 0xFFFFFFFD);
+    ram_write_long (tcb + tcb_stack_offset, stack);
+
+    return tcb;
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  check (bool condition, const char* what)
+  {
+    if (!condition)
+      {
+        printf ("FAILED: %s\n", what);
+        ++errors;
+      }
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,269 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DRTM_TESTS_LAYOUT_TARGET_H_
+#define DRTM_TESTS_LAYOUT_TARGET_H_
+
+/*
+ * The target simulated in memory, with a µOS++ like tree of
+ * threads, shared by all checks.
+ */
+
+#include <drtm/drtm.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  // The simulated target memory.
+  constexpr uint32_t ram_base = 0x20000000;
+  constexpr std::size_t ram_size_bytes = 0x10000;
+
+  // The thread control block layout.
+  constexpr uint16_t tcb_name_offset = 0x08;
+  constexpr uint16_t tcb_parent_offset = 0x10;
+  constexpr uint16_t tcb_list_node_offset = 0x14;
+  constexpr uint16_t tcb_children_node_offset = 0x1C;
+  constexpr uint16_t tcb_state_offset = 0x24;
+  constexpr uint16_t tcb_stack_offset = 0x28;
+  constexpr uint16_t tcb_prio_assigned_offset = 0x2C;
+  constexpr uint16_t tcb_prio_inherited_offset = 0x2D;
+  constexpr uint32_t tcb_size_bytes = 0x40;
+
+  // The saved contexts, in words.
+  constexpr uint32_t context_size_words = 17;
+  constexpr uint32_t fp_context_size_words = 50;
+
+  uint8_t*
+  ram_ptr (uint32_t addr);
+
+  uint32_t
+  ram_alloc (uint32_t size_bytes);
+
+  void
+  ram_write_long (uint32_t addr, uint32_t value);
+
+  void
+  ram_write_short (uint32_t addr, uint16_t value);
+
+  uint32_t
+  ram_read_long (uint32_t addr);
+
+  // Addresses of the scheduler variables and of the header.
+  extern uint32_t drtm_addr;
+  extern uint32_t is_started_addr;
+  extern uint32_t top_threads_list_addr;
+  extern uint32_t current_thread_addr;
+
+  // --------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * A backend that reads the simulated target memory.
+   */
+  class backend
+  {
+  public:
+
+    using target_addr_t = uint32_t;
+    using thread_id_t = uint32_t;
+
+  public:
+
+    target_addr_t
+    get_symbol_address (const char* name);
+
+    int
+    output (const char* fmt, ...);
+
+    int
+    output_warning (const char* fmt, ...);
+
+    int
+    output_error (const char* fmt, ...);
+
+    int
+    read_byte_array (target_addr_t addr, uint8_t* out_array,
+                     std::size_t bytes);
+
+    int
+    read_byte (target_addr_t addr, uint8_t* out_value)
+    {
+      return read_byte_array (addr, out_value, 1);
+    }
+
+    int
+    read_short (target_addr_t addr, uint16_t* out_value)
+    {
+      uint8_t buf[2];
+      int ret = read_byte_array (addr, &buf[0], sizeof(buf));
+      if (ret >= 0)
+        {
+          *out_value = load_short (&buf[0]);
+        }
+      return ret;
+    }
+
+    int
+    read_long (target_addr_t addr, uint32_t* out_value)
+    {
+      uint8_t buf[4];
+      int ret = read_byte_array (addr, &buf[0], sizeof(buf));
+      if (ret >= 0)
+        {
+          *out_value = load_long (&buf[0]);
+        }
+      return ret;
+    }
+
+    uint16_t
+    load_short (const uint8_t* p)
+    {
+      return static_cast<uint16_t> (p[0] | (p[1] << 8));
+    }
+
+    uint32_t
+    load_long (const uint8_t* p)
+    {
+      return static_cast<uint32_t> (p[0] | (p[1] << 8) | (p[2] << 16)
+          | (p[3] << 24));
+    }
+
+  public:
+
+    // The number of target transactions.
+    unsigned int reads = 0;
+    // The number of transactions reading the header.
+    unsigned int header_reads = 0;
+    unsigned int warnings_count = 0;
+    unsigned int errors_count = 0;
+
+    // Called before each transaction, to simulate a running target.
+    void
+    (*on_read) (void) = nullptr;
+  };
+
+#pragma GCC diagnostic pop
+
+  using allocator_type = std::allocator<void*>;
+
+  using frontend_type = drtm::frontend<backend, allocator_type>;
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief Clear the target and write a v0.1.0 header, with
+   * no threads.
+   */
+  void
+  build_os (void);
+
+  /**
+   * @brief Change the header version; for v1.x, the list links
+   * and the frame selector offsets are also written.
+   */
+  void
+  set_header_version (uint8_t major, uint8_t minor);
+
+  void
+  header_write_long (uint16_t offset, uint32_t value);
+
+  void
+  header_write_short (uint16_t offset, uint16_t value);
+
+  uint32_t
+  add_thread (const char* name, uint32_t parent, uint8_t state,
+              uint8_t prio_assigned, uint8_t prio_inherited, bool is_fp);
+
+  /**
+   * @brief Get the value saved in a context word of the n-th
+   * thread added, from 1.
+   */
+  constexpr uint32_t
+  context_word (uint32_t n, uint32_t word)
+  {
+    return (n << 12) + word;
+  }
+
+  // --------------------------------------------------------------------------
+
+  extern int errors;
+
+  void
+  check (bool condition, const char* what);
+
+  // --------------------------------------------------------------------------
+
+  // The checks, one function for each group of features.
+
+  void
+  check_registers (void);
+
+  void
+  check_output (void);
+
+  void
+  check_metadata (void);
+
+  void
+  check_symbols (void);
+
+  void
+  check_cores (void);
+
+  void
+  check_snapshots (void);
+
+  void
+  check_poller (void);
+
+  void
+  check_driver (void);
+
+  void
+  check_memory (void);
+
+  void
+  check_updates (void);
+
+  /**
+   * @brief Check the DWARF metadata of this executable.
+   */
+  void
+  check_dwarf (const char* path);
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
+
+#endif /* DRTM_TESTS_LAYOUT_TARGET_H_ */
@@ -0,0 +1,752 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Check the update modes, counting the target transactions.
+ */
+
+#include <stdio.h>
+
+#include "target.h"
+
+#include <cstring>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+
+namespace sim
+{
+  namespace
+  {
+    /**
+     * While single stepping, the snapshot is kept if the running
+     * thread and the top list did not change, after reading only
+     * them; otherwise the update is a full one.
+     */
+    void
+    check_step_mode (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t worker = add_thread ("worker", main_thread, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      // The first update is always a full one.
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "first step update");
+      check (fe.get_threads_count () == 2, "first step threads count");
+
+      char before[64];
+      char after[64];
+      fe.get_thread_description (worker >> 2, before, sizeof(before));
+
+      // A thread not running changes; the snapshot is kept.
+      *ram_ptr (worker + tcb_state_offset) = 1;
+      unsigned int reads = be.reads;
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "step update");
+      check (be.reads == reads + 2, "step update reads");
+      fe.get_thread_description (worker >> 2, after, sizeof(after));
+      check (std::strcmp (before, after) == 0, "step snapshot kept");
+
+      // A full update sees the change.
+      reads = be.reads;
+      check (fe.update_thread_list () == 0, "full update");
+      unsigned int full_reads = be.reads - reads;
+      check (full_reads > 2, "full update reads");
+      fe.get_thread_description (worker >> 2, after, sizeof(after));
+      check (std::strcmp (before, after) != 0, "full update snapshot");
+
+      // The running thread changes.
+      ram_write_long (current_thread_addr, worker);
+      reads = be.reads;
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "step update after a switch");
+      check (be.reads - reads > 2, "step update after a switch reads");
+      check (fe.get_current_thread_id () == (worker >> 2),
+             "step update current thread");
+
+      reads = be.reads;
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "step update after the switch");
+      check (be.reads == reads + 2, "step update after the switch reads");
+
+      // A new top thread.
+      add_thread ("top", 0, 3, 1, 1, false);
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "step update with a new top thread");
+      check (fe.get_threads_count () == 3, "step update new threads count");
+    }
+
+    /**
+     * With a v1.2 header, while the generation of the thread lists
+     * is unchanged, the tree is reused and only the threads are
+     * read again; a new generation walks the lists again, and so
+     * does the same generation after a reset, with other threads.
+     */
+    void
+    check_generation (void)
+    {
+      build_os ();
+      set_header_version (1, 2);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 1);
+      uint32_t generation = ram_alloc (4);
+      header_write_long (
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_GENERATION_ADDR,
+          generation);
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      uint32_t worker = add_thread ("worker", main_thread, 3, 10, 10, false);
+      add_thread ("idle", 0, 3, 1, 1, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      backend be;
+      frontend_type fe
+        { be, allocator };
+
+      // Both snapshots are built by walking the lists.
+      check (fe.update_thread_list () == 0, "generation update");
+      unsigned int reads = be.reads;
+      check (fe.update_thread_list () == 0, "generation update again");
+      unsigned int walk_reads = be.reads - reads;
+
+      reads = be.reads;
+      check (fe.update_thread_list () == 0, "generation unchanged update");
+      unsigned int reuse_reads = be.reads - reads;
+      check (reuse_reads < walk_reads, "generation unchanged reads");
+
+      // The threads are still read.
+      *ram_ptr (worker + tcb_prio_inherited_offset) = 20;
+      check (fe.update_thread_list () == 0, "generation prio update");
+      char description[64];
+      fe.get_thread_description (worker >> 2, description,
+                                 sizeof(description));
+      check (std::strstr (description, "P:20(10)") != nullptr,
+             "generation prio change");
+
+      // A thread added without a new generation is not seen.
+      add_thread ("child", worker, 3, 5, 5, false);
+      check (fe.update_thread_list () == 0, "generation stale update");
+      check (fe.get_threads_count () == 3, "generation stale threads count");
+
+      ram_write_long (generation, 1);
+      reads = be.reads;
+      check (fe.update_thread_list () == 0, "generation changed update");
+      check (be.reads - reads > reuse_reads, "generation changed reads");
+      check (fe.get_threads_count () == 4, "generation new threads count");
+      check (fe.update_thread_list () == 0, "generation new update again");
+
+      // The target is reset, with other threads, and the counter
+      // reaches the same value; the tree is not reused.
+      build_os ();
+      set_header_version (1, 2);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 1);
+      generation = ram_alloc (4);
+      header_write_long (
+          OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_GENERATION_ADDR,
+          generation);
+      main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("idle", 0, 3, 1, 1, false);
+      ram_write_long (current_thread_addr, main_thread);
+      ram_write_long (generation, 1);
+
+      check (fe.update_thread_list () == 0, "generation reset update");
+      check (fe.get_threads_count () == 2, "generation reset threads count");
+      check (fe.update_thread_list () == 0, "generation reset update again");
+      check (fe.get_threads_count () == 2,
+             "generation reset threads count again");
+    }
+
+    /**
+     * With a v1.3 header, the threads are enumerated from the flat
+     * table, read in chunks, instead of walking the lists; the
+     * null entries are skipped. While stepping, a thread replaced
+     * by another one, in the same slot, is seen.
+     */
+    void
+    check_threads_table (void)
+    {
+      build_os ();
+      set_header_version (1, 3);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 1);
+
+      constexpr uint32_t threads_count = 70;
+      uint32_t table = ram_alloc ((threads_count + 1) * 4);
+      uint32_t count = ram_alloc (4);
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      ram_write_long (table, main_thread);
+      // An empty slot.
+      ram_write_long (table + 4, 0);
+      uint32_t parent = main_thread;
+      for (uint32_t i = 2; i <= threads_count; ++i)
+        {
+          // Some nested threads.
+          uint32_t th = add_thread ("thread", (i % 10 == 0) ? 0 : parent, 3,
+                                    10, 10, false);
+          if (i % 5 == 0)
+            {
+              parent = th;
+            }
+          ram_write_long (table + i * 4, th);
+        }
+      ram_write_long (count, threads_count + 1);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+
+      backend lists_be;
+      frontend_type lists_fe
+        { lists_be, allocator };
+      check (lists_fe.update_thread_list () == 0, "lists update");
+
+      header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_TABLE_ADDR,
+                         table);
+      header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_THREADS_COUNT_ADDR,
+                         count);
+
+      backend be;
+      frontend_type fe
+        { be, allocator };
+      check (fe.update_thread_list () == 0, "table update");
+      check (be.reads < lists_be.reads, "table update reads");
+
+      // The same threads, in the same order.
+      check (fe.get_threads_count () == threads_count, "table threads count");
+      check (lists_fe.get_threads_count () == threads_count,
+             "lists threads count");
+      bool is_same = true;
+      for (std::size_t i = 0; i < threads_count; ++i)
+        {
+          is_same = is_same
+              && fe.get_thread_id (i) == lists_fe.get_thread_id (i);
+        }
+      check (is_same, "table threads");
+
+      // While stepping, the snapshot is kept if the running thread,
+      // the count and the table entries did not change; the 71
+      // entries are read in two chunks.
+      check (fe.update_thread_list () == 0, "table update again");
+      unsigned int reads = be.reads;
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "table step update");
+      check (be.reads == reads + 4, "table step update reads");
+
+      // A thread exits and another one takes its slot; the count
+      // is the same.
+      uint32_t replaced = ram_read_long (table + 5 * 4);
+      uint32_t created = add_thread ("created", 0, 3, 10, 10, false);
+      ram_write_long (table + 5 * 4, created);
+      reads = be.reads;
+      check (fe.update_thread_list (drtm::update_mode::step) == 0,
+             "table step update after a replace");
+      check (be.reads - reads > 4, "table step update after a replace reads");
+      check (fe.get_threads_count () == threads_count,
+             "table replaced threads count");
+      bool has_created = false;
+      bool has_replaced = false;
+      for (std::size_t i = 0; i < threads_count; ++i)
+        {
+          has_created = has_created || fe.get_thread_id (i) == (created >> 2);
+          has_replaced = has_replaced
+              || fe.get_thread_id (i) == (replaced >> 2);
+        }
+      check (has_created && !has_replaced, "table replaced threads");
+
+      // A corrupted count falls back to the lists.
+      ram_write_long (count, 0x10000);
+      unsigned int errors_count = be.errors_count;
+      check (fe.update_thread_list () == 0, "table fallback update");
+      check (be.errors_count == errors_count + 1, "table fallback error");
+      // The replaced thread is still in the simulated lists.
+      check (fe.get_threads_count () == threads_count + 1,
+             "table fallback threads count");
+    }
+
+    /**
+     * A backend that can wait between the retries.
+     */
+    class delaying_backend : public backend
+    {
+    public:
+
+      void
+      delay_us (uint32_t us)
+      {
+        ++delays_count;
+        last_delay_us = us;
+      }
+
+    public:
+
+      unsigned int delays_count = 0;
+      uint32_t last_delay_us = 0;
+    };
+
+    using delaying_frontend_type = drtm::frontend<delaying_backend,
+    allocator_type>;
+
+    // The simulated writer, changing the threads while they are read.
+    uint32_t sequence_addr;
+    unsigned int changes_left;
+    unsigned int reads_until_change;
+
+    /**
+     * Called before each transaction; every few transactions, while
+     * there are changes left, the target changes the threads, and
+     * increments the sequence counter by 2.
+     */
+    void
+    change_threads (void)
+    {
+      if (changes_left > 0 && --reads_until_change == 0)
+        {
+          ram_write_long (sequence_addr, ram_read_long (sequence_addr) + 2);
+          --changes_left;
+          reads_until_change = 3;
+        }
+    }
+
+    /**
+     * With a v1.4 header, an update that sees the sequence counter
+     * change is read again, after a delay via the backend, up to
+     * `DRTM_CONSISTENT_RETRIES_MAX_COUNT` times; the header is read
+     * again only if the counter cannot be read.
+     */
+    void
+    check_consistent_reads (void)
+    {
+      build_os ();
+      set_header_version (1, 4);
+      header_write_short (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_CORES_COUNT, 1);
+      sequence_addr = ram_alloc (4);
+      header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_SEQUENCE_ADDR,
+                         sequence_addr);
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 127, 127, false);
+      add_thread ("worker", main_thread, 3, 10, 10, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+      delaying_backend be;
+      delaying_frontend_type fe
+        { be, allocator };
+      be.on_read = change_threads;
+
+      const drtm::consistency_statistics_t* st =
+          fe.get_consistency_statistics ();
+
+      changes_left = 0;
+      unsigned int reads = be.reads;
+      check (fe.update_thread_list () == 0, "quiet update");
+      unsigned int quiet_reads = be.reads - reads;
+      check (st->updates_count == 1 && st->retries_count == 0,
+             "quiet update statistics");
+
+      // One change; read again, once.
+      changes_left = 1;
+      reads_until_change = 3;
+      reads = be.reads;
+      unsigned int header_reads = be.header_reads;
+      check (fe.update_thread_list () == 0, "busy update");
+      // Each attempt is a full update, but the header is read once.
+      check (be.reads - reads == 2 * quiet_reads - 1, "busy update reads");
+      check (be.header_reads == header_reads + 1, "busy update header");
+      check (st->updates_count == 2 && st->retries_count == 1
+                 && st->retries_max_count == 1 && st->failures_count == 0,
+             "busy update statistics");
+      check (be.delays_count == 1
+                 && be.last_delay_us == DRTM_CONSISTENT_BACKOFF_MIN_US,
+             "busy update delay");
+      check (fe.get_threads_count () == 2, "busy update threads count");
+
+      // Always changing; published after all retries, with a warning.
+      changes_left = 1000;
+      reads_until_change = 3;
+      unsigned int warnings_count = be.warnings_count;
+      header_reads = be.header_reads;
+      check (fe.update_thread_list () == 0, "always busy update");
+      check (be.header_reads == header_reads + 1, "always busy update header");
+      check (st->updates_count == 3
+                 && st->retries_count == 1 + DRTM_CONSISTENT_RETRIES_MAX_COUNT
+                 && st->retries_max_count == DRTM_CONSISTENT_RETRIES_MAX_COUNT
+                 && st->failures_count == 1,
+             "always busy update statistics");
+      check (be.warnings_count == warnings_count + 1,
+             "always busy update warning");
+      check (be.delays_count == 1 + DRTM_CONSISTENT_RETRIES_MAX_COUNT,
+             "always busy update delays");
+      check (be.last_delay_us <= DRTM_CONSISTENT_BACKOFF_MAX_US,
+             "always busy update backoff");
+
+      // Not checked; the counter is not read.
+      changes_left = 0;
+      fe.reset_consistency_statistics ();
+      fe.consistent_reads (false);
+      reads = be.reads;
+      check (fe.update_thread_list () == 0, "unchecked update");
+      check (be.reads - reads == quiet_reads - 2, "unchecked update reads");
+      check (st->updates_count == 0 && st->retries_count == 0,
+             "unchecked update statistics");
+
+      // The counter cannot be read, the header may be stale; each
+      // retry checks it again.
+      fe.consistent_reads (true);
+      header_write_long (OS_RTOS_DRTM_OFFSETOF_SCHEDULER_SEQUENCE_ADDR,
+                         ram_base - 4);
+      header_reads = be.header_reads;
+      check (fe.update_thread_list () == 0, "unreadable counter update");
+      // The changed header is read twice, before the retries.
+      check (be.header_reads
+                 == header_reads + 2 + DRTM_CONSISTENT_RETRIES_MAX_COUNT,
+             "unreadable counter update header");
+      check (fe.get_threads_count () == 2,
+             "unreadable counter update threads count");
+
+      be.on_read = nullptr;
+    }
+
+    /**
+     * Get the IDs and the descriptions of the threads, ordered
+     * by ID, to compare lists enumerated in different orders.
+     */
+    template<typename Fe>
+      std::size_t
+      sorted_threads (Fe& fe, uint32_t* ids, char (*descriptions)[64],
+                      std::size_t size)
+      {
+        std::size_t count = fe.get_threads_count ();
+        for (std::size_t i = 0; i < count && i < size; ++i)
+          {
+            ids[i] = fe.get_thread_id (i);
+          }
+        std::sort (ids, ids + std::min (count, size));
+        for (std::size_t i = 0; i < count && i < size; ++i)
+          {
+            fe.get_thread_description (ids[i], descriptions[i], 64);
+          }
+        return count;
+      }
+
+    /**
+     * The budgeted updates, split at any number of transactions,
+     * resume where the previous call stopped, and end with the same
+     * threads as a single update; a change of the running thread
+     * restarts them.
+     */
+    void
+    check_budgeted_updates (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 10, 10, false);
+      add_thread ("low", main_thread, 3, 2, 2, true);
+      uint32_t high = add_thread ("high", main_thread, 3, 50, 50, false);
+      add_thread ("mid", high, 3, 20, 20, false);
+      add_thread ("idle", 0, 3, 0, 0, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+
+      backend full_be;
+      frontend_type full_fe
+        { full_be, allocator };
+      check (full_fe.update_thread_list () == 0, "unbudgeted update");
+      check (full_fe.is_thread_list_complete (), "unbudgeted complete");
+
+      uint32_t full_ids[8];
+      char full_descriptions[8][64];
+      std::size_t full_count = sorted_threads (full_fe, full_ids,
+                                               full_descriptions, 8);
+      check (full_count == 5, "unbudgeted threads count");
+
+      uint32_t ids[8];
+      char descriptions[8][64];
+      for (uint32_t transactions = 1; transactions <= 40; ++transactions)
+        {
+          backend be;
+          frontend_type fe
+            { be, allocator };
+          drtm::update_budget_t budget
+            { transactions, 0 };
+
+          std::size_t calls = 0;
+          std::size_t count = 0;
+          bool is_monotonic = true;
+          do
+            {
+              check (fe.update_thread_list (drtm::update_mode::full, budget)
+                         == 0,
+                     "budgeted update");
+              // The current thread is read first.
+              check (fe.get_current_thread_id () == (main_thread >> 2),
+                     "budgeted current thread");
+              is_monotonic = is_monotonic && fe.get_threads_count () >= count;
+              count = fe.get_threads_count ();
+            }
+          while (!fe.is_thread_list_complete () && ++calls < 100);
+
+          check (is_monotonic, "budgeted threads grow");
+          check (calls < 100, "budgeted update ends");
+          check (sorted_threads (fe, ids, descriptions, 8) == full_count,
+                 "budgeted threads count");
+          bool is_same = true;
+          for (std::size_t i = 0; i < full_count; ++i)
+            {
+              is_same = is_same && ids[i] == full_ids[i]
+                  && std::strcmp (descriptions[i], full_descriptions[i]) == 0;
+            }
+          check (is_same, "budgeted threads");
+        }
+
+      // The running thread changes during a budgeted pass.
+      backend be;
+      frontend_type fe
+        { be, allocator };
+      drtm::update_budget_t budget
+        { 8, 0 };
+      check (fe.update_thread_list (drtm::update_mode::full, budget) == 0,
+             "interrupted update");
+      check (!fe.is_thread_list_complete (), "interrupted incomplete");
+
+      ram_write_long (current_thread_addr, high);
+      check (fe.update_thread_list (drtm::update_mode::full, budget) == 0,
+             "restarted update");
+      check (fe.get_current_thread_id () == (high >> 2),
+             "restarted current thread");
+      check (fe.update_thread_list () == 0, "finished update");
+      check (fe.is_thread_list_complete (), "finished complete");
+      check (fe.get_threads_count () == full_count, "finished threads count");
+    }
+
+    /**
+     * With a fixed capacity, the budgeted update keeps the threads
+     * with the highest priorities, even if found last.
+     */
+    void
+    check_budgeted_capacity (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 10, 10, false);
+      for (int i = 0; i < 5; ++i)
+        {
+          add_thread ("low", main_thread, 3, 2, 2, false);
+        }
+      uint32_t high = add_thread ("high", main_thread, 3, 50, 50, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      using fixed_allocator_type = drtm::fixed_capacity_allocator<4, 16>;
+      using fixed_frontend_type = drtm::frontend<backend, fixed_allocator_type>;
+
+      fixed_allocator_type allocator;
+      backend be;
+      fixed_frontend_type fe
+        { be, allocator };
+
+      drtm::update_budget_t budget
+        { 2, 0 };
+      std::size_t calls = 0;
+      do
+        {
+          check (fe.update_thread_list (drtm::update_mode::full, budget) == 0,
+                 "fixed budgeted update");
+        }
+      while (!fe.is_thread_list_complete () && ++calls < 100);
+
+      check (fe.get_threads_count () == 4, "fixed budgeted threads count");
+      check (fe.get_thread_id (0) == (main_thread >> 2),
+             "fixed budgeted running thread");
+      check (fe.get_thread_id (1) == (high >> 2),
+             "fixed budgeted highest priority");
+      check (be.warnings_count == 1, "fixed budgeted too many threads");
+    }
+
+    /**
+     * The streamed IDs, in chunks of any size, are the threads of
+     * a full update, each once, the running thread first; the
+     * stream reads no details, but the streamed threads can be
+     * queried right away, and the update that follows reads them.
+     */
+    void
+    check_streamed_ids (void)
+    {
+      build_os ();
+
+      uint32_t main_thread = add_thread ("main", 0, 2, 10, 10, false);
+      add_thread ("low", main_thread, 3, 2, 2, true);
+      uint32_t high = add_thread ("high", main_thread, 3, 50, 50, false);
+      add_thread ("mid", high, 3, 20, 20, false);
+      add_thread ("idle", 0, 3, 0, 0, false);
+      ram_write_long (current_thread_addr, main_thread);
+
+      allocator_type allocator;
+
+      backend full_be;
+      frontend_type full_fe
+        { full_be, allocator };
+      check (full_fe.update_thread_list () == 0, "full update");
+
+      uint32_t full_ids[8];
+      char full_descriptions[8][64];
+      std::size_t full_count = sorted_threads (full_fe, full_ids,
+                                               full_descriptions, 8);
+      check (full_count == 5, "full threads count");
+
+      uint32_t ids[8];
+      char descriptions[8][64];
+      for (std::size_t chunk = 1; chunk <= 6; ++chunk)
+        {
+          backend be;
+          frontend_type fe
+            { be, allocator };
+
+          fe.begin_thread_enumeration ();
+          check (be.reads == 0, "begin without reads");
+
+          uint32_t streamed[16];
+          std::size_t streamed_count = 0;
+          std::size_t calls = 0;
+          int count;
+          while ((count = fe.next_thread_ids (&streamed[streamed_count],
+                                              chunk)) > 0 && ++calls < 16)
+            {
+              check (static_cast<std::size_t> (count) <= chunk,
+                     "streamed chunk size");
+              streamed_count += static_cast<std::size_t> (count);
+              if (streamed_count + chunk > 16)
+                {
+                  break;
+                }
+            }
+          check (count == 0, "stream ends");
+          // The details are still to be read.
+          check (!fe.is_thread_list_complete (), "streamed incomplete");
+          check (streamed_count == full_count, "streamed count");
+          check (streamed[0] == (main_thread >> 2), "streamed running first");
+
+          // No details were read, only the nodes of the lists.
+          check (be.reads < full_be.reads, "streamed reads");
+          check (fe.next_thread_ids (streamed, chunk) == 0,
+                 "stream stays ended");
+
+          // The streamed threads are published, and can be queried
+          // before the update; only the running thread is read.
+          check (fe.get_threads_count () == streamed_count,
+                 "streamed threads published");
+          unsigned int reads = be.reads;
+          for (std::size_t i = 1; i < streamed_count; ++i)
+            {
+              char buf[256];
+              std::strcpy (buf, "x");
+              check (fe.get_thread_registers (streamed[i], buf, sizeof(buf))
+                         < 0 && buf[0] == '\0',
+                     "streamed registers");
+              std::strcpy (buf, "x");
+              check (fe.get_thread_register (streamed[i], 15, buf,
+                                             sizeof(buf)) < 0
+                         && buf[0] == '\0',
+                     "streamed register");
+              fe.get_thread_description (streamed[i], buf, sizeof(buf));
+              check (std::strcmp (buf, "none") == 0, "streamed description");
+            }
+          char main_description[64];
+          fe.get_thread_description (streamed[0], main_description,
+                                     sizeof(main_description));
+          check (std::strncmp (main_description, "main [", 6) == 0,
+                 "streamed running description");
+          check (be.reads == reads, "streamed queries without reads");
+
+          std::sort (streamed, streamed + streamed_count);
+          bool is_same = std::adjacent_find (streamed,
+                                             streamed + streamed_count)
+              == streamed + streamed_count;
+          for (std::size_t i = 0; i < full_count && i < streamed_count; ++i)
+            {
+              is_same = is_same && streamed[i] == full_ids[i];
+            }
+          check (is_same, "streamed ids");
+
+          // The update continues with the threads found.
+          check (fe.update_thread_list () == 0, "update after stream");
+          // The nodes already read are not read again.
+          check (be.reads <= full_be.reads, "update after stream reads");
+          check (fe.is_thread_list_complete (), "update after stream complete");
+          check (sorted_threads (fe, ids, descriptions, 8) == full_count,
+                 "update after stream count");
+          is_same = true;
+          for (std::size_t i = 0; i < full_count; ++i)
+            {
+              is_same = is_same && ids[i] == full_ids[i]
+                  && std::strcmp (descriptions[i], full_descriptions[i]) == 0;
+            }
+          check (is_same, "update after stream threads");
+
+          // The registers are now read.
+          char registers[256];
+          char full_registers[256];
+          is_same = true;
+          for (std::size_t i = 0; i < full_count; ++i)
+            {
+              if (ids[i] == (main_thread >> 2))
+                {
+                  continue;
+                }
+              is_same = is_same
+                  && fe.get_thread_registers (ids[i], registers,
+                                              sizeof(registers)) == 0
+                  && full_fe.get_thread_registers (ids[i], full_registers,
+                                                   sizeof(full_registers))
+                      == 0 && std::strcmp (registers, full_registers) == 0;
+            }
+          check (is_same, "update after stream registers");
+        }
+    }
+  }
+
+  void
+  check_updates (void)
+  {
+    check_step_mode ();
+    check_generation ();
+    check_threads_table ();
+    check_consistent_reads ();
+    check_budgeted_updates ();
+    check_budgeted_capacity ();
+    check_streamed_ids ();
+  }
+
+} /* namespace sim */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,210 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Check that a frontend with a fixed capacity allocator, as used
+ * in the firmware of a debug probe, builds with `-fno-exceptions
+ * -fno-rtti`, and that, when the target cannot be read, all
+ * functions fail without throwing.
+ */
+
+#if defined(__EXCEPTIONS) || defined(__GXX_RTTI)
+#error "This test must be compiled with -fno-exceptions -fno-rtti"
+#endif
+
+#include <stdio.h>
+
+#include <drtm/drtm.h>
+
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * A backend without a target; all reads fail.
+   */
+  class backend
+  {
+  public:
+
+    using target_addr_t = uint32_t;
+    using thread_id_t = uint32_t;
+
+  public:
+
+    target_addr_t
+    get_symbol_address (const char* name __attribute__((unused)))
+    {
+      return 0x20000000;
+    }
+
+    int
+    output (const char* fmt, ...)
+    {
+      va_list args;
+      va_start(args, fmt);
+      int ret = vprintf (fmt, args);
+      va_end(args);
+      return ret;
+    }
+
+    int
+    output_warning (const char* fmt, ...)
+    {
+      printf ("WARNING: ");
+      va_list args;
+      va_start(args, fmt);
+      int ret = vprintf (fmt, args);
+      va_end(args);
+      return ret;
+    }
+
+    int
+    output_error (const char* fmt, ...)
+    {
+      printf ("ERROR: ");
+      va_list args;
+      va_start(args, fmt);
+      int ret = vprintf (fmt, args);
+      va_end(args);
+      return ret;
+    }
+
+    int
+    read_byte_array (target_addr_t addr __attribute__((unused)),
+                     uint8_t* out_array, std::size_t bytes)
+    {
+      ++reads;
+      // Like a probe that could not access the memory.
+      std::memset (out_array, 0, bytes);
+      return -1;
+    }
+
+    int
+    read_byte (target_addr_t addr, uint8_t* out_value)
+    {
+      return read_byte_array (addr, out_value, 1);
+    }
+
+    int
+    read_long (target_addr_t addr, uint32_t* out_value)
+    {
+      return read_byte_array (addr, reinterpret_cast<uint8_t*> (out_value),
+                              4);
+    }
+
+    uint16_t
+    load_short (const uint8_t* p)
+    {
+      return static_cast<uint16_t> (p[0] | (p[1] << 8));
+    }
+
+    uint32_t
+    load_long (const uint8_t* p)
+    {
+      return static_cast<uint32_t> (p[0] | (p[1] << 8) | (p[2] << 16)
+          | (p[3] << 24));
+    }
+
+  public:
+
+    unsigned int reads = 0;
+  };
+
+#pragma GCC diagnostic pop
+
+  using allocator_type = drtm::fixed_capacity_allocator<4, 16>;
+  using frontend_type = drtm::frontend<backend, allocator_type>;
+
+  // Static, like in the probe firmware.
+  backend target_backend;
+  allocator_type allocator;
+  frontend_type frontend
+    { target_backend, allocator };
+
+  int errors;
+
+  void
+  check (bool condition, const char* what)
+  {
+    if (!condition)
+      {
+        printf ("FAILED: %s\n", what);
+        ++errors;
+      }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+int
+main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("DRTM library, fixed capacity without exceptions test\n");
+
+  check (frontend.update_thread_list () < 0, "update fails");
+  check (
+      frontend.update_thread_list (drtm::update_mode::step,
+                                   drtm::update_budget_t
+                                     { 10, 0 })
+          < 0,
+      "budgeted update fails");
+
+  frontend_type::thread_id_t ids[4];
+  frontend.begin_thread_enumeration ();
+  check (frontend.next_thread_ids (ids, 4) < 0, "enumeration fails");
+
+  check (frontend.get_threads_count () == 0, "no threads");
+  check (frontend.get_current_thread_id () == 0, "no current thread");
+
+  char buf[200];
+  check (frontend.get_thread_description (1, buf, sizeof(buf)) > 0,
+         "default description");
+  check (frontend.get_thread_registers (1, buf, sizeof(buf)) != 0,
+         "no registers");
+  check (frontend.get_thread_register (1, 0, buf, sizeof(buf)) != 0,
+         "no register");
+
+  check (target_backend.reads > 0, "target accessed");
+
+  if (errors != 0)
+    {
+      printf ("%d errors.\n", errors);
+      return 1;
+    }
+
+  printf ("Done.\n");
+  return 0;
+}
@@ -27,10 +27,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <your-application.h>
 #include <drtm/drtm.h>
 
+static int
+check_sessions (void);
+
 int
 main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
 {
@@ -63,10 +67,284 @@ main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
 
 #endif
 
+  int errors = check_sessions ();
+  if (errors != 0)
+    {
+      printf ("%d errors.\n", errors);
+      return 1;
+    }
+
   printf ("Done.\n");
   return 0;
 }
 
+// ----------------------------------------------------------------------------
+// A target simulated in memory, with two threads, used via the
+// handle based API, from two sessions.
+
+#define SIM_RAM_BASE 0x20000000
+#define SIM_RAM_SIZE 0x1000
+
+#define SIM_DRTM_ADDR (SIM_RAM_BASE + 0x100)
+#define SIM_IS_STARTED_ADDR (SIM_RAM_BASE + 0x180)
+#define SIM_TOP_THREADS_LIST_ADDR (SIM_RAM_BASE + 0x188)
+#define SIM_CURRENT_THREAD_ADDR (SIM_RAM_BASE + 0x190)
+
+// The thread control blocks, with the stacks above them.
+#define SIM_TCB_ADDR(n) (SIM_RAM_BASE + 0x200 + (n) * 0x200)
+#define SIM_TCB_NAME_OFFSET 0x08
+#define SIM_TCB_PARENT_OFFSET 0x10
+#define SIM_TCB_LIST_NODE_OFFSET 0x14
+#define SIM_TCB_CHILDREN_NODE_OFFSET 0x1C
+#define SIM_TCB_STATE_OFFSET 0x24
+#define SIM_TCB_STACK_OFFSET 0x28
+#define SIM_TCB_PRIO_ASSIGNED_OFFSET 0x2C
+#define SIM_TCB_PRIO_INHERITED_OFFSET 0x2D
+
+static uint8_t sim_ram[SIM_RAM_SIZE];
+
+typedef struct sim_session_s
+{
+  unsigned int reads;
+  unsigned int allocations;
+  unsigned int deallocations;
+} sim_session_t;
+
+static void
+sim_write_long (uint32_t addr, uint32_t value)
+{
+  uint8_t* p = &sim_ram[addr - SIM_RAM_BASE];
+  p[0] = (uint8_t) value;
+  p[1] = (uint8_t) (value >> 8);
+  p[2] = (uint8_t) (value >> 16);
+  p[3] = (uint8_t) (value >> 24);
+}
+
+static void
+sim_write_short (uint32_t addr, uint16_t value)
+{
+  uint8_t* p = &sim_ram[addr - SIM_RAM_BASE];
+  p[0] = (uint8_t) value;
+  p[1] = (uint8_t) (value >> 8);
+}
+
+static void
+sim_add_thread (size_t n, const char* name, uint8_t state, uint32_t pc)
+{
+  uint32_t tcb = SIM_TCB_ADDR(n);
+  uint32_t name_addr = tcb + 0x40;
+  uint32_t stack = tcb + 0x80;
+
+  memcpy (&sim_ram[name_addr - SIM_RAM_BASE], name, strlen (name) + 1);
+  sim_write_long (tcb + SIM_TCB_NAME_OFFSET, name_addr);
+  sim_write_long (tcb + SIM_TCB_PARENT_OFFSET, 0);
+  sim_write_long (tcb + SIM_TCB_CHILDREN_NODE_OFFSET,
+                  tcb + SIM_TCB_CHILDREN_NODE_OFFSET);
+  sim_write_long (tcb + SIM_TCB_CHILDREN_NODE_OFFSET + 4,
+                  tcb + SIM_TCB_CHILDREN_NODE_OFFSET);
+  sim_ram[tcb + SIM_TCB_STATE_OFFSET - SIM_RAM_BASE] = state;
+  sim_ram[tcb + SIM_TCB_PRIO_ASSIGNED_OFFSET - SIM_RAM_BASE] = 10;
+  sim_ram[tcb + SIM_TCB_PRIO_INHERITED_OFFSET - SIM_RAM_BASE] = 10;
+
+  // A basic frame, with EXC_RETURN in the 9th word and PC in the 16th.
+  sim_write_long (stack + 8 * 4, 0xFFFFFFFD);
+  sim_write_long (stack + 15 * 4, pc);
+  sim_write_long (tcb + SIM_TCB_STACK_OFFSET, stack);
+
+  // Add it at the end of the top list.
+  uint32_t head = SIM_TOP_THREADS_LIST_ADDR;
+  uint32_t node = tcb + SIM_TCB_LIST_NODE_OFFSET;
+  uint8_t* p = &sim_ram[head - SIM_RAM_BASE];
+  uint32_t last = (uint32_t) (p[0] | (p[1] << 8) | (p[2] << 16)
+      | ((uint32_t) p[3] << 24));
+  sim_write_long (node, last);
+  sim_write_long (node + 4, head);
+  sim_write_long (last + 4, node);
+  sim_write_long (head, node);
+}
+
+static void
+sim_build (void)
+{
+  memset (sim_ram, 0, sizeof(sim_ram));
+
+  // A v0.1.0 header; the offsets are those of the v0 layout.
+  memcpy (&sim_ram[SIM_DRTM_ADDR - SIM_RAM_BASE], "DRTMv\x00\x01\x00", 8);
+  sim_write_long (SIM_DRTM_ADDR + 0x08, SIM_IS_STARTED_ADDR);
+  sim_write_long (SIM_DRTM_ADDR + 0x0C, SIM_TOP_THREADS_LIST_ADDR);
+  sim_write_long (SIM_DRTM_ADDR + 0x10, SIM_CURRENT_THREAD_ADDR);
+  sim_write_short (SIM_DRTM_ADDR + 0x14, SIM_TCB_NAME_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x16, SIM_TCB_PARENT_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x18, SIM_TCB_LIST_NODE_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x1A, SIM_TCB_CHILDREN_NODE_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x1C, SIM_TCB_STATE_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x1E, SIM_TCB_STACK_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x20, SIM_TCB_PRIO_ASSIGNED_OFFSET);
+  sim_write_short (SIM_DRTM_ADDR + 0x22, SIM_TCB_PRIO_INHERITED_OFFSET);
+
+  sim_ram[SIM_IS_STARTED_ADDR - SIM_RAM_BASE] = 1;
+  sim_write_long (SIM_TOP_THREADS_LIST_ADDR, SIM_TOP_THREADS_LIST_ADDR);
+  sim_write_long (SIM_TOP_THREADS_LIST_ADDR + 4, SIM_TOP_THREADS_LIST_ADDR);
+
+  sim_add_thread (0, "main", 2, 0x08000100);
+  sim_add_thread (1, "worker", 3, 0x08000200);
+  sim_write_long (SIM_CURRENT_THREAD_ADDR, SIM_TCB_ADDR(0));
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+static drtm_target_addr_t
+sim_get_symbol_address (void* user_data, const char* name)
+{
+  return (strcmp (name, DRTM_SYMBOL_NAME) == 0) ? SIM_DRTM_ADDR : 0;
+}
+
+static int
+sim_read_byte_array (void* user_data, drtm_target_addr_t addr,
+                     uint8_t* out_array, size_t bytes)
+{
+  ((sim_session_t*) user_data)->reads++;
+  if (addr < SIM_RAM_BASE || addr + bytes > SIM_RAM_BASE + SIM_RAM_SIZE)
+    {
+      return -1;
+    }
+  memcpy (out_array, &sim_ram[addr - SIM_RAM_BASE], bytes);
+  return 0;
+}
+
+static int
+sim_write_byte_array (void* user_data, drtm_target_addr_t addr,
+                      const uint8_t* array, size_t bytes)
+{
+  return -1;
+}
+
+static int
+sim_voutput (void* user_data, const char* fmt, va_list args)
+{
+  return vprintf (fmt, args);
+}
+
+static void*
+sim_malloc (void* user_data, size_t bytes)
+{
+  ((sim_session_t*) user_data)->allocations++;
+  return malloc (bytes);
+}
+
+static void
+sim_free (void* user_data, void* p)
+{
+  ((sim_session_t*) user_data)->deallocations++;
+  free (p);
+}
+
+#pragma GCC diagnostic pop
+
+/*
+ * Two sessions on the same target, each with its own user data;
+ * the contexts are independent, and all the memory of a session
+ * is returned when it is destroyed.
+ */
+static int
+check_sessions (void)
+{
+  int errors = 0;
+
+  sim_build ();
+
+  sim_session_t sessions[2];
+  drtm_ops_t ops[2];
+  drtm_context_t* ctx[2];
+
+  for (size_t i = 0; i < 2; ++i)
+    {
+      memset (&sessions[i], 0, sizeof(sessions[i]));
+      memset (&ops[i], 0, sizeof(ops[i]));
+      ops[i].user_data = &sessions[i];
+      ops[i].get_symbol_address = sim_get_symbol_address;
+      ops[i].read_byte_array = sim_read_byte_array;
+      ops[i].write_byte_array = sim_write_byte_array;
+      ops[i].voutput = sim_voutput;
+      ops[i].voutput_warning = sim_voutput;
+      ops[i].voutput_error = sim_voutput;
+      ops[i].malloc = sim_malloc;
+      ops[i].free = sim_free;
+
+      ctx[i] = drtm_create (&ops[i]);
+      if (ctx[i] == NULL)
+        {
+          printf ("FAILED: session %zu create\n", i);
+          return errors + 1;
+        }
+    }
+
+  if (drtm_ctx_update_thread_list (ctx[0]) != 0
+      || drtm_ctx_get_threads_count (ctx[0]) != 2)
+    {
+      printf ("FAILED: session 0 threads\n");
+      ++errors;
+    }
+  // Only the first session read the target.
+  if (sessions[0].reads == 0 || sessions[1].reads != 0)
+    {
+      printf ("FAILED: session reads\n");
+      ++errors;
+    }
+
+  if (drtm_ctx_update_thread_list (ctx[1]) != 0
+      || drtm_ctx_get_threads_count (ctx[1]) != 2
+      || drtm_ctx_get_current_thread_id (ctx[1]) != (SIM_TCB_ADDR(0) >> 2))
+    {
+      printf ("FAILED: session 1 threads\n");
+      ++errors;
+    }
+
+  drtm_thread_id_t worker = SIM_TCB_ADDR(1) >> 2;
+  char buf[256];
+  drtm_ctx_get_thread_description (ctx[0], worker, buf, sizeof(buf));
+  if (strncmp (buf, "worker", 6) != 0)
+    {
+      printf ("FAILED: session 0 description '%s'\n", buf);
+      ++errors;
+    }
+
+  // The PC, in target order.
+  if (drtm_ctx_get_thread_register (ctx[1], worker, 15, buf, sizeof(buf)) != 0
+      || strcmp (buf, "00020008") != 0)
+    {
+      printf ("FAILED: session 1 register\n");
+      ++errors;
+    }
+
+  drtm_destroy (ctx[0]);
+  if (sessions[0].allocations == 0
+      || sessions[0].allocations != sessions[0].deallocations)
+    {
+      printf ("FAILED: session 0 memory\n");
+      ++errors;
+    }
+
+  // The other session is not affected.
+  if (drtm_ctx_update_thread_list (ctx[1]) != 0
+      || drtm_ctx_get_threads_count (ctx[1]) != 2)
+    {
+      printf ("FAILED: session 1 after session 0 destroyed\n");
+      ++errors;
+    }
+
+  drtm_destroy (ctx[1]);
+  if (sessions[1].allocations != sessions[1].deallocations)
+    {
+      printf ("FAILED: session 1 memory\n");
+      ++errors;
+    }
+
+  return errors;
+}
+
 // ----------------------------------------------------------------------------
 // (yapp stands for your-application; update it accordingly)
 